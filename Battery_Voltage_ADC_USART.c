@@ -1,60 +1,363 @@
 /*
 
 Name:			Thomas Creel
-Description:	print the raw CdS cell data to be used with serialplot
-				if press 'C' then poll Cds
-				if press 'J' then poll J3 header
+Description:	print the raw CdS cell data
+				if press 'C' then send the CdS cell
+				if press 'J' then send the J3 header
+				if press 'A' then send all four adc channels
+				if press '0' to '4' then oversample by 4^n
+				if press 'B', 'I' or 'M' then decimate through a
+				boxcar, a CIC or a boxcar plus moving average
+				if press '+' or '-' then double or halve the sweep rate
+				if press 'S' then toggle between results and statistics
+				if press '[' or ']' then halve or double the statistics
+				window
+				if press 'G' then toggle gain auto-ranging
+				if press 'T' then arm a scope capture of J3 (again to
+				cancel), 'E' to switch between a rising and a falling
+				edge trigger, '<' or '>' to move the trigger level
+
+				the four adc channels are converted together in one
+				sweep on every TCC0 overflow (ADC_SAMPLE_HZ): CH0 the
+				CdS cell, CH1 the J3 header, CH2 and CH3 the spare
+				inputs. DMA CH0 and CH1 move each sweep into one of two
+				alternating blocks of ADC_BLOCK_SWEEPS sweeps, so the cpu
+				only sees one interrupt per block.
+
+				each block then goes through the oversample and
+				decimate stage (IMU_SPI_USART/decimate.h): every 4^n
+				sweeps give one result with n more bits, so results
+				come out at the sweep rate / 4^n. n is 0, i.e. every
+				sweep is sent, until changed.
+
+				the results of each block for the selected input are
+				sent as a FRAME_TYPE_ADC_SAMPLE frame (see
+				IMU_SPI_USART/frame.h) holding little-endian int16
+				values, or with 'A' as a FRAME_TYPE_ADC_SWEEP frame
+				holding all four channels.
+
+				a block that is still waiting when dma comes round to
+				it again, because the link could not carry the results
+				that fast, is dropped whole, not sent half overwritten.
+				the number of blocks dropped goes out in a
+				FRAME_TYPE_ADC_LOST frame before the next results, and
+				the decimators restart after the gap
+
+				in statistics mode, min, max, sum and sum of squares of
+				every channel's results are kept instead, and one
+				FRAME_TYPE_ADC_STATS frame per window of stats_window
+				results (ADC_STATS_WINDOW at start up) sends them for
+				the selected input, or for all four with 'A'. the host
+				derives mean and rms; the link carries a window's worth
+				of results in one 20 or 68 byte record, so sweeps can
+				run much faster than raw results could be sent.
+
+				with auto-ranging, the gain of the CdS and J3 channels
+				follows the peak magnitude of their results, block by
+				block: one step down (of 1x, 2x, .. 64x) once a peak
+				passes AUTORANGE_HIGH, two if the adc clipped, and one
+				step up while peaks stay under AUTORANGE_LOW, far
+				enough below half of AUTORANGE_HIGH not to oscillate.
+				a new gain is written to the channel by the dma
+				interrupt as a block completes, so every block is
+				converted at one gain, which it is tagged with; the
+				offset measured at that gain is removed. results are
+				then in 1/16 LSB of the amplified input and are sent as
+				FRAME_TYPE_ADC_RANGED frames carrying the gains, or in
+				statistics mode rounded back to 1/16 LSB at 1x. a gain
+				change restarts the oversampling.
+
+				a scope capture stops the sweeps and runs the adc free
+				on J3 at ADC_SCOPE_CLK_HZ, with CH0 and CH1 both on it:
+				DMA CH2 keeps a ring of the last ADC_SCOPE_RING CH1
+				results, and CH0's compare logic (CMP, above / below
+				interrupt) watches for the trigger edge, first for the
+				signal to be on the far side of the level, then for it
+				to cross. ADC_SCOPE_POST results after the trigger the
+				ring is frozen, and ADC_SCOPE_PRE results before the
+				trigger plus the ADC_SCOPE_POST after it go out in one
+				FRAME_TYPE_ADC_SCOPE frame, with the sample rate
+				measured on TCC0. the trigger position is good to the
+				few samples the interrupt takes to answer. sweeps then
+				start again.
+
+				build together with
+				IMU_SPI_USART/frame.c, IMU_SPI_USART/usart.c,
+				IMU_SPI_USART/decimate.c and IMU_SPI_USART/clock.c; the
+				clock and baud rate come from F_CPU and USART_BAUD
+				(see clock.h and usart.h). 'A' at 1 kHz needs 8 kB/s,
+				about the most 115200 baud carries
+
+				the adc is calibrated at start up: the factory
+				calibration from the production signature row goes into
+				ADCA.CAL, and the offset of each differential channel is
+				measured with its inputs shorted. every result sent is
+				corrected in fixed point, (result - offset) * gain, the
+				gain being a Q15 trim per channel (ADC_GAIN_CHn, 32768 =
+				1). results are in 1/16 LSB whatever the oversampling,
+				so the host always scales by 2.5 V / (2048 * 16)
 								
 */ 
 #include <avr/io.h>
 #include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "IMU_SPI_USART/clock.h"
+#include "IMU_SPI_USART/usart.h"
+#include "IMU_SPI_USART/frame.h"
+#include "IMU_SPI_USART/decimate.h"
+
+// adc clock, kept at the 500 kHz it ran at from the 2 MHz oscillator
+#define ADC_CLK_HZ	500000UL
+
+#if F_CPU / 4 <= ADC_CLK_HZ
+#define ADC_PRESCALER	ADC_PRESCALER_DIV4_gc
+#elif F_CPU / 16 <= ADC_CLK_HZ
+#define ADC_PRESCALER	ADC_PRESCALER_DIV16_gc
+#elif F_CPU / 64 <= ADC_CLK_HZ
+#define ADC_PRESCALER	ADC_PRESCALER_DIV64_gc
+#else
+#define ADC_PRESCALER	ADC_PRESCALER_DIV256_gc
+#endif
+
+// sweeps per second at start up, one per TCC0 overflow
+#ifndef ADC_SAMPLE_HZ
+#define ADC_SAMPLE_HZ	1000UL
+#endif
+
+// sweep rates '+' and '-' can reach: the slowest TCC0 allows, and what
+// the adc and the block interrupts keep up with
+#define ADC_SAMPLE_HZ_MIN	(F_CPU / 8 / 0x10000 + 1)
+#define ADC_SAMPLE_HZ_MAX	16000UL
+
+// sweeps per dma block, i.e. per interrupt and per frame sent
+#ifndef ADC_BLOCK_SWEEPS
+#define ADC_BLOCK_SWEEPS	16
+#endif
+
+// TCC0 runs from the peripheral clock / 8
+#define ADC_TIMER_HZ	(F_CPU / 8)
+
+#if ADC_SAMPLE_HZ < ADC_SAMPLE_HZ_MIN || ADC_SAMPLE_HZ > ADC_SAMPLE_HZ_MAX
+#error "ADC_SAMPLE_HZ out of range for TCC0 at this F_CPU"
+#endif
+
+// the block loops and adc_out_rows count sweeps in a uint8_t
+#if ADC_BLOCK_SWEEPS < 1 || ADC_BLOCK_SWEEPS > 255
+#error "ADC_BLOCK_SWEEPS out of range"
+#endif
+
+// spare inputs, single ended (signed mode, so 0 V reads 0)
+#ifndef ADC_SPARE2_MUX
+#define ADC_SPARE2_MUX	ADC_CH_MUXPOS_PIN2_gc
+#endif
+
+#ifndef ADC_SPARE3_MUX
+#define ADC_SPARE3_MUX	ADC_CH_MUXPOS_PIN3_gc
+#endif
+
+// gain trims, Q15 (32768 = 1, must stay below 2)
+#ifndef ADC_GAIN_CH0
+#define ADC_GAIN_CH0	32768U
+#endif
 
-#define BSEL     (5)
-#define BSCALE   (-6)
+#ifndef ADC_GAIN_CH1
+#define ADC_GAIN_CH1	32768U
+#endif
+
+#ifndef ADC_GAIN_CH2
+#define ADC_GAIN_CH2	32768U
+#endif
+
+#ifndef ADC_GAIN_CH3
+#define ADC_GAIN_CH3	32768U
+#endif
+
+// conversions summed for an offset, giving it in 1/16 LSB
+#define ADC_OFFSET_SAMPLES	16
+
+// results per statistics window at start up, and the range '[' and ']'
+// can reach (the sums fit for up to 65535 results)
+#ifndef ADC_STATS_WINDOW
+#define ADC_STATS_WINDOW	1000U
+#endif
+
+#define ADC_STATS_WINDOW_MIN	2U
+#define ADC_STATS_WINDOW_MAX	32768U
+
+// scope capture: adc clock (the most the adc is specified for),
+// results kept before and after the trigger, and slack for the main
+// loop to notice the post-trigger results are in
+#define ADC_SCOPE_CLK_HZ	2000000UL
+
+#if F_CPU / 4 <= ADC_SCOPE_CLK_HZ
+#define ADC_SCOPE_PRESCALER	ADC_PRESCALER_DIV4_gc
+#else
+#define ADC_SCOPE_PRESCALER	ADC_PRESCALER_DIV16_gc
+#endif
+
+#ifndef ADC_SCOPE_PRE
+#define ADC_SCOPE_PRE		256
+#endif
+
+#ifndef ADC_SCOPE_POST
+#define ADC_SCOPE_POST		512
+#endif
+
+#define ADC_SCOPE_SLACK		64
+#define ADC_SCOPE_RING		(ADC_SCOPE_PRE + ADC_SCOPE_POST + ADC_SCOPE_SLACK)
+
+#if ADC_SCOPE_PRE < 1 || ADC_SCOPE_POST < 1 || ADC_SCOPE_RING > 2048
+#error "ADC_SCOPE_PRE / ADC_SCOPE_POST out of range"
+#endif
+
+// trigger level at start up in adc LSB (12-bit signed, as CMP takes
+// it), and the step of '<' and '>'
+#ifndef ADC_SCOPE_LEVEL
+#define ADC_SCOPE_LEVEL		512
+#endif
+
+#define ADC_SCOPE_LEVEL_STEP	64
+
+// scope states
+#define SCOPE_OFF			0
+#define SCOPE_FILLING		1	// collecting the pre-trigger results
+#define SCOPE_ARMED			2	// waiting for the far side of the level
+#define SCOPE_EDGE			3	// waiting for the crossing
+#define SCOPE_TRIGGERED		4	// collecting the post-trigger results
+
+// auto-ranging thresholds on the peak magnitude of a block, in adc
+// LSB: above HIGH the gain goes down, below LOW it goes up
+#define AUTORANGE_HIGH		1792
+#define AUTORANGE_LOW		768
+#define AUTORANGE_CLIP		2040
+
+// gain settings of a channel with gain, 1x to 64x (as log2)
+#define GAIN_STEPS			7
+
+// adc channels in a sweep, and which one holds each input
+#define ADC_CHANNELS	4
+#define ADC_CH_CDS		0
+#define ADC_CH_J3		1
+
+// the channels with gain, auto-ranged: CH0 and CH1
+#define ADC_GAIN_CHANNELS	2
+
+// what the main loop sends
+#define SEND_ALL		0xFF
 
 // global variables
-volatile uint8_t conversion_flag = 0;
-volatile uint8_t input_flag = 0;
-volatile int16_t result = 0;
-volatile float voltage = 0.0;
-volatile uint8_t data = 0;
 
-void usartd0_init(void)
-{
-  /* Configure relevant TxD and RxD pins. */
-	PORTD.OUTSET = PIN3_bm;
-	PORTD.DIRSET = PIN3_bm;
-	PORTD.DIRCLR = PIN2_bm;
+// the two dma blocks, sweep by sweep: CH0..CH3 results
+int16_t adc_block[2][ADC_BLOCK_SWEEPS][ADC_CHANNELS];
 
-  /* Configure baud rate. */
-	USARTD0.BAUDCTRLA = (uint8_t)BSEL;
-	USARTD0.BAUDCTRLB = (uint8_t)((BSCALE << 4)|(BSEL >> 8));
+// bit n set when block n is full and not yet sent
+volatile uint8_t block_ready = 0;
 
-  /* Configure remainder of serial protocol. */
-  /* (In this example, a protocol with 8 data bits, no parity, and
-   *  one stop bit is chosen.) */
-	USARTD0.CTRLC =	(USART_CMODE_ASYNCHRONOUS_gc |
-					 USART_PMODE_DISABLED_gc  	 |
-					 USART_CHSIZE_8BIT_gc)       &
-					~USART_SBMODE_bm;
+// the block to send next; they fill alternately, and the dma interrupts
+// move it on past a block they drop
+volatile uint8_t block_next = 0;
 
-  /* Enable receiver and/or transmitter systems. */
-	USARTD0.CTRLB = USART_RXEN_bm | USART_TXEN_bm;
+// blocks dropped by the dma interrupts (wraps), and the count the last
+// FRAME_TYPE_ADC_LOST frame was sent at
+volatile uint8_t blocks_lost = 0;
+uint8_t blocks_lost_sent = 0;
 
-  /* Enable interrupt as medium level. */
-	USARTD0.CTRLA = USART_RXCINTLVL_MED_gc; 
-}
+// adc channel sent, or SEND_ALL
+uint8_t send_channel = ADC_CH_CDS;
+
+// per channel calibration, measured offset (1/16 LSB) at each gain
+// setting and gain trim
+int16_t adc_offset[ADC_CHANNELS][GAIN_STEPS];
+const uint16_t adc_gain[ADC_CHANNELS] = {ADC_GAIN_CH0, ADC_GAIN_CH1, ADC_GAIN_CH2, ADC_GAIN_CH3};
+
+// oversampling, 4^os_bits sweeps per result through os_filter, and
+// one decimator per channel
+uint8_t os_bits = 0;
+uint8_t os_filter = DECIMATE_BOXCAR;
+decimate_t adc_dec[ADC_CHANNELS];
+
+// results of the last block, decimated and calibrated
+int16_t adc_out[ADC_BLOCK_SWEEPS][ADC_CHANNELS];
+uint8_t adc_out_rows = 0;
+
+uint16_t sweep_hz = ADC_SAMPLE_HZ;
 
+// auto-ranging: gain (log2) asked for per channel, the gain each block
+// was converted at, and the gain the decimators are running at
+uint8_t autorange = 0;
+uint8_t gain_set[ADC_CHANNELS];
+volatile uint8_t block_gain[2][ADC_CHANNELS];
+uint8_t dec_gain[ADC_CHANNELS];
+
+// scope capture: the ring filled by dma CH2, the trigger settings, and
+// where in the ring and when (TCC0 count) the trigger happened
+int16_t scope_ring[ADC_SCOPE_RING];
+volatile uint8_t scope_state = SCOPE_OFF;
+uint8_t scope_rising = 1;
+int16_t scope_level = ADC_SCOPE_LEVEL;
+volatile uint16_t scope_trig_pos;
+volatile uint16_t scope_trig_ticks;
+
+// statistics mode: running aggregates of the results of every channel
+// over the current window
+uint8_t stats_mode = 0;
+uint16_t stats_window = ADC_STATS_WINDOW;
+uint16_t stats_count = 0;
+int16_t stats_min[ADC_CHANNELS];
+int16_t stats_max[ADC_CHANNELS];
+int32_t stats_sum[ADC_CHANNELS];
+uint64_t stats_sum_sq[ADC_CHANNELS];
+
+// loads the 24-bit source or destination address of a dma channel
+void dma_addr(volatile uint8_t * reg, const volatile void * addr)
+{
+	reg[0] = (uint8_t)((uintptr_t)addr);
+	reg[1] = (uint8_t)((uintptr_t)addr >> 8);
+	reg[2] = (uint8_t)(((uint32_t)((uintptr_t)addr)) >> 16);
+}
 
-void usartd0_out_char(char c)
+// reads a byte of the production signature row
+uint8_t read_calibration_byte(uint8_t index)
 {
-	while(!(USARTD0.STATUS & USART_DREIF_bm));
-	USARTD0.DATA = c;
+	uint8_t result;
+	
+	NVM.CMD = NVM_CMD_READ_CALIB_ROW_gc;
+	result = pgm_read_byte(index);
+	NVM.CMD = NVM_CMD_NO_OPERATION_gc;
+	
+	return result;
 }
 
-void usartd0_out_string(const char * str)
+// mean of ADC_OFFSET_SAMPLES conversions of a channel in 1/16 LSB,
+// with its multiplexer set to muxctrl for the duration
+int16_t adc_measure(ADC_CH_t * ch, uint8_t muxctrl)
 {
-	while(*str) usartd0_out_char(*(str++));
+	uint8_t saved = ch->MUXCTRL;
+	int32_t sum = 0;
+	
+	ch->MUXCTRL = muxctrl;
+	
+	// the first conversion after a mux change is thrown away
+	for(uint8_t i = 0; i <= ADC_OFFSET_SAMPLES; i++)
+	{
+		ch->INTFLAGS = ADC_CH_CHIF_bm;
+		ch->CTRL |= ADC_CH_START_bm;
+		
+		while(!(ch->INTFLAGS & ADC_CH_CHIF_bm));
+		
+		if(i)
+		{
+			sum += (int16_t)ch->RES;
+		}
+	}
+	
+	ch->INTFLAGS = ADC_CH_CHIF_bm;
+	ch->MUXCTRL = saved;
+	
+	return (int16_t)(sum * 16 / ADC_OFFSET_SAMPLES);
 }
 
 void adc_init(void)
@@ -65,113 +368,793 @@ void adc_init(void)
 	// set cds+ and cds- as inputs
 	PORTA.DIRCLR = PIN1_bm | PIN6_bm;
 	
+	// spare inputs
+	PORTA.DIRCLR = PIN2_bm | PIN3_bm;
+	
 	// signed (set conmode), 12-bit right adjusted (00 res)
 	// normal (not freerun) mode (0)
 	ADCA.CTRLB = ADC_CURRLIMIT_NO_gc | ADC_CONMODE_bm | ADC_RESOLUTION_12BIT_gc;
 	
+	// adc clock from the peripheral clock
+	ADCA.PRESCALER = ADC_PRESCALER;
+	
+	// factory calibration of the adc's pipeline stages
+	ADCA.CALL = read_calibration_byte(offsetof(NVM_PROD_SIGNATURES_t, ADCACAL0));
+	ADCA.CALH = read_calibration_byte(offsetof(NVM_PROD_SIGNATURES_t, ADCACAL1));
+	
 	// 2.5 V voltage reference, used AREFA PA0, also set bandgap enable since we arent using it
 	ADCA.REFCTRL = (ADC_REFSEL_AREFB_gc | ADC_BANDGAP_bm);
 	
-	// interrupt when complete, set as low-level
-	ADCA.CH0.INTCTRL = (ADC_CH_INTMODE_COMPLETE_gc | ADC_CH_INTLVL_LO_gc);
-
-	// select channel 0 in event system
-	ADCA.EVCTRL = ADC_EVSEL_0123_gc | ADC_EVACT_CH0_gc | ADC_SWEEP_0_gc;
-	
+	// flags set on completion but no interrupt level: the results
+	// are collected by dma
+	ADCA.CH0.INTCTRL = ADC_CH_INTMODE_COMPLETE_gc;
+	ADCA.CH1.INTCTRL = ADC_CH_INTMODE_COMPLETE_gc;
+	ADCA.CH2.INTCTRL = ADC_CH_INTMODE_COMPLETE_gc;
+	ADCA.CH3.INTCTRL = ADC_CH_INTMODE_COMPLETE_gc;
 
-	// select differential input with gain
-	ADCA.CH0.CTRL = ADC_CH_INPUTMODE_DIFFWGAIN_gc | ADC_CH_GAIN_1X_gc;
+	// event channel 0 starts a sweep of channels 0 to 3
+	ADCA.EVCTRL = ADC_EVSEL_0123_gc | ADC_EVACT_SWEEP_gc | ADC_SWEEP_0123_gc;
 	
+	// CH0: differential input with gain
 	// muxpos = CdS+ PA1 
 	// muxneg = CdS- PA6
+	ADCA.CH0.CTRL = ADC_CH_INPUTMODE_DIFFWGAIN_gc | ADC_CH_GAIN_1X_gc;
 	ADCA.CH0.MUXCTRL =	 ADC_CH_MUXPOS_PIN1_gc | ADC_CH_MUXNEG_PIN6_gc;
 	
+	// CH1: differential input with gain
+	// muxpos = J3 in0+ PA4
+	// muxneg = J3 in0- PA5
+	ADCA.CH1.CTRL = ADC_CH_INPUTMODE_DIFFWGAIN_gc | ADC_CH_GAIN_1X_gc;
+	ADCA.CH1.MUXCTRL =	 ADC_CH_MUXPOS_PIN4_gc | ADC_CH_MUXNEG_PIN5_gc;
+	
+	// CH2, CH3: spares, single ended
+	ADCA.CH2.CTRL = ADC_CH_INPUTMODE_SINGLEENDED_gc;
+	ADCA.CH2.MUXCTRL = ADC_SPARE2_MUX;
+	ADCA.CH3.CTRL = ADC_CH_INPUTMODE_SINGLEENDED_gc;
+	ADCA.CH3.MUXCTRL = ADC_SPARE3_MUX;
+	
 	// enable adc
 	ADCA.CTRLA = ADC_ENABLE_bm;
+	
+	// offsets of the differential channels at every gain, with both
+	// inputs on the negative pin; the single ended spares have no way
+	// to short theirs and keep 0
+	for(uint8_t g = 0; g < GAIN_STEPS; g++)
+	{
+		ADCA.CH0.CTRL = ADC_CH_INPUTMODE_DIFFWGAIN_gc | (g << ADC_CH_GAIN_gp);
+		ADCA.CH1.CTRL = ADC_CH_INPUTMODE_DIFFWGAIN_gc | (g << ADC_CH_GAIN_gp);
+		
+		adc_offset[0][g] = adc_measure(&ADCA.CH0, ADC_CH_MUXPOS_PIN6_gc | ADC_CH_MUXNEG_PIN6_gc);
+		adc_offset[1][g] = adc_measure(&ADCA.CH1, ADC_CH_MUXPOS_PIN5_gc | ADC_CH_MUXNEG_PIN5_gc);
+	}
+	
+	ADCA.CH0.CTRL = ADC_CH_INPUTMODE_DIFFWGAIN_gc | ADC_CH_GAIN_1X_gc;
+	ADCA.CH1.CTRL = ADC_CH_INPUTMODE_DIFFWGAIN_gc | ADC_CH_GAIN_1X_gc;
+}
+
+// writes the gains asked for to the channels with gain, for block n,
+// which is about to be converted
+void gain_apply(uint8_t n)
+{
+	for(uint8_t c = 0; c < ADC_GAIN_CHANNELS; c++)
+	{
+		ADC_CH_t * ch = c ? &ADCA.CH1 : &ADCA.CH0;
+		
+		ch->CTRL = ADC_CH_INPUTMODE_DIFFWGAIN_gc | (gain_set[c] << ADC_CH_GAIN_gp);
+		block_gain[n][c] = gain_set[c];
+	}
+}
+
+// picks the next gain of each channel with gain from the peak
+// magnitudes of block n, unless a change is still on its way
+void autorange_update(uint8_t n, const uint16_t * peak)
+{
+	for(uint8_t c = 0; c < ADC_GAIN_CHANNELS; c++)
+	{
+		uint8_t g = block_gain[n][c];
+		
+		if(gain_set[c] != g)
+		{
+			continue;
+		}
+		
+		if(peak[c] >= AUTORANGE_CLIP && g >= 2)
+		{
+			gain_set[c] = g - 2;
+		}
+		else if(peak[c] >= AUTORANGE_HIGH && g >= 1)
+		{
+			gain_set[c] = g - 1;
+		}
+		else if(peak[c] < AUTORANGE_LOW && g < GAIN_STEPS - 1)
+		{
+			gain_set[c] = g + 1;
+		}
+	}
+}
+
+// a result in 1/16 LSB at gain 2^g, back to 1/16 LSB at 1x
+int16_t unity(int16_t y, uint8_t g)
+{
+	return g ? (int16_t)((y + (1 << (g - 1))) >> g) : y;
+}
+
+// corrects a result of channel c at gain setting g: (result - offset)
+// * gain, in Q15 with rounding, saturated. a few dozen cycles
+int16_t calibrate(uint8_t c, uint8_t g, int16_t y)
+{
+	int32_t d = (int32_t)y - adc_offset[c][g];
+	
+	d = (d * adc_gain[c] + (1L << 14)) >> 15;
+	
+	if(d > INT16_MAX)
+	{
+		return INT16_MAX;
+	}
+	
+	if(d < INT16_MIN)
+	{
+		return INT16_MIN;
+	}
+	
+	return (int16_t)d;
+}
+
+// starts a new statistics window
+void stats_reset(void)
+{
+	stats_count = 0;
+	
+	for(uint8_t c = 0; c < ADC_CHANNELS; c++)
+	{
+		stats_min[c] = INT16_MAX;
+		stats_max[c] = INT16_MIN;
+		stats_sum[c] = 0;
+		stats_sum_sq[c] = 0;
+	}
+}
+
+// adds a row of results to the window, integer only: a 16 x 16 bit
+// square per channel
+void stats_add(const int16_t * row)
+{
+	for(uint8_t c = 0; c < ADC_CHANNELS; c++)
+	{
+		int16_t y = row[c];
+		
+		if(y < stats_min[c])
+		{
+			stats_min[c] = y;
+		}
+		
+		if(y > stats_max[c])
+		{
+			stats_max[c] = y;
+		}
+		
+		stats_sum[c] += y;
+		stats_sum_sq[c] += (uint32_t)((int32_t)y * y);
+	}
+	
+	stats_count++;
+}
+
+// sends the window: first channel, number of channels, result count,
+// then min, max, sum and sum of squares per channel
+void print_stats(void)
+{
+	uint8_t first = (send_channel == SEND_ALL) ? 0 : send_channel;
+	uint8_t count = (send_channel == SEND_ALL) ? ADC_CHANNELS : 1;
+	
+	frame_begin(FRAME_TYPE_ADC_STATS);
+	frame_put(&first, 1);
+	frame_put(&count, 1);
+	frame_put(&stats_count, sizeof(stats_count));
+	
+	for(uint8_t c = first; c < first + count; c++)
+	{
+		frame_put(&stats_min[c], sizeof(stats_min[c]));
+		frame_put(&stats_max[c], sizeof(stats_max[c]));
+		frame_put(&stats_sum[c], sizeof(stats_sum[c]));
+		frame_put(&stats_sum_sq[c], sizeof(stats_sum_sq[c]));
+	}
+	
+	frame_end();
+}
+
+// restarts the decimators with the current settings
+void decimators_init(void)
+{
+	for(uint8_t c = 0; c < ADC_CHANNELS; c++)
+	{
+		decimate_init(&adc_dec[c], os_bits, os_filter);
+	}
+}
+
+// as above, for new oversampling settings
+void oversample_init(void)
+{
+	decimators_init();
+	
+	// no window mixes two settings
+	stats_reset();
+}
+
+// decimates and calibrates a block into adc_out, and auto-ranges on it
+void process_block(uint8_t n)
+{
+	uint16_t peak[ADC_GAIN_CHANNELS] = {0};
+	
+	adc_out_rows = 0;
+	
+	// results of two gains can't be averaged together
+	for(uint8_t c = 0; c < ADC_GAIN_CHANNELS; c++)
+	{
+		if(dec_gain[c] != block_gain[n][c])
+		{
+			memcpy(dec_gain, (const uint8_t *)block_gain[n], sizeof(dec_gain));
+			decimators_init();
+			break;
+		}
+	}
+	
+	for(uint8_t i = 0; i < ADC_BLOCK_SWEEPS; i++)
+	{
+		int16_t * row = adc_out[adc_out_rows];
+		uint8_t ready = 0;
+		
+		for(uint8_t c = 0; c < ADC_GAIN_CHANNELS; c++)
+		{
+			int16_t x = adc_block[n][i][c];
+			uint16_t mag = (x < 0) ? -x : x;
+			
+			if(mag > peak[c])
+			{
+				peak[c] = mag;
+			}
+		}
+		
+		// the channels decimate in step, so all or none are ready
+		for(uint8_t c = 0; c < ADC_CHANNELS; c++)
+		{
+			ready = decimate_push(&adc_dec[c], adc_block[n][i][c], &row[c]);
+		}
+		
+		if(ready)
+		{
+			for(uint8_t c = 0; c < ADC_CHANNELS; c++)
+			{
+				row[c] = calibrate(c, dec_gain[c], row[c]);
+			}
+			
+			adc_out_rows++;
+		}
+	}
+	
+	if(autorange)
+	{
+		autorange_update(n, peak);
+	}
+}
+
+// dma CH0 and CH1, double buffered: each copies the four results
+// (CH0RES..CH3RES, 8 bytes) after every sweep into its own block, and
+// hands over to the other one when the block is full
+void dma_init(void)
+{
+	DMA.CH0.CTRLA = DMA_CH_RESET_bm;
+	DMA.CH1.CTRLA = DMA_CH_RESET_bm;
+	
+	for(uint8_t n = 0; n < 2; n++)
+	{
+		DMA_CH_t * ch = n ? &DMA.CH1 : &DMA.CH0;
+		
+		ch->ADDRCTRL = DMA_CH_SRCRELOAD_BURST_gc | DMA_CH_SRCDIR_INC_gc |
+					   DMA_CH_DESTRELOAD_BLOCK_gc | DMA_CH_DESTDIR_INC_gc;
+		
+		// all four channels of the sweep converted
+		ch->TRIGSRC = DMA_CH_TRIGSRC_ADCA_CH4_gc;
+		ch->TRFCNT = sizeof(adc_block[0]);
+		ch->REPCNT = 0;
+		dma_addr(&ch->SRCADDR0, &ADCA.CH0RES);
+		dma_addr(&ch->DESTADDR0, adc_block[n]);
+		
+		// one interrupt per block
+		ch->CTRLB = DMA_CH_TRNINTLVL_LO_gc;
+		ch->CTRLA = DMA_CH_REPEAT_bm | DMA_CH_SINGLE_bm | DMA_CH_BURSTLEN_8BYTE_gc;
+	}
+	
+	DMA.CTRL = (DMA.CTRL & ~DMA_DBUFMODE_gm) | DMA_ENABLE_bm | DMA_DBUFMODE_CH01_gc;
+	gain_apply(0);
+	DMA.CH0.CTRLA |= DMA_CH_ENABLE_bm;
+}
+
+// changes the sweep rate from the next timer cycle on, within
+// ADC_SAMPLE_HZ_MIN and ADC_SAMPLE_HZ_MAX
+void sweep_rate_set(uint32_t hz)
+{
+	if(hz < ADC_SAMPLE_HZ_MIN)
+	{
+		hz = ADC_SAMPLE_HZ_MIN;
+	}
+	else if(hz > ADC_SAMPLE_HZ_MAX)
+	{
+		hz = ADC_SAMPLE_HZ_MAX;
+	}
+	
+	sweep_hz = (uint16_t)hz;
+	TCC0.PERBUF = (uint16_t)(ADC_TIMER_HZ / hz - 1);
 }
 
 void tcc0_init(void)
 {
-	// set .01 second timer with prescaler of 1024
-	float mytimer = .01;
-	TCC0.PER = ( mytimer * (2000000 / 1024)  );
+	TCC0.CTRLA = TC_CLKSEL_OFF_gc;
+	TCC0.CNT = 0;
+	TCC0.PER = (uint16_t)(ADC_TIMER_HZ / sweep_hz - 1);
 	
 	// overflow on tcc0
 	EVSYS.CH0MUX = EVSYS_CHMUX_TCC0_OVF_gc;
 
 	// choose prescaler
-	TCC0.CTRLA = TC_CLKSEL_DIV1024_gc;
+	TCC0.CTRLA = TC_CLKSEL_DIV8_gc;
+}
+
+// the ring index dma CH2 writes next
+uint16_t scope_pos(void)
+{
+	uint16_t dest;
+	
+	// the dma may carry between the two bytes; read until stable
+	do
+	{
+		dest = DMA.CH2.DESTADDR0 | ((uint16_t)DMA.CH2.DESTADDR1 << 8);
+	} while(dest != (DMA.CH2.DESTADDR0 | ((uint16_t)DMA.CH2.DESTADDR1 << 8)));
+	
+	return (uint16_t)((dest - (uint16_t)(uintptr_t)scope_ring) / sizeof(scope_ring[0]));
+}
+
+// results written since ring index from, up to now
+uint16_t scope_since(uint16_t from)
+{
+	uint16_t pos = scope_pos();
+	
+	return (pos >= from) ? pos - from : pos + ADC_SCOPE_RING - from;
+}
+
+// compare mode of CH0 that waits for the signal to be on the side of
+// the level the edge starts from (far = 0), or to cross it (far = 1)
+uint8_t scope_intmode(uint8_t cross)
+{
+	return (scope_rising == cross) ? ADC_CH_INTMODE_ABOVE_gc : ADC_CH_INTMODE_BELOW_gc;
+}
+
+// stops the sweeps and starts the adc running free on J3 into the ring
+void scope_start(void)
+{
+	// no more sweep events, and their dma stopped
+	TCC0.CTRLA = TC_CLKSEL_OFF_gc;
+	DMA.CH0.CTRLA = 0;
+	DMA.CH1.CTRLA = 0;
+	
+	ADCA.EVCTRL = ADC_SWEEP_01_gc;
+	ADCA.PRESCALER = ADC_SCOPE_PRESCALER;
+	ADCA.CH0.MUXCTRL = ADC_CH_MUXPOS_PIN4_gc | ADC_CH_MUXNEG_PIN5_gc;
+	ADCA.CH0.CTRL = ADC_CH_INPUTMODE_DIFFWGAIN_gc | ADC_CH_GAIN_1X_gc;
+	ADCA.CH1.CTRL = ADC_CH_INPUTMODE_DIFFWGAIN_gc | ADC_CH_GAIN_1X_gc;
+	ADCA.CMP = scope_level;
+	
+	// CH1's results into the ring, round and round
+	DMA.CH2.CTRLA = DMA_CH_RESET_bm;
+	DMA.CH2.ADDRCTRL = DMA_CH_SRCRELOAD_BURST_gc | DMA_CH_SRCDIR_INC_gc |
+					   DMA_CH_DESTRELOAD_BLOCK_gc | DMA_CH_DESTDIR_INC_gc;
+	DMA.CH2.TRIGSRC = DMA_CH_TRIGSRC_ADCA_CH1_gc;
+	DMA.CH2.TRFCNT = sizeof(scope_ring);
+	DMA.CH2.REPCNT = 0;
+	dma_addr(&DMA.CH2.SRCADDR0, &ADCA.CH1RES);
+	dma_addr(&DMA.CH2.DESTADDR0, scope_ring);
+	DMA.CH2.CTRLA = DMA_CH_ENABLE_bm | DMA_CH_REPEAT_bm | DMA_CH_SINGLE_bm | DMA_CH_BURSTLEN_2BYTE_gc;
+	
+	// TCC0 free running, to measure the sample rate
+	TCC0.CNT = 0;
+	TCC0.PER = 0xFFFF;
+	TCC0.CTRLA = TC_CLKSEL_DIV64_gc;
+	
+	scope_state = SCOPE_FILLING;
+	ADCA.CTRLB |= ADC_FREERUN_bm;
+}
+
+// goes back to sweeping
+void scope_stop(void)
+{
+	ADCA.CH0.INTCTRL = ADC_CH_INTMODE_COMPLETE_gc;
+	ADCA.CTRLB &= ~ADC_FREERUN_bm;
+	DMA.CH2.CTRLA = 0;
+	scope_state = SCOPE_OFF;
+	
+	ADCA.PRESCALER = ADC_PRESCALER;
+	ADCA.EVCTRL = ADC_EVSEL_0123_gc | ADC_EVACT_SWEEP_gc | ADC_SWEEP_0123_gc;
+	ADCA.CH0.MUXCTRL = ADC_CH_MUXPOS_PIN1_gc | ADC_CH_MUXNEG_PIN6_gc;
+	
+	cli();
+	block_ready = 0;
+	block_next = 0;
+	sei();
+	
+	dma_init();
+	oversample_init();
+	tcc0_init();
 }
 
-// set conversion_flag, clear tc0 overflow interrupt flag
+// sends the frozen capture: pre-trigger count, total count, measured
+// sample rate in Hz, then the results in 1/16 LSB, calibrated as CH1
+void scope_dump(uint16_t samples, uint16_t ticks)
+{
+	uint16_t pre = ADC_SCOPE_PRE;
+	uint16_t count = ADC_SCOPE_PRE + ADC_SCOPE_POST;
+	uint32_t hz = ticks ? ((uint32_t)samples * (F_CPU / 64) + ticks / 2) / ticks : 0;
+	uint16_t i = (scope_trig_pos >= ADC_SCOPE_PRE) ? scope_trig_pos - ADC_SCOPE_PRE :
+				 scope_trig_pos + ADC_SCOPE_RING - ADC_SCOPE_PRE;
+	
+	frame_begin(FRAME_TYPE_ADC_SCOPE);
+	frame_put(&pre, sizeof(pre));
+	frame_put(&count, sizeof(count));
+	frame_put(&hz, sizeof(hz));
+	
+	for(uint16_t n = 0; n < count; n++)
+	{
+		int16_t y = calibrate(ADC_CH_J3, 0, scope_ring[i] * 16);
+		
+		frame_put(&y, sizeof(y));
+		
+		if(++i == ADC_SCOPE_RING)
+		{
+			i = 0;
+		}
+	}
+	
+	frame_end();
+}
+
+// moves the capture on from the main loop: arms the trigger once the
+// pre-trigger results are in, and freezes and sends the ring once the
+// post-trigger ones are
+void scope_poll(void)
+{
+	if(scope_state == SCOPE_FILLING && scope_pos() >= ADC_SCOPE_PRE)
+	{
+		// chif has been set by every conversion until now, so it is cleared
+		// in compare mode before the interrupt is enabled, or it would fire
+		// at once whatever the signal. masked, so nothing runs in between
+		cli();
+		ADCA.CH0.INTCTRL = scope_intmode(0);
+		ADCA.CH0.INTFLAGS = ADC_CH_CHIF_bm;
+		ADCA.CH0.INTCTRL = scope_intmode(0) | ADC_CH_INTLVL_MED_gc;
+		scope_state = SCOPE_ARMED;
+		sei();
+	}
+	else if(scope_state == SCOPE_TRIGGERED)
+	{
+		uint16_t samples = scope_since(scope_trig_pos);
+		
+		if(samples >= ADC_SCOPE_POST)
+		{
+			uint16_t ticks = TCC0.CNT - scope_trig_ticks;
+			
+			// freeze the ring
+			ADCA.CTRLB &= ~ADC_FREERUN_bm;
+			DMA.CH2.CTRLA = 0;
+			
+			scope_dump(samples, ticks);
+			scope_stop();
+		}
+	}
+}
+
+// CH0 compare: the signal is on the far side of the level, or has
+// crossed it
 ISR(ADCA_CH0_vect)
 {
-	result = ADCA.CH0.RES;
+	if(scope_state == SCOPE_ARMED)
+	{
+		ADCA.CH0.INTCTRL = scope_intmode(1) | ADC_CH_INTLVL_MED_gc;
+		ADCA.CH0.INTFLAGS = ADC_CH_CHIF_bm;
+		scope_state = SCOPE_EDGE;
+		return;
+	}
+	
+	scope_trig_pos = scope_pos();
+	scope_trig_ticks = TCC0.CNT;
+	ADCA.CH0.INTCTRL = ADC_CH_INTMODE_COMPLETE_gc;
+	scope_state = SCOPE_TRIGGERED;
+}
+
+// block `n` is full and dma goes on into the other one. if that is still
+// waiting, or being read, it is overwritten from now on: drop it, and send
+// block `n` next
+void block_full(uint8_t n)
+{
+	if(block_ready & (1 << (n ^ 1)))
+	{
+		block_ready &= (uint8_t)~(1 << (n ^ 1));
+		block_next = n;
+		blocks_lost++;
+	}
 	
-	voltage = (((float) result)*2.5)/2048.0;
+	block_ready |= 1 << n;
+}
+
+// block 0 full, dma goes on into block 1. the next sweep is a timer
+// period away, so block 1 is converted at the gains set here
+ISR(DMA_CH0_vect)
+{
+	DMA.CH0.CTRLB = DMA_CH_TRNIF_bm | DMA_CH_TRNINTLVL_LO_gc;
 	
-	TCC0_INTFLAGS = TC0_OVFIF_bm;
+	gain_apply(1);
+	block_full(0);
+}
+
+// block 1 full, dma goes on into block 0
+ISR(DMA_CH1_vect)
+{
+	DMA.CH1.CTRLB = DMA_CH_TRNIF_bm | DMA_CH_TRNINTLVL_LO_gc;
 	
-	conversion_flag = 1;
+	gain_apply(0);
+	block_full(1);
 }
 
-//
-ISR(USARTD0_RXC_vect)
+// sends the number of blocks dropped since the last call, if any, and
+// restarts the decimators so no result spans the gap
+void print_lost(void)
 {
-	data = USARTD0.DATA;
-	input_flag = 1;
+	uint8_t now = blocks_lost;
+	uint16_t lost[2];
+	
+	if(now == blocks_lost_sent)
+	{
+		return;
+	}
+	
+	lost[0] = (uint8_t)(now - blocks_lost_sent);
+	lost[1] = ADC_BLOCK_SWEEPS;
+	blocks_lost_sent = now;
+	frame_send(FRAME_TYPE_ADC_LOST, lost, sizeof(lost));
+	
+	decimators_init();
 }
 
 
-void print_raw(void)
+void print_results(void)
 {
-	uint8_t resultlow = result;
-	uint8_t resulthigh = (result >> 8);
+	if(!adc_out_rows)
+	{
+		return;
+	}
 	
-	// big endian is high byte first, then low byte
-	usartd0_out_char(resulthigh);
-	usartd0_out_char(resultlow);
+	// tagged with the gains, as 1/16 LSB of the amplified inputs, also
+	// while the gains go back to 1x after auto-ranging is turned off
+	if(autorange || dec_gain[0] || dec_gain[1])
+	{
+		uint8_t first = (send_channel == SEND_ALL) ? 0 : send_channel;
+		uint8_t count = (send_channel == SEND_ALL) ? ADC_CHANNELS : 1;
+		uint8_t pad = 0;
+		
+		frame_begin(FRAME_TYPE_ADC_RANGED);
+		frame_put(&first, 1);
+		frame_put(&count, 1);
+		frame_put(&dec_gain[first], count);
+		
+		// keeps the results 16-bit aligned
+		if(count & 1)
+		{
+			frame_put(&pad, 1);
+		}
+		
+		for(uint8_t i = 0; i < adc_out_rows; i++)
+		{
+			frame_put(&adc_out[i][first], count * sizeof(int16_t));
+		}
+		
+		frame_end();
+		return;
+	}
+	
+	if(send_channel == SEND_ALL)
+	{
+		frame_send(FRAME_TYPE_ADC_SWEEP, adc_out, adc_out_rows * sizeof(adc_out[0]));
+		return;
+	}
+	
+	// framed, so the host can find the sample boundaries
+	frame_begin(FRAME_TYPE_ADC_SAMPLE);
+	
+	for(uint8_t i = 0; i < adc_out_rows; i++)
+	{
+		frame_put(&adc_out[i][send_channel], sizeof(int16_t));
+	}
+	
+	frame_end();
 }
 
 
 int main(void)
 {
-	tcc0_init();
+	clock_init();
+	oversample_init();
 	adc_init();
+	dma_init();
+	tcc0_init();
 	
 	// enable up to medium level interrupts
 	PMIC_CTRL = PMIC_MEDLVLEN_bm | PMIC_LOLVLEN_bm;
 	sei();
 	
+	// also enables the (medium level) receive interrupt
 	usartd0_init();
-
 	
 	while(1)
 	{
-		if(input_flag)
+		char data;
+		
+		// every queued key press, so none is missed while sending
+		while(usartd0_try_read(&data))
 		{
+			// while capturing, only cancelling it
+			if(scope_state != SCOPE_OFF)
+			{
+				if(data == 'T')
+				{
+					scope_stop();
+				}
+			}
+			// if 'T' arm a scope capture
+			else if(data == 'T')
+			{
+				scope_start();
+			}
+			// trigger edge and level
+			else if(data == 'E')
+			{
+				scope_rising = !scope_rising;
+			}
+			else if(data == '<' && scope_level > -2048 + ADC_SCOPE_LEVEL_STEP)
+			{
+				scope_level -= ADC_SCOPE_LEVEL_STEP;
+			}
+			else if(data == '>' && scope_level < 2047 - ADC_SCOPE_LEVEL_STEP)
+			{
+				scope_level += ADC_SCOPE_LEVEL_STEP;
+			}
 			// if 'C' use CdS cell
-			if(data == 'C')
+			else if(data == 'C')
 			{
-				ADCA.CH0.MUXCTRL =	 ADC_CH_MUXPOS_PIN1_gc | ADC_CH_MUXNEG_PIN6_gc;
+				send_channel = ADC_CH_CDS;
 			}
 			// if 'J' use J3 jumper
 			else if(data == 'J')
 			{
-				ADCA.CH0.MUXCTRL =	 ADC_CH_MUXPOS_PIN4_gc | ADC_CH_MUXNEG_PIN5_gc;
+				send_channel = ADC_CH_J3;
+			}
+			// if 'A' send every channel
+			else if(data == 'A')
+			{
+				send_channel = SEND_ALL;
+			}
+			// '0' to '4' extra bits of resolution
+			else if(data >= '0' && data <= '0' + DECIMATE_BITS_MAX)
+			{
+				os_bits = data - '0';
+				oversample_init();
+			}
+			// decimation filter
+			else if(data == 'B' || data == 'I' || data == 'M')
+			{
+				os_filter = (data == 'B') ? DECIMATE_BOXCAR :
+							(data == 'I') ? DECIMATE_CIC2 : DECIMATE_MAVG;
+				oversample_init();
+			}
+			// sweep rate
+			else if(data == '+')
+			{
+				sweep_rate_set((uint32_t)sweep_hz * 2);
+			}
+			else if(data == '-')
+			{
+				sweep_rate_set(sweep_hz / 2);
+			}
+			// gain auto-ranging, back to 1x when turned off
+			else if(data == 'G')
+			{
+				autorange = !autorange;
+				
+				if(!autorange)
+				{
+					memset(gain_set, 0, sizeof(gain_set));
+				}
+			}
+			// results or statistics
+			else if(data == 'S')
+			{
+				stats_mode = !stats_mode;
+				stats_reset();
+			}
+			// statistics window
+			else if(data == '[' && stats_window > ADC_STATS_WINDOW_MIN)
+			{
+				stats_window /= 2;
+				stats_reset();
+			}
+			else if(data == ']' && stats_window < ADC_STATS_WINDOW_MAX)
+			{
+				stats_window *= 2;
+				stats_reset();
 			}
 		}
 	
-		if(conversion_flag)
+		if(scope_state != SCOPE_OFF)
+		{
+			scope_poll();
+		}
+		// blocks fill alternately, so send them in that order
+		else if(block_ready & (1 << block_next))
 		{
+			uint8_t n, lost, whole;
 			
-			print_raw();
+			// the block and the drops so far together, as a drop moves
+			// block_next on
+			cli();
+			n = block_next;
+			lost = blocks_lost;
+			sei();
+			
+			process_block(n);
+			
+			// done with the block itself. dma only comes round to it by
+			// finishing the other block, which drops this one: so it was
+			// read whole unless something was dropped meanwhile, and then
+			// the interrupt has already moved block_next on
+			cli();
+			whole = (blocks_lost == lost);
+			
+			if(whole)
+			{
+				block_ready &= (uint8_t)~(1 << n);
+				block_next = n ^ 1;
+			}
+			sei();
 			
-			conversion_flag = 0;
+			if(!whole)
+			{
+				adc_out_rows = 0;
+			}
+			
+			print_lost();
+			
+			if(!stats_mode)
+			{
+				print_results();
+			}
+			else
+			{
+				for(uint8_t i = 0; i < adc_out_rows; i++)
+				{
+					// a window may span gain changes
+					for(uint8_t c = 0; c < ADC_GAIN_CHANNELS; c++)
+					{
+						adc_out[i][c] = unity(adc_out[i][c], dec_gain[c]);
+					}
+					
+					stats_add(adc_out[i]);
+					
+					if(stats_count >= stats_window)
+					{
+						print_stats();
+						stats_reset();
+					}
+				}
+			}
 		}
 
 	}
 	
 	return 0;
 }
-
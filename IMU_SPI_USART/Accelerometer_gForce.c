@@ -3,6 +3,24 @@
  Name:          Thomas Creel
  Description:   uses lsm accelerometer to measure g forces
 
+                records are sent as frames (see frame.h). samples go out as
+                FRAME_TYPE_ACCEL frames of little-endian int16 x, y, z, one
+                frame per fifo batch
+
+                with ACCEL_TIMESTAMP set, frames are FRAME_TYPE_ACCEL_TS and
+                every sample is followed by the number of sensor timestamp
+                ticks (25us each) since the previous sample, as a uint16
+
+                with ACCEL_EVENTS set, nothing is streamed until the
+                LSM6DS3 embedded functions see a tap, wake-up, free-fall
+                or step. each interrupt then sends one FRAME_TYPE_EVENT
+                frame of 4 bytes: event bits (LSM6DS3_EVENT_*), tap
+                sign/axes in the high nibble and wake-up axes in the low
+                nibble, and the step count as a uint16
+
+                runs at F_CPU (32 MHz by default, see clock.h); build with
+                clock.c and e.g. -DUSART_BAUD=2000000 to stream at 2 Mbps
+
  */ 
 
 /********************************DEPENDENCIES**********************************/
@@ -11,14 +29,81 @@
 #include "spi.h"
 #include "lsm6ds3.h"
 #include "lsm6ds3_registers.h"
+#include "clock.h"
 #include "usart.h"
+#include "frame.h"
 
 /*****************************FUNCTION DEFINITIONS*****************************/
 
+/* Number of samples to batch in the LSM6DS3 FIFO before interrupting, or 0
+ * to take one interrupt per sample straight from the output registers. */
+#define ACCEL_FIFO_BATCH    32
+
+/* Records in the DMA sample ring when built with SPI_USART_MSPI. */
+#define ACCEL_STREAM_RING   8
+
+#ifdef SPI_USART_MSPI
+/* the dma stream samples on data-ready, so fifo batching does not apply */
+#undef  ACCEL_FIFO_BATCH
+#define ACCEL_FIFO_BATCH    0
+#endif
+
+/* Set to 1 to append a sensor timestamp delta to every record. */
+#define ACCEL_TIMESTAMP     0
+
+/* Set to LSM6DS3_EVENT_* bits to send event records instead of samples. */
+#define ACCEL_EVENTS        0
+
+/* Event thresholds at +/-2g: tap 9/32 fs (~560mg), wake-up 2/64 fs
+ * (~63mg), free-fall code 3 (312mg). */
+#define ACCEL_TAP_THS       9
+#define ACCEL_WAKE_THS      2
+#define ACCEL_FF_THS        3
+
+#if ACCEL_EVENTS
+/* the sample paths are unused, so keep the fifo and timestamp off */
+#undef  ACCEL_FIFO_BATCH
+#define ACCEL_FIFO_BATCH    0
+#undef  ACCEL_TIMESTAMP
+#define ACCEL_TIMESTAMP     0
+#endif
+
+#if ACCEL_TIMESTAMP
+/* words per sample: accel x, y, z plus the fifo timestamp data set */
+#define ACCEL_SET_WORDS     6
+#else
+#define ACCEL_SET_WORDS     3
+#endif
+
+#if ACCEL_FIFO_BATCH
+/* words per buffer, with room for two batches so the fifo can run ahead */
+#define XYZ_WORDS           (2 * ACCEL_FIFO_BATCH * ACCEL_SET_WORDS)
+#else
+/* accel x, y, z, plus room for the 3 timestamp bytes */
+#define XYZ_WORDS           (3 + 2 * ACCEL_TIMESTAMP)
+#endif
+
 volatile uint8_t accel_flag = 0;
 
+#if ACCEL_TIMESTAMP
+// adds the ticks elapsed since the previous sample's timestamp `ts`
+// (24-bit counter), saturated to 16 bits, to the frame being sent.
+void accel_out_timestamp(uint32_t ts)
+{
+    static uint32_t last_ts = 0;
+    uint32_t delta = (ts - last_ts) & 0x00FFFFFF;
+    uint16_t ticks = (delta > 0xFFFF) ? 0xFFFF : (uint16_t)delta;
+    
+    last_ts = ts;
+    
+    frame_put(&ticks, 2);
+}
+#endif
+
 int main(void)
 {
+    clock_init();
+    
     spi_init();
     
     interrupt_init();
@@ -33,102 +118,143 @@ int main(void)
     
     usartd0_init();
     
-    uint8_t xyz_data[6];
+#if ACCEL_EVENTS
+    // the event sources are latched, so int1 stays high until they are read
+    lsm6ds3_event_t event;
+    
+    // an event latched before the edge interrupt was armed would never edge
+    accel_flag = 1;
     
     while(1)
     {
         if(accel_flag)
         {
-            // load from register using lsmread
-            xyz_data[0] = lsm6ds3_read(OUTX_L_XL);
-            xyz_data[1] = lsm6ds3_read(OUTX_H_XL);
-            xyz_data[2]  = lsm6ds3_read(OUTY_L_XL);
-            xyz_data[3] = lsm6ds3_read(OUTY_H_XL);
-            xyz_data[4]  =  lsm6ds3_read(OUTZ_L_XL);
-            xyz_data[5] =  lsm6ds3_read(OUTZ_H_XL);
-            
-            usartd0_out_string((const char*) xyz_data);
-    
             accel_flag = 0;
+            
+            uint8_t events = lsm6ds3_events_read(&event);
+            
+            if(events)
+            {
+                uint8_t rec[4];
+                
+                rec[0] = events;
+                rec[1] = ((event.tap_src & LSM6DS3_TAP_SIGN_XYZ_gm) << 4) |
+                         (event.wake_up_src & LSM6DS3_WU_XYZ_gm);
+                rec[2] = (uint8_t)event.step_count;
+                rec[3] = (uint8_t)(event.step_count >> 8);
+                
+                frame_send(FRAME_TYPE_EVENT, rec, 4);
+            }
+            
+            // an event that latched during the read keeps the line high
+            if(PORTC.IN & PIN6_bm)
+            {
+                accel_flag = 1;
+            }
         }
     }
+#endif
     
-    while(1);
-    
-    return 0;
-}
-
-
-void spi_init(void)
-{
-    PORTF.OUTSET = SS_bm;                               // SS idles high in mode3
-    PORTF.DIRSET = (SS_bm | MOSI_bm | SCK_bm);          // SS, MOSI, SCK outputs
-    PORTF.DIRCLR = (MISO_bm);                           // MISO input
-    
-    // DORD is pin 5, defaulted to zero = MSB first, prescaler 4 gives 8MHz frequency
-    SPIF.CTRL   =   SPI_PRESCALER_DIV4_gc           |   
-                        SPI_MASTER_bm               |   
-                        SPI_MODE_3_gc               |   
-                        SPI_ENABLE_bm;
-}
-
-void spi_write(uint8_t data)
-{
-    /* Write to the relevant DATA register. */
-    SPIF.DATA = data;
-
-    /* Wait for relevant transfer to complete. */
-    while(!(SPIF.STATUS & (1 << 7)));
-}
-
-uint8_t spi_read(void)
-{
-  /* Write some arbitrary data to initiate a transfer. */
-  SPIF.DATA = 0x37;
-
-  /* Wait for relevant transfer to be complete. */
-  while(!(SPIF.STATUS & (1 << 7)));
-
-    /* After the transmission, return the data that was received. */
-    return SPIF.DATA;
-}
-
-void lsm6ds3_write(uint8_t reg_addr, uint8_t data)
-{
-    // enable slave (pull ss low)
-    PORTF.OUTCLR = SS_bm;
-    
-    // enable the lsm6ds3 via the relevant chip select signal
-    uint8_t var2 = (reg_addr | LSM6DS3_SPI_WRITE_STROBE_bm);
-    
-    // write desired address of lsm
-    spi_write(var2);
+#ifdef SPI_USART_MSPI
+    // data-ready edges reach the dma controller through the event system,
+    // which fills the ring without taking an interrupt per sample
+    static lsm6ds3_stream_rec_t ring[ACCEL_STREAM_RING];
+    lsm6ds3_data_t sample;
     
-    // write data to lsm
-    spi_write(data);
+    lsm6ds3_stream_start(ring, ACCEL_STREAM_RING, EVSYS_CHMUX_PORTC_PIN6_gc);
     
-    // disable slave (pull ss high)
-    PORTF.OUTSET = SS_bm;
+    while(1)
+    {
+        if(lsm6ds3_stream_read(&sample))
+        {
+            frame_send(FRAME_TYPE_ACCEL, &sample.byte.accel_x_low, 6);
+        }
+    }
+#endif
     
-}
-
-// returns a single byte of data from an LSM6SD3 register
-// associated with the address `reg_addr`
-uint8_t lsm6ds3_read(uint8_t reg_addr)
-{
-    PORTF.OUTCLR = SS_bm;           // enables cs/ss. idles high, active low
+    // ping-pong buffers: one is clocked in over spi while the other goes out the usart
+    spi_xfer_t xfer;
+#if ACCEL_TIMESTAMP && !ACCEL_FIFO_BATCH
+    spi_xfer_t ts_xfer;
     
-    uint8_t var3 = (reg_addr | LSM6DS3_SPI_READ_STROBE_bm);
+    ts_xfer.busy = 0;
+#endif
+    int16_t xyz_data[2][XYZ_WORDS];
+    uint16_t xyz_words[2] = {0, 0};
+    uint8_t fill = 0;
     
-    spi_write(var3);
+    xfer.busy = 0;
     
-    uint8_t var4 = spi_read();
+    while(1)
+    {
+        // the interrupt line is a level (fifo over the watermark, or data
+        // ready) but only its rising edge interrupts. if more was waiting
+        // than one read takes, the line is still high once that read has
+        // landed and no edge will come, so read again
+        if(!xfer.busy && (PORTC.IN & PIN6_bm))
+        {
+            accel_flag = 1;
+        }
+        
+        if(accel_flag)
+        {
+            // clear first so an edge during the read is not lost
+            accel_flag = 0;
+            
+            // the previous read has to land before its buffer is sent
+            spi_wait(&xfer);
+            
+#if ACCEL_FIFO_BATCH
+            // read the whole batch in one burst
+            xyz_words[fill] = lsm6ds3_fifo_available(XYZ_WORDS, ACCEL_SET_WORDS);
+            lsm6ds3_read_burst_async(&xfer, FIFO_DATA_OUT_L, (uint8_t *)xyz_data[fill], xyz_words[fill] << 1);
+#else
+            // load all six output registers in one burst (IF_INC is set)
+            xyz_words[fill] = 3;
+            lsm6ds3_read_burst_async(&xfer, OUTX_L_XL, (uint8_t *)xyz_data[fill], 6);
+    #if ACCEL_TIMESTAMP
+            // queued right behind the data, so it is read a few us later
+            spi_wait(&ts_xfer);
+            lsm6ds3_read_burst_async(&ts_xfer, TIMESTAMP0_REG, (uint8_t *)&xyz_data[fill][3], 3);
+    #endif
+#endif
+            
+            // forward the previous buffer as one frame while this one is read
+            fill ^= 1;
+            
+            if(xyz_words[fill])
+            {
+                frame_begin(ACCEL_TIMESTAMP ? FRAME_TYPE_ACCEL_TS : FRAME_TYPE_ACCEL);
+            }
+            
+            for(uint16_t i = 0; i < xyz_words[fill]; i += ACCEL_SET_WORDS)
+            {
+                frame_put(&xyz_data[fill][i], 6);
+                
+#if ACCEL_TIMESTAMP && ACCEL_FIFO_BATCH
+                accel_out_timestamp(lsm6ds3_fifo_timestamp(&xyz_data[fill][i + 3]));
+#elif ACCEL_TIMESTAMP
+                uint8_t * ts = (uint8_t *)&xyz_data[fill][3];
+                
+                accel_out_timestamp(((uint32_t)ts[2] << 16) | ((uint16_t)ts[1] << 8) | ts[0]);
+#endif
+            }
+            
+            if(xyz_words[fill])
+            {
+                frame_end();
+            }
+            
+            xyz_words[fill] = 0;
+        }
+    }
     
-    PORTF.OUTSET = SS_bm;           // disable ss. set it to idling high.
+    while(1);
     
-    return var4;
+    return 0;
 }
 
+
 void interrupt_init(void)
 {
     // port c int 1 mask select pin 6 as trigger the interrupt
@@ -141,7 +267,11 @@ void interrupt_init(void)
     
     // set as low level priority interrupt
     //PORTC.INTCTRL = 0b00000001;
+    // the dma stream takes pc6 through the event system instead, but the
+    // event loop runs in place of the stream and still needs the interrupt
+#if !defined(SPI_USART_MSPI) || ACCEL_EVENTS
     PORTC.INTCTRL = PORT_INT0LVL_LO_gc;
+#endif
     
     // set interrupt to trigger when PC6 at rising edge
     //PORTC.PIN6CTRL = 0b00000001;
@@ -155,8 +285,31 @@ void lsm6ds3_init(void)
     
     // configure CTRL1_XL, CTRL9_XL, INT1_CTRL 
     lsm6ds3_write(CTRL9_XL, 0b00111000);            // enable X, Y, Z
+#if ACCEL_TIMESTAMP
+    // 25us timestamp counter, read alongside every sample
+    lsm6ds3_timestamp_init(1);
+#endif
+#if ACCEL_EVENTS
+    // full-scale selection: 00 (+2g). 416Hz output data rate: 0110, the lowest rate taps are
+    // recognized at. only the embedded function events reach int1
+    lsm6ds3_write(CTRL1_XL, 0b01100000);
+    lsm6ds3_write(INT1_CTRL, 0);
+    lsm6ds3_events_init(ACCEL_EVENTS, ACCEL_TAP_THS, ACCEL_WAKE_THS, ACCEL_FF_THS);
+#elif ACCEL_FIFO_BATCH && ACCEL_TIMESTAMP
+    // full-scale selection: 00 (+2g). 1.66kHz output data rate: 1000, batched through
+    // the FIFO with the timestamp stored next to every sample
+    lsm6ds3_write(CTRL1_XL, 0b10000000);
+    lsm6ds3_fifo_init(ACCEL_FIFO_BATCH * ACCEL_SET_WORDS, LSM6DS3_FIFO_DEC_XL_NONE_gc | LSM6DS3_FIFO_DEC_DS4_NONE_gc, LSM6DS3_FIFO_ODR_1660HZ_gc);
+    lsm6ds3_write(INT1_CTRL, LSM6DS3_INT_FTH_bm);   // fifo watermark set
+#elif ACCEL_FIFO_BATCH
+    // full-scale selection: 00 (+2g). 1.66kHz output data rate: 1000, batched through the FIFO
+    lsm6ds3_write(CTRL1_XL, 0b10000000);
+    lsm6ds3_fifo_init(ACCEL_FIFO_BATCH * 3, LSM6DS3_FIFO_DEC_XL_NONE_gc, LSM6DS3_FIFO_ODR_1660HZ_gc);
+    lsm6ds3_write(INT1_CTRL, LSM6DS3_INT_FTH_bm);   // fifo watermark set
+#else
     lsm6ds3_write(CTRL1_XL, 0b01010000);            // full-scale selection: 00 (+2g). 208Hz output data rate: 0101 (208 Hz)
     lsm6ds3_write(INT1_CTRL, 0b00000001);           // accelerometer set
+#endif
 }
 
 ISR(PORTC_INT0_vect)
@@ -168,48 +321,4 @@ ISR(PORTC_INT0_vect)
     accel_flag = 1;
 }
 
-
-
-void usartd0_init(void)
-{
-  /* Configure relevant TxD and RxD pins. */
-    PORTD.OUTSET = PIN3_bm;
-    PORTD.DIRSET = PIN3_bm;
-    PORTD.DIRCLR = PIN2_bm;
-
-  /* Configure baud rate. *//* At 2 MHz SYSclk, 5 BSEL, -6 BSCALE corresponds to 115200 bps */
-    USARTD0.BAUDCTRLA = (uint8_t)BSEL;
-    USARTD0.BAUDCTRLB = (uint8_t)((BSCALE << 4)|(BSEL >> 8));
-
-  /* Configure remainder of serial protocol. */
-  /* (In this example, a protocol with 8 data bits, no parity, and
-   *  one stop bit is chosen.) */
-    USARTD0.CTRLC = (USART_CMODE_ASYNCHRONOUS_gc |
-                     USART_PMODE_DISABLED_gc     |
-                     USART_CHSIZE_8BIT_gc)       &
-                    ~USART_SBMODE_bm;
-
-  /* Enable receiver and/or transmitter systems. */
-    USARTD0.CTRLB = USART_RXEN_bm | USART_TXEN_bm;
-
-  /* Enable interrupt (optional). */
-    /* USARTD0.CTRLA = USART_RXCINTLVL_MED_gc; */
-}
-
-void usartd0_out_char(char c)
-{
-    while(!(USARTD0.STATUS & USART_DREIF_bm));
-    USARTD0.DATA = c;
-}
-
-void usartd0_out_string(const char * str)
-{
-    for(uint8_t i = 0; i < 6; i++)
-    {
-        usartd0_out_char(str[i]);
-    }
-    
-    //while(*str) usartd0_out_char(*(str++));
-}
-
 /***************************END OF FUNCTION DEFINITIONS************************/
\ No newline at end of file
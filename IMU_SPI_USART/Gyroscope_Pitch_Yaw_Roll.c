@@ -5,6 +5,20 @@
 
  Description:   uses lsm gyroscope to measure pitch,yaw,roll of micro pad
 
+                gyro and accelerometer are fused on the board (see attitude.h),
+                every record is a FRAME_TYPE_ATTITUDE frame (see frame.h) of
+                roll, pitch, yaw as little-endian int16 binary angles
+                (65536 = 360 degrees)
+
+                with GYRO_TIMESTAMP set, frames are FRAME_TYPE_ATTITUDE_TS
+                and the angles are followed by the number of sensor
+                timestamp ticks (25us each) between the last samples of
+                this frame and the previous one, as a uint16. the
+                SPI_USART_MSPI stream sends plain FRAME_TYPE_ATTITUDE frames
+
+                runs at F_CPU (32 MHz by default, see clock.h); build with
+                clock.c and e.g. -DUSART_BAUD=2000000 to stream at 2 Mbps
+
 
  */ 
 
@@ -14,14 +28,77 @@
 #include "spi.h"
 #include "lsm6ds3.h"
 #include "lsm6ds3_registers.h"
+#include "clock.h"
 #include "usart.h"
+#include "frame.h"
+#include "attitude.h"
 
 /*****************************FUNCTION DEFINITIONS*****************************/
 
+/* Number of samples to batch in the LSM6DS3 FIFO before interrupting, or 0
+ * to take one interrupt per sample straight from the output registers. */
+#define GYRO_FIFO_BATCH    32
+
+/* Records in the DMA sample ring when built with SPI_USART_MSPI. */
+#define GYRO_STREAM_RING   8
+
+#ifdef SPI_USART_MSPI
+/* the dma stream samples on data-ready, so fifo batching does not apply */
+#undef  GYRO_FIFO_BATCH
+#define GYRO_FIFO_BATCH    0
+#endif
+
+/* Set to 1 to append a sensor timestamp delta to every attitude record. */
+#define GYRO_TIMESTAMP     0
+
+#if GYRO_FIFO_BATCH
+#define GYRO_ODR_HZ        1666
+#else
+#define GYRO_ODR_HZ        208
+#endif
+
+#if GYRO_TIMESTAMP
+/* words per sample: gyro x, y, z, accel x, y, z plus the fifo timestamp data set */
+#define GYRO_SET_WORDS     9
+#else
+#define GYRO_SET_WORDS     6
+#endif
+
+#if GYRO_FIFO_BATCH
+/* words per buffer, with room for two batches so the fifo can run ahead */
+#define XYZ_WORDS          (2 * GYRO_FIFO_BATCH * GYRO_SET_WORDS)
+#else
+/* gyro and accel x, y, z, plus room for the 3 timestamp bytes */
+#define XYZ_WORDS          (6 + 2 * GYRO_TIMESTAMP)
+#endif
+
+/* 125 dps full scale is 4.375 mdps/LSB; +/-2 g full scale is 0.061 mg/LSB. */
+#define GYRO_UDPS_PER_LSB  4375
+#define ACCEL_ONE_G        16393
+
 volatile uint8_t gyro_flag = 0;
 
+attitude_t att;
+
+#if GYRO_TIMESTAMP
+// adds the ticks elapsed since the previous frame's timestamp `ts`
+// (24-bit counter), saturated to 16 bits, to the frame being sent.
+void gyro_out_timestamp(uint32_t ts)
+{
+    static uint32_t last_ts = 0;
+    uint32_t delta = (ts - last_ts) & 0x00FFFFFF;
+    uint16_t ticks = (delta > 0xFFFF) ? 0xFFFF : (uint16_t)delta;
+    
+    last_ts = ts;
+    
+    frame_put(&ticks, 2);
+}
+#endif
+
 int main(void)
 {
+    clock_init();
+    
     spi_init();
     
     interrupt_init();
@@ -36,101 +113,118 @@ int main(void)
     
     usartd0_init();
     
-    uint8_t xyz_data[6];
+    attitude_init(&att, ATT_GYRO_K(GYRO_UDPS_PER_LSB, GYRO_ODR_HZ), ACCEL_ONE_G);
+    
+    int16_t rpy[3];
+    
+#ifdef SPI_USART_MSPI
+    // data-ready edges reach the dma controller through the event system,
+    // which fills the ring without taking an interrupt per sample
+    static lsm6ds3_stream_rec_t ring[GYRO_STREAM_RING];
+    lsm6ds3_data_t sample;
+    
+    lsm6ds3_stream_start(ring, GYRO_STREAM_RING, EVSYS_CHMUX_PORTC_PIN7_gc);
     
     while(1)
     {
-        if(gyro_flag)
+        if(lsm6ds3_stream_read(&sample))
         {
-            // load from register using lsmread
-            xyz_data[0] = lsm6ds3_read(OUTX_L_G);
-            xyz_data[1] = lsm6ds3_read(OUTX_H_G);
-            xyz_data[2]  = lsm6ds3_read(OUTY_L_G);
-            xyz_data[3] = lsm6ds3_read(OUTY_H_G);
-            xyz_data[4]  =  lsm6ds3_read(OUTZ_L_G);
-            xyz_data[5] =  lsm6ds3_read(OUTZ_H_G);
+            attitude_update(&att, &sample.word.gyro_x, &sample.word.accel_x);
+            attitude_get(&att, rpy);
             
-            usartd0_out_string((const char*) xyz_data);
-    
-            gyro_flag = 0;
+            frame_send(FRAME_TYPE_ATTITUDE, rpy, sizeof(rpy));
         }
     }
+#endif
     
-    while(1);
-    
-    return 0;
-}
-
-
-void spi_init(void)
-{
-    PORTF.OUTSET = SS_bm;                               // SS idles high in mode3
-    PORTF.DIRSET = (SS_bm | MOSI_bm | SCK_bm);          // SS, MOSI, SCK outputs
-    PORTF.DIRCLR = (MISO_bm);                           // MISO input
-    
-    // DORD is pin 5, defaulted to zero = MSB first, prescaler 4 gives 8MHz frequency
-    SPIF.CTRL   =   SPI_PRESCALER_DIV4_gc           |   
-                        SPI_MASTER_bm               |   
-                        SPI_MODE_3_gc               |   
-                        SPI_ENABLE_bm;
-}
-
-void spi_write(uint8_t data)
-{
-    /* Write to the relevant DATA register. */
-    SPIF.DATA = data;
-
-    /* Wait for relevant transfer to complete. */
-    while(!(SPIF.STATUS & (1 << 7)));
-}
-
-uint8_t spi_read(void)
-{
-  /* Write some arbitrary data to initiate a transfer. */
-  SPIF.DATA = 0x37;
-
-  /* Wait for relevant transfer to be complete. */
-  while(!(SPIF.STATUS & (1 << 7)));
-
-    /* After the transmission, return the data that was received. */
-    return SPIF.DATA;
-}
-
-void lsm6ds3_write(uint8_t reg_addr, uint8_t data)
-{
-    // enable slave (pull ss low)
-    PORTF.OUTCLR = SS_bm;
+    // ping-pong buffers: one is clocked in over spi while the other is filtered.
+    // samples are gyro x, y, z followed by accel x, y, z in both modes, then
+    // the timestamp data set (fifo) or bytes (registers) with GYRO_TIMESTAMP
+    spi_xfer_t xfer;
+#if GYRO_TIMESTAMP && !GYRO_FIFO_BATCH
+    spi_xfer_t ts_xfer;
     
-    // enable the lsm6ds3 via the relevant chip select signal
-    uint8_t var2 = (reg_addr | LSM6DS3_SPI_WRITE_STROBE_bm);
+    ts_xfer.busy = 0;
+#endif
+    int16_t xyz_data[2][XYZ_WORDS];
+    uint16_t xyz_words[2] = {0, 0};
+    uint8_t fill = 0;
     
-    // write desired address of lsm
-    spi_write(var2);
+    xfer.busy = 0;
     
-    // write data to lsm
-    spi_write(data);
+    while(1)
+    {
+        // the interrupt line is a level (fifo over the watermark, or data
+        // ready) but only its rising edge interrupts. if more was waiting
+        // than one read takes, the line is still high once that read has
+        // landed and no edge will come, so read again
+        if(!xfer.busy && (PORTC.IN & PIN7_bm))
+        {
+            gyro_flag = 1;
+        }
+        
+        if(gyro_flag)
+        {
+            // clear first so an edge during the read is not lost
+            gyro_flag = 0;
+            
+            // the previous read has to land before its buffer is sent
+            spi_wait(&xfer);
+            
+#if GYRO_FIFO_BATCH
+            // read the whole batch in one burst
+            xyz_words[fill] = lsm6ds3_fifo_available(XYZ_WORDS, GYRO_SET_WORDS);
+            lsm6ds3_read_burst_async(&xfer, FIFO_DATA_OUT_L, (uint8_t *)xyz_data[fill], xyz_words[fill] << 1);
+#else
+            // load all twelve output registers in one burst (IF_INC is set)
+            xyz_words[fill] = 6;
+            lsm6ds3_read_burst_async(&xfer, OUTX_L_G, (uint8_t *)xyz_data[fill], 12);
+    #if GYRO_TIMESTAMP
+            // queued right behind the data, so it is read a few us later
+            spi_wait(&ts_xfer);
+            lsm6ds3_read_burst_async(&ts_xfer, TIMESTAMP0_REG, (uint8_t *)&xyz_data[fill][6], 3);
+    #endif
+#endif
+            
+            // run the previous buffer through the filter while this one is read,
+            // then send the attitude once per buffer
+            fill ^= 1;
+            
+            for(uint16_t i = 0; i < xyz_words[fill]; i += GYRO_SET_WORDS)
+            {
+                attitude_update(&att, &xyz_data[fill][i], &xyz_data[fill][i + 3]);
+            }
+            
+            if(xyz_words[fill])
+            {
+                attitude_get(&att, rpy);
+                
+#if GYRO_TIMESTAMP
+                frame_begin(FRAME_TYPE_ATTITUDE_TS);
+                frame_put(rpy, sizeof(rpy));
+    #if GYRO_FIFO_BATCH
+                // stamped with the last sample of the batch
+                gyro_out_timestamp(lsm6ds3_fifo_timestamp(&xyz_data[fill][xyz_words[fill] - 3]));
+    #else
+                uint8_t * ts = (uint8_t *)&xyz_data[fill][6];
+                
+                gyro_out_timestamp(((uint32_t)ts[2] << 16) | ((uint16_t)ts[1] << 8) | ts[0]);
+    #endif
+                frame_end();
+#else
+                frame_send(FRAME_TYPE_ATTITUDE, rpy, sizeof(rpy));
+#endif
+            }
+            
+            xyz_words[fill] = 0;
+        }
+    }
     
-    // disable slave (pull ss high)
-    PORTF.OUTSET = SS_bm;
+    while(1);
     
+    return 0;
 }
 
-// returns a single byte of data from an LSM6SD3 register
-// associated with the address `reg_addr`
-uint8_t lsm6ds3_read(uint8_t reg_addr)
-{
-    PORTF.OUTCLR = SS_bm;           // enables cs/ss. idles high, active low
-    
-    uint8_t var3 = (reg_addr | LSM6DS3_SPI_READ_STROBE_bm);
-    
-    spi_write(var3);
-    
-    uint8_t var4 = spi_read();
-    
-    PORTF.OUTSET = SS_bm;           // disable ss. set it to idling high.
-    
-    return var4;
-}
 
 void interrupt_init(void)
 {
@@ -144,7 +238,9 @@ void interrupt_init(void)
     
     // set as low level priority interrupt
     //PORTC.INTCTRL = 0b00000001;
+#ifndef SPI_USART_MSPI
     PORTC.INTCTRL = PORT_INT1LVL_LO_gc;
+#endif
     
     // set interrupt to trigger when PC6 at rising edge
     //PORTC.PIN6CTRL = 0b00000001;
@@ -166,14 +262,43 @@ void lsm6ds3_init(void)
     // reset LSM6DS3 by setting CTRL3 bit 0 (SW_RESET) to 1. also, keep bit 2 (IF_INC) its default value of 1
     lsm6ds3_write(CTRL3_C, 0b00000101);
     
+#if GYRO_FIFO_BATCH
+    // configure CTRL2_G, choose 1.66kHz, choose full-scale at 125 dps
+    lsm6ds3_write(CTRL2_G,  0b10000010);
+#else
     // configure CTRL2_G, choose 208Hz, choose full-scale at 125 dps
     lsm6ds3_write(CTRL2_G,  0b01010010);
+#endif
     
     // enable Z,Y,X for gyrosocope 
     lsm6ds3_write(CTRL10_C, 0b00111000);
     
+    // accelerometer at the same rate as the gyro, for the attitude filter. +/-2g
+    lsm6ds3_write(CTRL9_XL, 0b00111000);            // enable X, Y, Z
+#if GYRO_FIFO_BATCH
+    lsm6ds3_write(CTRL1_XL, 0b10000000);            // 1.66kHz
+#else
+    lsm6ds3_write(CTRL1_XL, 0b01010000);            // 208Hz
+#endif
+    
+#if GYRO_TIMESTAMP
+    // 25us timestamp counter, read alongside every sample
+    lsm6ds3_timestamp_init(1);
+#endif
+    
+#if GYRO_FIFO_BATCH && GYRO_TIMESTAMP
+    // batch gyro + accel samples in the fifo with the timestamp stored next to
+    // every sample, interrupt on INT2 at the watermark
+    lsm6ds3_fifo_init(GYRO_FIFO_BATCH * GYRO_SET_WORDS, LSM6DS3_FIFO_DEC_G_NONE_gc | LSM6DS3_FIFO_DEC_XL_NONE_gc | LSM6DS3_FIFO_DEC_DS4_NONE_gc, LSM6DS3_FIFO_ODR_1660HZ_gc);
+    lsm6ds3_write(INT2_CTRL, LSM6DS3_INT_FTH_bm);   // fifo watermark set
+#elif GYRO_FIFO_BATCH
+    // batch gyro + accel samples in the fifo, interrupt on INT2 at the watermark
+    lsm6ds3_fifo_init(GYRO_FIFO_BATCH * 6, LSM6DS3_FIFO_DEC_G_NONE_gc | LSM6DS3_FIFO_DEC_XL_NONE_gc, LSM6DS3_FIFO_ODR_1660HZ_gc);
+    lsm6ds3_write(INT2_CTRL, LSM6DS3_INT_FTH_bm);   // fifo watermark set
+#else
     // configure INT2_CTRL
     lsm6ds3_write(INT2_CTRL, 0b00000010);   // gyroscope set
+#endif
     
 }
 
@@ -186,48 +311,4 @@ ISR(PORTC_INT1_vect)
     gyro_flag = 1;
 }
 
-
-
-void usartd0_init(void)
-{
-  /* Configure relevant TxD and RxD pins. */
-    PORTD.OUTSET = PIN3_bm;
-    PORTD.DIRSET = PIN3_bm;
-    PORTD.DIRCLR = PIN2_bm;
-
-  /* Configure baud rate. *//* At 2 MHz SYSclk, 5 BSEL, -6 BSCALE corresponds to 115200 bps */
-    USARTD0.BAUDCTRLA = (uint8_t)BSEL;
-    USARTD0.BAUDCTRLB = (uint8_t)((BSCALE << 4)|(BSEL >> 8));
-
-  /* Configure remainder of serial protocol. */
-  /* (In this example, a protocol with 8 data bits, no parity, and
-   *  one stop bit is chosen.) */
-    USARTD0.CTRLC = (USART_CMODE_ASYNCHRONOUS_gc |
-                     USART_PMODE_DISABLED_gc     |
-                     USART_CHSIZE_8BIT_gc)       &
-                    ~USART_SBMODE_bm;
-
-  /* Enable receiver and/or transmitter systems. */
-    USARTD0.CTRLB = USART_RXEN_bm | USART_TXEN_bm;
-
-  /* Enable interrupt (optional). */
-    /* USARTD0.CTRLA = USART_RXCINTLVL_MED_gc; */
-}
-
-void usartd0_out_char(char c)
-{
-    while(!(USARTD0.STATUS & USART_DREIF_bm));
-    USARTD0.DATA = c;
-}
-
-void usartd0_out_string(const char * str)
-{
-    for(uint8_t i = 0; i < 6; i++)
-    {
-        usartd0_out_char(str[i]);
-    }
-    
-    //while(*str) usartd0_out_char(*(str++));
-}
-
 /***************************END OF FUNCTION DEFINITIONS************************/
\ No newline at end of file
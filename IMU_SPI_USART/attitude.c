@@ -0,0 +1,163 @@
+/*------------------------------------------------------------------------------
+  attitude.c --
+
+  Description:
+    Fixed-point complementary filter for the LSM6DS3. See `attitude.h`.
+
+------------------------------------------------------------------------------*/
+
+/********************************DEPENDENCIES**********************************/
+
+#include <stdint.h>
+#include "attitude.h"
+
+/*****************************END OF DEPENDENCIES******************************/
+
+
+/*****************************FUNCTION DEFINITIONS*****************************/
+
+// returns atan(num / den) as a BAM angle, for 0 <= num <= den (so the
+// result is within 0..8192, i.e. 0..45 degrees). uses
+// atan(z) ~= pi/4 z + z (1 - z) (0.2447 + 0.0663 z), good to about 0.1 deg,
+// with the coefficients converted to BAM: 8192, 2552 and 692.
+static uint16_t attitude_atan_unit(uint32_t num, uint32_t den)
+{
+    uint16_t z = (uint16_t)((num << 15) / den);                 // Q15, 0..1
+    uint16_t t = (uint16_t)(((uint32_t)z * (32768 - z)) >> 15);  // z (1 - z)
+    uint16_t c = 2552 + (uint16_t)(((uint32_t)692 * z) >> 15);
+
+    return (z >> 2) + (uint16_t)(((uint32_t)t * c) >> 15);
+}
+
+// returns atan2(y, x) as a BAM angle. |x| and |y| must be below 2^16.
+uint16_t attitude_atan2(int32_t y, int32_t x)
+{
+    uint32_t ax = (x < 0) ? -x : x;
+    uint32_t ay = (y < 0) ? -y : y;
+    uint16_t angle;
+
+    if(ax == 0 && ay == 0)
+    {
+        return 0;
+    }
+
+    // fold into the first octant
+    if(ay <= ax)
+    {
+        angle = attitude_atan_unit(ay, ax);
+    }
+    else
+    {
+        angle = 16384 - attitude_atan_unit(ax, ay);
+    }
+
+    // then unfold into the right quadrant
+    if(x < 0)
+    {
+        angle = 32768 - angle;
+    }
+
+    if(y < 0)
+    {
+        angle = -angle;
+    }
+
+    return angle;
+}
+
+// returns floor(sqrt(x)).
+uint16_t attitude_isqrt(uint32_t x)
+{
+    uint32_t root = 0;
+    uint32_t bit = (uint32_t)1 << 30;
+
+    while(bit > x)
+    {
+        bit >>= 2;
+    }
+
+    while(bit)
+    {
+        if(x >= root + bit)
+        {
+            x -= root + bit;
+            root = (root >> 1) + bit;
+        }
+        else
+        {
+            root >>= 1;
+        }
+
+        bit >>= 2;
+    }
+
+    return (uint16_t)root;
+}
+
+// resets `att` to level with zero heading. `gyro_k` comes from ATT_GYRO_K for
+// the configured gyro range and ODR; `one_g` is 1 g in accelerometer LSBs.
+// accelerometer samples further than 0.25 g from 1 g in magnitude are
+// treated as dominated by motion and ignored.
+void attitude_init(attitude_t * att, int32_t gyro_k, int16_t one_g)
+{
+    uint32_t g_sq = (uint32_t)one_g * one_g;
+
+    att->roll = 0;
+    att->pitch = 0;
+    att->yaw = 0;
+
+    att->gyro_k = gyro_k;
+    att->g_sq_min = (g_sq >> 4) * 9;        // (0.75 g)^2
+    att->g_sq_max = (g_sq >> 4) * 25;       // (1.25 g)^2
+    att->decim = 0;
+}
+
+// pulls `angle` 2^-ATT_ACCEL_SHIFT of the way towards `target`.
+static void attitude_correct(uint32_t * angle, uint16_t target)
+{
+    int16_t err = (int16_t)(target - (uint16_t)(*angle >> 16));
+
+    *angle += (uint32_t)((int32_t)err * ((int32_t)1 << (16 - ATT_ACCEL_SHIFT)));
+}
+
+// advances the filter by one sample. `gyro` and `accel` each point to x, y, z
+// in raw LSBs, i.e. the layout of the LSM6DS3 output registers and FIFO.
+void attitude_update(attitude_t * att, const int16_t * gyro, const int16_t * accel)
+{
+    // integrate body rates; Q8 product, so drop 8 bits
+    att->roll  += (uint32_t)(((int32_t)gyro[0] * att->gyro_k) >> 8);
+    att->pitch += (uint32_t)(((int32_t)gyro[1] * att->gyro_k) >> 8);
+    att->yaw   += (uint32_t)(((int32_t)gyro[2] * att->gyro_k) >> 8);
+
+    if(++att->decim < ATT_ACCEL_DECIM)
+    {
+        return;
+    }
+
+    att->decim = 0;
+
+    int32_t ax = accel[0];
+    int32_t ay = accel[1];
+    int32_t az = accel[2];
+
+    uint32_t yz_sq = (uint32_t)(ay * ay) + (uint32_t)(az * az);
+    uint32_t g_sq = yz_sq + (uint32_t)(ax * ax);
+
+    if(g_sq < att->g_sq_min || g_sq > att->g_sq_max)
+    {
+        return;
+    }
+
+    attitude_correct(&att->roll, attitude_atan2(ay, az));
+    attitude_correct(&att->pitch, attitude_atan2(-ax, attitude_isqrt(yz_sq)));
+}
+
+// writes roll, pitch and yaw to `rpy` as signed BAM angles (+/-32768 = 180 deg).
+void attitude_get(const attitude_t * att, int16_t * rpy)
+{
+    rpy[0] = (int16_t)(att->roll >> 16);
+    rpy[1] = (int16_t)(att->pitch >> 16);
+    rpy[2] = (int16_t)(att->yaw >> 16);
+}
+
+/***************************END OF FUNCTION DEFINITIONS************************/
@@ -0,0 +1,78 @@
+#ifndef ATTITUDE_H_  // Header guard.
+#define ATTITUDE_H_
+
+/*------------------------------------------------------------------------------
+  attitude.h --
+
+  Description:
+    Provides a fixed-point complementary filter that turns LSM6DS3 gyroscope
+    and accelerometer samples into roll, pitch and yaw angles on the device.
+
+      Angles are binary angles (BAM): the full int16_t/uint16_t range spans
+    one turn, so 65536 counts = 360 degrees and wrap-around is free. Gyro
+    rates are integrated every sample; roll and pitch are pulled towards the
+    gravity vector every ATT_ACCEL_DECIM samples. Yaw has no absolute
+    reference and is gyro-only. Euler rates are approximated by body rates,
+    which holds while roll and pitch stay moderate.
+
+      Only integer arithmetic is used, so the code runs unchanged on the
+    AVR and on a host.
+
+------------------------------------------------------------------------------*/
+
+/********************************DEPENDENCIES**********************************/
+
+#include <stdint.h>
+
+/*****************************END OF DEPENDENCIES******************************/
+
+
+/***********************************MACROS*************************************/
+
+/* Accelerometer correction runs once every ATT_ACCEL_DECIM updates. */
+#define ATT_ACCEL_DECIM         8
+
+/* Each correction moves roll/pitch 2^-ATT_ACCEL_SHIFT of the way towards the
+ * accelerometer estimate. At 1.66 kHz and ATT_ACCEL_DECIM 8 the default gives
+ * a time constant of about 1.2 s. */
+#define ATT_ACCEL_SHIFT         8
+
+/* Gyro scale for `attitude_init`: BAM increment per LSB per sample in Q8,
+ * from the gyro sensitivity in micro-degrees per second per LSB (e.g. 4375
+ * for the 125 dps range) and the output data rate in Hz. */
+#define ATT_GYRO_K(udps_per_lsb, odr_hz) \
+    ((int32_t)((((uint64_t)(udps_per_lsb) << 40) + 180000000ULL * (odr_hz)) / (360000000ULL * (odr_hz))))
+
+/********************************END OF MACROS*********************************/
+
+
+/*******************************CUSTOM DATA TYPES******************************/
+
+/* Filter state. Angles are BAM in Q16.16, so `roll >> 16` is the BAM angle. */
+typedef struct attitude
+{
+  uint32_t roll, pitch, yaw;
+
+  int32_t gyro_k;
+  uint32_t g_sq_min, g_sq_max;
+  uint8_t decim;
+}attitude_t;
+
+/***************************END OF CUSTOM DATA TYPES***************************/
+
+
+/*****************************FUNCTION PROTOTYPES******************************/
+
+void attitude_init(attitude_t * att, int32_t gyro_k, int16_t one_g);
+
+void attitude_update(attitude_t * att, const int16_t * gyro, const int16_t * accel);
+
+void attitude_get(const attitude_t * att, int16_t * rpy);
+
+uint16_t attitude_atan2(int32_t y, int32_t x);
+
+uint16_t attitude_isqrt(uint32_t x);
+
+/**************************END OF FUNCTION PROTOTYPES**************************/
+
+#endif // End of header guard.
@@ -0,0 +1,55 @@
+/*------------------------------------------------------------------------------
+  clock.c --
+  
+  Description:
+    System clock setup for the ATxmega128A1U. See `clock.h`.
+
+------------------------------------------------------------------------------*/
+
+/********************************DEPENDENCIES**********************************/
+
+#include <avr/io.h>
+#include <avr/xmega.h>
+#include "clock.h"
+
+/*****************************END OF DEPENDENCIES******************************/
+
+
+/*****************************FUNCTION DEFINITIONS*****************************/
+
+#ifdef CLOCK_DFLL
+// starts the 32.768 kHz oscillator the DFLLs use as their reference
+static void clock_rc32k_start(void)
+{
+    OSC.CTRL |= OSC_RC32KEN_bm;
+    while(!(OSC.STATUS & OSC_RC32KRDY_bm));
+}
+#endif
+
+void clock_init(void)
+{
+#if F_CPU == 32000000UL
+    OSC.CTRL |= OSC_RC32MEN_bm;
+    while(!(OSC.STATUS & OSC_RC32MRDY_bm));
+    
+#ifdef CLOCK_DFLL
+    clock_rc32k_start();
+    OSC.DFLLCTRL = (OSC.DFLLCTRL & ~OSC_RC32MCREF_gm) | OSC_RC32MCREF_RC32K_gc;
+    DFLLRC32M.CTRL = DFLL_ENABLE_bm;
+#endif
+    
+    // CLK.CTRL is change protected; the prescalers stay at their 1:1 reset value
+    _PROTECTED_WRITE(CLK.CTRL, CLK_SCLKSEL_RC32M_gc);
+    
+    // the 2 MHz oscillator is no longer needed
+    OSC.CTRL &= ~OSC_RC2MEN_bm;
+#else
+#ifdef CLOCK_DFLL
+    clock_rc32k_start();
+    OSC.DFLLCTRL &= ~OSC_RC2MCREF_bm;
+    DFLLRC2M.CTRL = DFLL_ENABLE_bm;
+#endif
+#endif
+}
+
+/***************************END OF FUNCTION DEFINITIONS************************/
@@ -0,0 +1,58 @@
+#ifndef CLOCK_H_    // Header guard.
+#define CLOCK_H_
+
+/*------------------------------------------------------------------------------
+  clock.h --
+  
+  Description:
+    Provides the system clock setup shared by all of the apps, and the
+    F_CPU that the baud rate, timer and ADC settings are derived from at
+    compile time.
+
+      F_CPU is 32000000 (internal 32 MHz oscillator) unless defined for the
+    whole project; 2000000 keeps the 2 MHz oscillator the part resets to.
+    Defining CLOCK_DFLL also enables the DFLL of the selected oscillator,
+    which trims it against the internal 32.768 kHz oscillator to well
+    under 1% over temperature and supply (the factory calibration alone is
+    only specified to a few percent, which matters at multi-Mbps baud).
+
+------------------------------------------------------------------------------*/
+
+/********************************DEPENDENCIES**********************************/
+
+#include <avr/io.h>
+
+/*****************************END OF DEPENDENCIES******************************/
+
+
+/***********************************MACROS*************************************/
+
+#ifndef F_CPU
+#define F_CPU   32000000UL
+#endif
+
+#if F_CPU != 32000000UL && F_CPU != 2000000UL
+#error "F_CPU must be 32000000 or 2000000 (see clock.h)"
+#endif
+
+/********************************END OF MACROS*********************************/
+
+
+/*****************************FUNCTION PROTOTYPES******************************/
+
+/*------------------------------------------------------------------------------
+  clock_init -- 
+  
+  Description:
+    Switches the system clock to the oscillator selected by F_CPU, with
+    no prescaling, and starts its DFLL if CLOCK_DFLL is defined. To be
+    called first thing in `main`, before any peripheral is configured.
+
+  Input(s): N/A
+  Output(s): N/A
+------------------------------------------------------------------------------*/
+void clock_init(void);
+
+/**************************END OF FUNCTION PROTOTYPES**************************/
+
+#endif // End of header guard.
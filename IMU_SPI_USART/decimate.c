@@ -0,0 +1,130 @@
+/*------------------------------------------------------------------------------
+  decimate.c --
+
+  Description:
+    Oversample-and-decimate stage for ADC results. See `decimate.h`.
+
+------------------------------------------------------------------------------*/
+
+/********************************DEPENDENCIES**********************************/
+
+#include <stdint.h>
+#include "decimate.h"
+
+/*****************************END OF DEPENDENCIES******************************/
+
+
+/*****************************FUNCTION DEFINITIONS*****************************/
+
+// scales a filter output with a gain of 2^gain_bits to Q4, rounding, and
+// saturates it to int16
+static int16_t decimate_q4(int32_t y, uint8_t gain_bits)
+{
+    if(gain_bits > 4)
+    {
+        uint8_t s = gain_bits - 4;
+
+        y = (y + ((int32_t)1 << (s - 1))) >> s;
+    }
+    else
+    {
+        y *= (int32_t)1 << (4 - gain_bits);
+    }
+
+    if(y > INT16_MAX)
+    {
+        return INT16_MAX;
+    }
+
+    if(y < INT16_MIN)
+    {
+        return INT16_MIN;
+    }
+
+    return (int16_t)y;
+}
+
+void decimate_init(decimate_t * dec, uint8_t bits, uint8_t filter)
+{
+    dec->bits = (bits > DECIMATE_BITS_MAX) ? DECIMATE_BITS_MAX : bits;
+    dec->filter = filter;
+    dec->count = 0;
+    dec->integ[0] = dec->integ[1] = 0;
+    dec->comb[0] = dec->comb[1] = 0;
+    dec->primed = 0;
+    dec->hist_sum = 0;
+    dec->hist_pos = 0;
+}
+
+uint8_t decimate_push(decimate_t * dec, int16_t x, int16_t * out)
+{
+    // each extra bit is two bits of decimation, 4^n = 2^(2n)
+    uint8_t log2_r = dec->bits * 2;
+    int32_t y;
+
+    dec->integ[0] += (uint32_t)(int32_t)x;
+
+    if(dec->filter == DECIMATE_CIC2)
+    {
+        dec->integ[1] += dec->integ[0];
+    }
+
+    if(++dec->count < ((uint16_t)1 << log2_r))
+    {
+        return 0;
+    }
+
+    dec->count = 0;
+
+    if(dec->filter == DECIMATE_CIC2)
+    {
+        // two combs at the output rate; gain R^2
+        uint32_t c1 = dec->integ[1] - dec->comb[0];
+        uint32_t c2 = c1 - dec->comb[1];
+
+        dec->comb[0] = dec->integ[1];
+        dec->comb[1] = c1;
+
+        // the combs hold nothing sensible until their second output
+        if(!dec->primed)
+        {
+            dec->primed = 1;
+            return 0;
+        }
+
+        *out = decimate_q4((int32_t)c2, 2 * log2_r);
+        return 1;
+    }
+
+    // boxcar: the sum since the last output; gain R
+    y = (int32_t)dec->integ[0];
+    dec->integ[0] = 0;
+
+    if(dec->filter == DECIMATE_MAVG)
+    {
+        // start from a full history of the first output, not from zeros
+        if(!dec->primed)
+        {
+            for(uint8_t i = 0; i < DECIMATE_MAVG_LEN; i++)
+            {
+                dec->hist[i] = y;
+            }
+
+            dec->hist_sum = y * DECIMATE_MAVG_LEN;
+            dec->primed = 1;
+        }
+
+        dec->hist_sum += y - dec->hist[dec->hist_pos];
+        dec->hist[dec->hist_pos] = y;
+        dec->hist_pos = (dec->hist_pos + 1) & (DECIMATE_MAVG_LEN - 1);
+
+        y = dec->hist_sum;
+        *out = decimate_q4(y, log2_r + DECIMATE_MAVG_SHIFT);
+        return 1;
+    }
+
+    *out = decimate_q4(y, log2_r);
+    return 1;
+}
+
+/***************************END OF FUNCTION DEFINITIONS************************/
@@ -0,0 +1,107 @@
+#ifndef DECIMATE_H_  // Header guard.
+#define DECIMATE_H_
+
+/*------------------------------------------------------------------------------
+  decimate.h --
+
+  Description:
+    Provides an oversample-and-decimate stage for 12-bit ADC results:
+    every 4^n conversions are combined into one output with n more bits of
+    resolution, provided the input carries at least about 1 LSB of noise
+    (the AVR121 scheme).
+
+      Outputs are always in 1/16 LSB of the 12-bit ADC (Q4), whatever n
+    is, so their scale does not change with the decimation; the bits below
+    12 + n are the rounding of the filter. n is at most DECIMATE_BITS_MAX.
+
+    Filters:
+      DECIMATE_BOXCAR  sum of the 4^n conversions (sinc)
+      DECIMATE_CIC2    two stage CIC (sinc^2): better rejection of what
+                       would alias, at the cost of a longer response; the
+                       first output after `decimate_init` is swallowed
+      DECIMATE_MAVG    boxcar outputs further averaged over the last
+                       DECIMATE_MAVG_LEN of them, at the same output rate
+
+      Only integer arithmetic is used, so the code runs unchanged on the
+    AVR and on a host.
+
+------------------------------------------------------------------------------*/
+
+/********************************DEPENDENCIES**********************************/
+
+#include <stdint.h>
+
+/*****************************END OF DEPENDENCIES******************************/
+
+
+/***********************************MACROS*************************************/
+
+/* Extra bits; 4^4 = 256 conversions per output at most. */
+#define DECIMATE_BITS_MAX       4
+
+/* Outputs averaged by DECIMATE_MAVG (a power of two). */
+#define DECIMATE_MAVG_LEN       4
+#define DECIMATE_MAVG_SHIFT     2
+
+/* Filters. */
+#define DECIMATE_BOXCAR         0
+#define DECIMATE_CIC2           1
+#define DECIMATE_MAVG           2
+
+/********************************END OF MACROS*********************************/
+
+
+/*******************************CUSTOM DATA TYPES******************************/
+
+/* Decimator state. The integrators wrap modulo 2^32, which the combs undo. */
+typedef struct decimate
+{
+  uint8_t bits;
+  uint8_t filter;
+  uint16_t count;
+
+  uint32_t integ[2];
+  uint32_t comb[2];
+  uint8_t primed;
+
+  int32_t hist[DECIMATE_MAVG_LEN];
+  int32_t hist_sum;
+  uint8_t hist_pos;
+}decimate_t;
+
+/***************************END OF CUSTOM DATA TYPES***************************/
+
+
+/*****************************FUNCTION PROTOTYPES******************************/
+
+/*------------------------------------------------------------------------------
+  decimate_init -- 
+  
+  Description:
+    Resets a decimator to 4^`bits` conversions per output through
+    `filter` (DECIMATE_*). `bits` above DECIMATE_BITS_MAX is clamped.
+
+  Input(s): `dec`    - Decimator.
+            `bits`   - Extra bits of resolution.
+            `filter` - Filter.
+  Output(s): N/A
+------------------------------------------------------------------------------*/
+void decimate_init(decimate_t * dec, uint8_t bits, uint8_t filter);
+
+/*------------------------------------------------------------------------------
+  decimate_push -- 
+  
+  Description:
+    Adds one conversion. Once every 4^`bits` conversions an output is
+    ready, in 1/16 LSB.
+
+  Input(s): `dec` - Decimator.
+            `x`   - 12-bit ADC result.
+            `out` - Where an output is stored.
+  Output(s): 1 if `*out` was written, 0 otherwise.
+------------------------------------------------------------------------------*/
+uint8_t decimate_push(decimate_t * dec, int16_t x, int16_t * out);
+
+/**************************END OF FUNCTION PROTOTYPES**************************/
+
+#endif // End of header guard.
@@ -0,0 +1,123 @@
+/*------------------------------------------------------------------------------
+  frame.c --
+  
+  Description:
+    COBS framing with a sequence number and a hardware CRC-16 for records
+    sent over USARTD0. See `frame.h`.
+
+------------------------------------------------------------------------------*/
+
+/********************************DEPENDENCIES**********************************/
+
+#include <avr/io.h>
+#include "frame.h"
+#include "usart.h"
+
+/*****************************END OF DEPENDENCIES******************************/
+
+
+/***********************************MACROS*************************************/
+
+/* A COBS block is a code byte followed by up to 254 non-zero bytes. */
+#define FRAME_BLOCK_MAX     255
+
+/********************************END OF MACROS*********************************/
+
+
+/******************************GLOBAL VARIABLES********************************/
+
+/* The COBS block being collected; `frame_block[0]` receives its code. */
+static uint8_t frame_block[FRAME_BLOCK_MAX];
+static uint8_t frame_block_len = 1;
+
+static uint8_t frame_seq = 0;
+
+/***************************END OF GLOBAL VARIABLES****************************/
+
+
+/*****************************FUNCTION DEFINITIONS*****************************/
+
+/* Sends the collected block with its code byte and starts a new one. */
+static void frame_flush(void)
+{
+    frame_block[0] = frame_block_len;
+    
+    for(uint8_t i = 0; i < frame_block_len; i++)
+    {
+        usartd0_out_char(frame_block[i]);
+    }
+    
+    frame_block_len = 1;
+}
+
+/* COBS encodes one byte. */
+static void frame_encode(uint8_t data)
+{
+    if(data == 0)
+    {
+        frame_flush();
+        return;
+    }
+    
+    frame_block[frame_block_len++] = data;
+    
+    if(frame_block_len == FRAME_BLOCK_MAX)
+    {
+        frame_flush();
+    }
+}
+
+/* Encodes one byte and feeds it to the CRC. */
+static void frame_byte(uint8_t data)
+{
+    CRC.DATAIN = data;
+    frame_encode(data);
+}
+
+void frame_begin(uint8_t type)
+{
+    // reset the checksum to 0xffff, then take bytes from DATAIN
+    CRC.CTRL = CRC_RESET_RESET1_gc;
+    CRC.CTRL = CRC_SOURCE_IO_gc;
+    
+    frame_block_len = 1;
+    
+    frame_byte(type);
+    frame_byte(frame_seq++);
+}
+
+void frame_put(const void * data, uint16_t len)
+{
+    const uint8_t * bytes = (const uint8_t *)data;
+    
+    while(len--)
+    {
+        frame_byte(*bytes++);
+    }
+}
+
+void frame_end(void)
+{
+    // writing BUSY ends the calculation and makes the checksum readable
+    CRC.STATUS = CRC_BUSY_bm;
+    
+    uint8_t crc_lo = CRC.CHECKSUM0;
+    uint8_t crc_hi = CRC.CHECKSUM1;
+    
+    CRC.CTRL = CRC_SOURCE_DISABLE_gc;
+    
+    frame_encode(crc_lo);
+    frame_encode(crc_hi);
+    frame_flush();
+    
+    usartd0_out_char(FRAME_DELIMITER);
+}
+
+void frame_send(uint8_t type, const void * data, uint16_t len)
+{
+    frame_begin(type);
+    frame_put(data, len);
+    frame_end();
+}
+
+/***************************END OF FUNCTION DEFINITIONS************************/
@@ -0,0 +1,121 @@
+#ifndef FRAME_H_    // Header guard.
+#define FRAME_H_
+
+/*------------------------------------------------------------------------------
+  frame.h --
+  
+  Description:
+    Provides a framing layer for binary records sent over USARTD0, so that a
+    host can find record boundaries, resynchronize after joining mid-stream
+    or losing bytes, and count dropped records.
+
+      Each frame is a record type, an 8-bit sequence number, the payload and
+    a CRC-16, COBS encoded and terminated by a 0x00 byte:
+
+        COBS( type | seq | payload ... | crc_lo | crc_hi ) | 0x00
+
+    COBS guarantees that 0x00 only ever appears as the terminator, so a host
+    resynchronizes at the next 0x00, i.e. within one frame. The sequence
+    number counts every frame sent, whatever its type; a gap on the host
+    side is the number of frames lost.
+
+      The CRC is computed over type, sequence number and payload by the CRC
+    module in CRC-16 mode, reset to 0xFFFF: CRC-16/CCITT-FALSE (polynomial
+    0x1021, no reflection, no final XOR). Multi-byte payload fields are
+    little-endian.
+
+      Frames go out through `usartd0_out_char`, and the CRC module is used
+    for the duration of a frame, so frames must only be built from one
+    context (the main loop in all of the apps).
+
+------------------------------------------------------------------------------*/
+
+/********************************DEPENDENCIES**********************************/
+
+#include <stdint.h>
+
+/*****************************END OF DEPENDENCIES******************************/
+
+
+/***********************************MACROS*************************************/
+
+/* Record types. */
+#define FRAME_TYPE_ADC_SAMPLE       0x01    // int16 ADC result in 1/16 LSB, repeated
+#define FRAME_TYPE_ADC_SWEEP        0x02    // int16 ADC CH0..CH3 results in 1/16 LSB, repeated
+#define FRAME_TYPE_ADC_STATS        0x03    // uint8 first channel, uint8 channels, uint16 results, then per
+                                            // channel int16 min, max, int32 sum, uint64 sum of squares
+#define FRAME_TYPE_ADC_SCOPE        0x04    // uint16 pre-trigger results, uint16 results, uint32 sample
+                                            // rate in Hz, then int16 results in 1/16 LSB
+#define FRAME_TYPE_ADC_RANGED       0x05    // uint8 first channel, uint8 channels, uint8 log2 gain per
+                                            // channel, padded to even, then int16 results in 1/16 LSB
+                                            // at that gain, repeated
+#define FRAME_TYPE_ADC_LOST         0x06    // uint16 ADC blocks dropped since the last such frame, uint16
+                                            // sweeps per block
+#define FRAME_TYPE_ACCEL            0x10    // int16 accel x, y, z, repeated
+#define FRAME_TYPE_ACCEL_TS         0x11    // as above, each followed by a uint16 timestamp delta
+#define FRAME_TYPE_EVENT            0x12    // 4-byte LSM6DS3 event record
+#define FRAME_TYPE_ATTITUDE         0x20    // int16 roll, pitch, yaw BAM angles
+#define FRAME_TYPE_ATTITUDE_TS      0x21    // as above, followed by a uint16 timestamp delta
+
+/* Frame terminator. */
+#define FRAME_DELIMITER             0x00
+
+/********************************END OF MACROS*********************************/
+
+
+/*****************************FUNCTION PROTOTYPES******************************/
+
+/*------------------------------------------------------------------------------
+  frame_begin -- 
+  
+  Description:
+    Starts a frame of record type `type`. The payload is then added with
+    `frame_put`, and the frame is completed by `frame_end`.
+
+  Input(s): `type` - Record type (FRAME_TYPE_*).
+  Output(s): N/A
+------------------------------------------------------------------------------*/
+void frame_begin(uint8_t type);
+
+/*------------------------------------------------------------------------------
+  frame_put -- 
+  
+  Description:
+    Appends `len` bytes from `data` to the payload of the current frame.
+    Encoded bytes are sent as soon as a COBS block is complete, so the
+    payload length is not limited.
+
+  Input(s): `data` - Payload bytes.
+            `len`  - Number of bytes.
+  Output(s): N/A
+------------------------------------------------------------------------------*/
+void frame_put(const void * data, uint16_t len);
+
+/*------------------------------------------------------------------------------
+  frame_end -- 
+  
+  Description:
+    Appends the CRC and sends the rest of the current frame, followed by the
+    delimiter.
+
+  Input(s): N/A
+  Output(s): N/A
+------------------------------------------------------------------------------*/
+void frame_end(void);
+
+/*------------------------------------------------------------------------------
+  frame_send -- 
+  
+  Description:
+    Sends a complete frame of record type `type` with a `len` byte payload.
+
+  Input(s): `type` - Record type (FRAME_TYPE_*).
+            `data` - Payload bytes.
+            `len`  - Number of bytes.
+  Output(s): N/A
+------------------------------------------------------------------------------*/
+void frame_send(uint8_t type, const void * data, uint16_t len);
+
+/**************************END OF FUNCTION PROTOTYPES**************************/
+
+#endif // End of header guard.
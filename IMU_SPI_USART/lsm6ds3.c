@@ -7,51 +7,419 @@
 /********************************DEPENDENCIES**********************************/
 
 #include <avr/io.h>
+#include <stddef.h>
 #include "spi.h"
 #include "lsm6ds3.h"
 #include "lsm6ds3_registers.h"
 
 /*****************************END OF DEPENDENCIES******************************/
 
+#ifdef SPI_USART_MSPI
+
+/******************************GLOBAL VARIABLES********************************/
+
+/* Ring being filled by `spi_stream_start`, the next record to hand out and
+ * the laps the reader has made around the ring (modulo 256), and the
+ * records overwritten before they were read. */
+static lsm6ds3_stream_rec_t * lsm6ds3_ring = NULL;
+static uint8_t lsm6ds3_ring_len = 0;
+static uint8_t lsm6ds3_ring_tail = 0;
+static uint8_t lsm6ds3_ring_laps = 0;
+static uint16_t lsm6ds3_ring_lost = 0;
+
+/***************************END OF GLOBAL VARIABLES****************************/
+
+#endif
+
 
 /*****************************FUNCTION DEFINITIONS*****************************/
 
+// points `xfer` at the LSM6DS3 chip select with `cmd` (register address
+// plus read/write strobe) as its only header byte and nothing to receive.
+static void lsm6ds3_xfer_setup(spi_xfer_t * xfer, uint8_t cmd)
+{
+    xfer->cs_port = &PORTF;
+    xfer->cs_bm = SS_bm;
+    
+    xfer->hdr[0] = cmd;
+    xfer->tx = xfer->hdr;
+    xfer->tx_len = 1;
+    
+    xfer->rx = NULL;
+    xfer->rx_len = 0;
+    
+    xfer->done = NULL;
+}
+
 // write a single byte of data, `data`, to the address
 // `reg_addr`, which is meant to be associated with an
 // LSM6DS3 register.
 void lsm6ds3_write(uint8_t reg_addr, uint8_t data)
 {
-    // enable slave (pull ss low)
-    PORTF.OUTCLR = SS_bm;                           
-    
-    // enable the lsm6ds3 via the relevant chip select signal
-    uint8_t var2 = (reg_addr | LSM6DS3_SPI_WRITE_STROBE_bm);
-    
-    // write desired address of lsm 
-    spi_write(var2);
-    
-    // write data to lsm
-    spi_write(data);
+    spi_xfer_t xfer;
     
-    // disable slave (pull ss high)
-    PORTF.OUTSET = SS_bm;
+    // address of lsm register followed by the data byte
+    lsm6ds3_xfer_setup(&xfer, reg_addr | LSM6DS3_SPI_WRITE_STROBE_bm);
+    xfer.hdr[1] = data;
+    xfer.tx_len = 2;
     
+    spi_transfer(&xfer);
 }
 
 // returns a single byte of data from an LSM6SD3 register
 // associated with the address `reg_addr`
 uint8_t lsm6ds3_read(uint8_t reg_addr)
 {
-    PORTF.OUTCLR = SS_bm;
+    uint8_t data;
+    
+    lsm6ds3_read_burst(reg_addr, &data, 1);
+    
+    return data;
+}
+
+// queues a read of `len` consecutive LSM6DS3 registers, starting at
+// `reg_addr`, into `buf` and returns without waiting. `xfer` and `buf` must
+// stay valid until `xfer->busy` clears (see `spi_wait`). relies on IF_INC
+// (CTRL3_C) being set so that the register address auto-increments.
+void lsm6ds3_read_burst_async(spi_xfer_t * xfer, uint8_t reg_addr, uint8_t * buf, uint16_t len)
+{
+    lsm6ds3_xfer_setup(xfer, reg_addr | LSM6DS3_SPI_READ_STROBE_bm);
+    xfer->rx = buf;
+    xfer->rx_len = len;
+    
+    spi_submit(xfer);
+}
+
+// reads `len` consecutive LSM6DS3 registers, starting at `reg_addr`,
+// into `buf` within a single SPI transaction.
+void lsm6ds3_read_burst(uint8_t reg_addr, uint8_t * buf, uint8_t len)
+{
+    spi_xfer_t xfer;
+    
+    lsm6ds3_read_burst_async(&xfer, reg_addr, buf, len);
+    spi_wait(&xfer);
+}
+
+// fills `data` with the gyroscope and accelerometer output registers
+// (OUTX_L_G through OUTZ_H_XL) in a single SPI transaction. the gyro
+// registers come first on the bus, so they are routed to the second half
+// of `lsm6ds3_data_raw_t` and the accel registers to the first half.
+void lsm6ds3_read_all(lsm6ds3_data_t * data)
+{
+    uint8_t raw[12];
+    uint8_t * gyro = &data->byte.gyro_x_low;
+    uint8_t * accel = &data->byte.accel_x_low;
+    
+    lsm6ds3_read_burst(OUTX_L_G, raw, 12);
+    
+    for(uint8_t i = 0; i < 6; i++)
+    {
+        gyro[i] = raw[i];
+        accel[i] = raw[i + 6];
+    }
+}
+
+// configures the LSM6DS3 FIFO in continuous mode. `watermark` is the FIFO
+// threshold in 16-bit words (FTH is 12 bits wide), `datasets` selects which
+// data sets are batched (low byte to FIFO_CTRL3, high byte to FIFO_CTRL4),
+// and `fifo_odr` is the ODR_FIFO group configuration. the FIFO is passed
+// through bypass mode first so that any stale contents are discarded.
+void lsm6ds3_fifo_init(uint16_t watermark, uint16_t datasets, uint8_t fifo_odr)
+{
+    uint8_t ctrl2 = (uint8_t)(watermark >> 8) & 0x0F;
+    
+    // the fourth data set only carries timestamp/step data when routed there
+    if(datasets >> 8)
+    {
+        ctrl2 |= LSM6DS3_TIMER_PEDO_FIFO_EN_bm;
+    }
+    
+    lsm6ds3_write(FIFO_CTRL5, LSM6DS3_FIFO_MODE_BYPASS_gc);
+    
+    lsm6ds3_write(FIFO_CTRL1, (uint8_t)watermark);
+    lsm6ds3_write(FIFO_CTRL2, ctrl2);
+    lsm6ds3_write(FIFO_CTRL3, (uint8_t)datasets);
+    lsm6ds3_write(FIFO_CTRL4, (uint8_t)(datasets >> 8));
+    
+    lsm6ds3_write(FIFO_CTRL5, fifo_odr | LSM6DS3_FIFO_MODE_CONTINUOUS_gc);
+}
+
+// returns FIFO_STATUS2 in the high byte and FIFO_STATUS1 in the low byte,
+// so the unread word count is `lsm6ds3_fifo_status() & LSM6DS3_FIFO_DIFF_gm`.
+uint16_t lsm6ds3_fifo_status(void)
+{
+    uint8_t status[2];
+    
+    lsm6ds3_read_burst(FIFO_STATUS1, status, 2);
+    
+    return ((uint16_t)status[1] << 8) | status[0];
+}
+
+// returns how many words can be drained from the FIFO right now: the
+// unread word count, capped at `max_words` and rounded down to whole data
+// sets of `set_words` words (3 for a single sensor, 6 for gyro + accel).
+uint16_t lsm6ds3_fifo_available(uint16_t max_words, uint8_t set_words)
+{
+    uint16_t words = lsm6ds3_fifo_status() & LSM6DS3_FIFO_DIFF_gm;
+    
+    if(words > max_words)
+    {
+        words = max_words;
+    }
+    
+    return words - (words % set_words);
+}
+
+// moves up to `max_words` words out of the FIFO and into `buf`, in whole
+// data sets of `set_words` words, and returns the number of words read.
+// the whole batch is read in one transaction: with IF_INC set, the register
+// pointer wraps from FIFO_DATA_OUT_H back to FIFO_DATA_OUT_L.
+uint16_t lsm6ds3_fifo_drain(int16_t * buf, uint16_t max_words, uint8_t set_words)
+{
+    spi_xfer_t xfer;
+    uint16_t words = lsm6ds3_fifo_available(max_words, set_words);
+    
+    lsm6ds3_read_burst_async(&xfer, FIFO_DATA_OUT_L, (uint8_t *)buf, words << 1);
+    spi_wait(&xfer);
+    
+    return words;
+}
+
+// returns the 24-bit timestamp held in a FIFO fourth data set (see
+// LSM6DS3_FIFO_DEC_DS4_NONE_gc). the LSM6DS3 lays those three words out as
+// TIMESTAMP[15:8], TIMESTAMP[23:16], unused, TIMESTAMP[7:0], STEP_COUNTER.
+uint32_t lsm6ds3_fifo_timestamp(const int16_t * set)
+{
+    const uint8_t * b = (const uint8_t *)set;
+    
+    return ((uint32_t)b[1] << 16) | ((uint16_t)b[0] << 8) | b[3];
+}
+
+// starts the timestamp counter from zero. `high_res` selects a 25us LSB
+// (wraps after ~7 minutes) instead of 6.4ms.
+void lsm6ds3_timestamp_init(uint8_t high_res)
+{
+    uint8_t dur = lsm6ds3_read(WAKE_UP_DUR) & ~LSM6DS3_TIMER_HR_bm;
+    
+    lsm6ds3_write(WAKE_UP_DUR, high_res ? (dur | LSM6DS3_TIMER_HR_bm) : dur);
+    lsm6ds3_write(TAP_CFG, lsm6ds3_read(TAP_CFG) | LSM6DS3_TIMER_EN_bm);
+    lsm6ds3_write(CTRL10_C, lsm6ds3_read(CTRL10_C) | LSM6DS3_FUNC_EN_bm);
+    
+    lsm6ds3_write(TIMESTAMP2_REG, LSM6DS3_TIMESTAMP_RESET);
+}
+
+// returns the current 24-bit timestamp counter.
+uint32_t lsm6ds3_timestamp_read(void)
+{
+    uint8_t ts[3];
+    
+    lsm6ds3_read_burst(TIMESTAMP0_REG, ts, 3);
+    
+    return ((uint32_t)ts[2] << 16) | ((uint16_t)ts[1] << 8) | ts[0];
+}
+
+// sets up the embedded functions selected by `events` (LSM6DS3_EVENT_*)
+// and routes them to INT1 as latched interrupts, so INT1 stays high until
+// `lsm6ds3_events_read` has read the sources. thresholds are in the units
+// of the registers: `tap_ths` is 1/32 of full scale (5 bits), `wake_ths`
+// 1/64 of full scale (6 bits) and `ff_ths` the 3-bit FF_THS code (0 = 156mg
+// up to 7 = 500mg). taps want an accelerometer ODR of 416Hz or more and the
+// pedometer needs at least 26Hz.
+void lsm6ds3_events_init(uint8_t events, uint8_t tap_ths, uint8_t wake_ths, uint8_t ff_ths)
+{
+    uint8_t tap_cfg = (lsm6ds3_read(TAP_CFG) & LSM6DS3_TIMER_EN_bm) | LSM6DS3_LIR_bm;
+    uint8_t wake_up_ths = wake_ths & 0x3F;
+    uint8_t md1 = 0;
+    
+    if(events & (LSM6DS3_EVENT_SINGLE_TAP_bm | LSM6DS3_EVENT_DOUBLE_TAP_bm))
+    {
+        tap_cfg |= LSM6DS3_TAP_XYZ_EN_gc;
+    }
     
-    uint8_t var3 = (reg_addr | LSM6DS3_SPI_READ_STROBE_bm);
+    if(events & LSM6DS3_EVENT_SINGLE_TAP_bm)
+    {
+        md1 |= LSM6DS3_INT1_SINGLE_TAP_bm;
+    }
     
-    spi_write(var3);
+    if(events & LSM6DS3_EVENT_DOUBLE_TAP_bm)
+    {
+        md1 |= LSM6DS3_INT1_DOUBLE_TAP_bm;
+        wake_up_ths |= LSM6DS3_SINGLE_DOUBLE_TAP_bm;
+    }
     
-    uint8_t var4 = spi_read();
+    if(events & LSM6DS3_EVENT_WAKE_UP_bm)
+    {
+        md1 |= LSM6DS3_INT1_WU_bm;
+    }
     
-    PORTF.OUTSET = SS_bm;
+    if(events & LSM6DS3_EVENT_FREE_FALL_bm)
+    {
+        md1 |= LSM6DS3_INT1_FF_bm;
+    }
     
-    return var4;
+    if(events & LSM6DS3_EVENT_STEP_bm)
+    {
+        tap_cfg |= LSM6DS3_PEDO_EN_bm;
+    }
+    
+    lsm6ds3_write(TAP_THS_6D, tap_ths & 0x1F);
+    lsm6ds3_write(INT_DUR2, (events & LSM6DS3_EVENT_DOUBLE_TAP_bm) ? LSM6DS3_INT_DUR2_DOUBLE_TAP : LSM6DS3_INT_DUR2_SINGLE_TAP);
+    lsm6ds3_write(WAKE_UP_THS, wake_up_ths);
+    
+    // keep the timestamp resolution, zero the wake-up and sleep durations
+    lsm6ds3_write(WAKE_UP_DUR, lsm6ds3_read(WAKE_UP_DUR) & LSM6DS3_TIMER_HR_bm);
+    lsm6ds3_write(FREE_FALL, LSM6DS3_FF_DUR_gc | (ff_ths & 0x07));
+    lsm6ds3_write(TAP_CFG, tap_cfg);
+    lsm6ds3_write(MD1_CFG, md1);
+    
+    if(events & LSM6DS3_EVENT_STEP_bm)
+    {
+        lsm6ds3_write(CTRL10_C, lsm6ds3_read(CTRL10_C) | LSM6DS3_FUNC_EN_bm);
+        lsm6ds3_write(INT1_CTRL, lsm6ds3_read(INT1_CTRL) | LSM6DS3_INT1_STEP_DETECTOR_bm);
+    }
 }
+
+// reads the event sources, which also releases the latched INT1, and
+// returns the events that fired as LSM6DS3_EVENT_* bits (0 if none).
+// `event` gets the raw sources, the step counter and the timestamp of the
+// last step; the step registers are read every time, so every field is
+// set whichever events fired.
+uint8_t lsm6ds3_events_read(lsm6ds3_event_t * event)
+{
+    uint8_t src[2];
+    uint8_t step[4];
+    uint8_t events = 0;
+    
+    // WAKE_UP_SRC and TAP_SRC are adjacent
+    lsm6ds3_read_burst(WAKE_UP_SRC, src, 2);
+    
+    event->wake_up_src = src[0];
+    event->tap_src = src[1];
+    event->func_src = lsm6ds3_read(FUNC_SRC);
+    
+    // STEP_TIMESTAMP_L/H are followed by STEP_COUNTER_L/H
+    lsm6ds3_read_burst(STEP_TIMESTAMP_L, step, 4);
+    
+    event->step_timestamp = ((uint16_t)step[1] << 8) | step[0];
+    event->step_count = ((uint16_t)step[3] << 8) | step[2];
+    
+    if(event->tap_src & LSM6DS3_SINGLE_TAP_bm)
+    {
+        events |= LSM6DS3_EVENT_SINGLE_TAP_bm;
+    }
+    
+    if(event->tap_src & LSM6DS3_DOUBLE_TAP_bm)
+    {
+        events |= LSM6DS3_EVENT_DOUBLE_TAP_bm;
+    }
+    
+    if(event->wake_up_src & LSM6DS3_WU_IA_bm)
+    {
+        events |= LSM6DS3_EVENT_WAKE_UP_bm;
+    }
+    
+    if(event->wake_up_src & LSM6DS3_FF_IA_bm)
+    {
+        events |= LSM6DS3_EVENT_FREE_FALL_bm;
+    }
+    
+    if(event->func_src & LSM6DS3_STEP_DETECTED_bm)
+    {
+        events |= LSM6DS3_EVENT_STEP_bm;
+    }
+    
+    return events;
+}
+
+#ifdef SPI_USART_MSPI
+
+// starts DMA sampling of the accel and gyro output registers into `ring`
+// (`count` records) on every data-ready edge selected by `evsys_chmux`.
+// with rounding enabled the burst starts at OUTX_L_XL and wraps from
+// OUTZ_H_XL back to OUTX_L_G, so each record lands in `lsm6ds3_data_t` order.
+void lsm6ds3_stream_start(lsm6ds3_stream_rec_t * ring, uint8_t count, uint8_t evsys_chmux)
+{
+    uint8_t ctrl5 = lsm6ds3_read(CTRL5_C);
+    
+    lsm6ds3_write(CTRL5_C, (ctrl5 & ~LSM6DS3_ROUNDING_gm) | LSM6DS3_ROUNDING_XL_G_gc);
+    
+    lsm6ds3_ring = ring;
+    lsm6ds3_ring_len = count;
+    lsm6ds3_ring_tail = 0;
+    lsm6ds3_ring_laps = 0;
+    lsm6ds3_ring_lost = 0;
+    
+    spi_stream_start(OUTX_L_XL | LSM6DS3_SPI_READ_STROBE_bm, sizeof(lsm6ds3_stream_rec_t),
+                     (uint8_t *)ring, count, evsys_chmux);
+}
+
+// returns the records the DMA controller has completed since the tail,
+// laps included. the record under its write pointer is still being
+// filled, so more than `lsm6ds3_ring_len` - 1 means the oldest of them
+// have been overwritten.
+static uint16_t lsm6ds3_stream_behind(void)
+{
+    uint8_t laps;
+    uint8_t head = spi_stream_pos(&laps) / sizeof(lsm6ds3_stream_rec_t);
+    
+    return (uint8_t)(laps - lsm6ds3_ring_laps) * (uint16_t)lsm6ds3_ring_len + head - lsm6ds3_ring_tail;
+}
+
+// moves the tail past `n` overwritten records and counts them as lost.
+static void lsm6ds3_stream_skip(uint16_t n)
+{
+    uint16_t pos = lsm6ds3_ring_tail + n;
+    
+    lsm6ds3_ring_laps += pos / lsm6ds3_ring_len;
+    lsm6ds3_ring_tail = pos % lsm6ds3_ring_len;
+    
+    lsm6ds3_ring_lost = (n > 0xFFFF - lsm6ds3_ring_lost) ? 0xFFFF : lsm6ds3_ring_lost + n;
+}
+
+// copies the oldest unread streamed sample into `data` and returns 1, or
+// returns 0 if the DMA controller has not completed a new record since.
+// records it overwrote before they were read are skipped, and counted
+// (see `lsm6ds3_stream_lost`).
+uint8_t lsm6ds3_stream_read(lsm6ds3_data_t * data)
+{
+    uint16_t behind;
+    
+    while((behind = lsm6ds3_stream_behind()) != 0)
+    {
+        if(behind >= lsm6ds3_ring_len)
+        {
+            lsm6ds3_stream_skip(behind - (lsm6ds3_ring_len - 1));
+            continue;
+        }
+        
+        *data = lsm6ds3_ring[lsm6ds3_ring_tail].data;
+        
+        // the copy is torn if the DMA controller came round to the record
+        // meanwhile; then it is skipped like the others
+        if(lsm6ds3_stream_behind() >= lsm6ds3_ring_len)
+        {
+            continue;
+        }
+        
+        if(++lsm6ds3_ring_tail == lsm6ds3_ring_len)
+        {
+            lsm6ds3_ring_tail = 0;
+            lsm6ds3_ring_laps++;
+        }
+        
+        return 1;
+    }
+    
+    return 0;
+}
+
+// returns the number of streamed records the DMA controller overwrote
+// before `lsm6ds3_stream_read` got to them since `lsm6ds3_stream_start`,
+// saturated at 0xFFFF.
+uint16_t lsm6ds3_stream_lost(void)
+{
+    return lsm6ds3_ring_lost;
+}
+
+#endif // SPI_USART_MSPI
 /***************************END OF FUNCTION DEFINITIONS************************/
\ No newline at end of file
@@ -14,11 +14,105 @@
 ------------------------------------------------------------------------------*/
 
 
+/********************************DEPENDENCIES**********************************/
+
+#include <stdint.h>
+#include "spi.h"
+
+/*****************************END OF DEPENDENCIES******************************/
+
+
 /***********************************MACROS*************************************/
 
 #define LSM6DS3_SPI_READ_STROBE_bm              0x80
 #define LSM6DS3_SPI_WRITE_STROBE_bm             0x00
 
+/* INT1_CTRL / INT2_CTRL: route the FIFO watermark flag to the pin. */
+#define LSM6DS3_INT_FTH_bm                      0x08
+
+/* `lsm6ds3_fifo_init` data sets: the low byte goes to FIFO_CTRL3 and the
+ * high byte to FIFO_CTRL4. Each puts a data set in the FIFO undecimated. */
+#define LSM6DS3_FIFO_DEC_G_NONE_gc              (0b001 << 3)
+#define LSM6DS3_FIFO_DEC_XL_NONE_gc             (0b001 << 0)
+#define LSM6DS3_FIFO_DEC_DS4_NONE_gc            ((0b001 << 3) << 8)
+
+/* FIFO_CTRL2: store timestamp and step counter as the fourth data set. */
+#define LSM6DS3_TIMER_PEDO_FIFO_EN_bm           0x80
+
+/* FIFO_CTRL5: FIFO output data rate and mode. */
+#define LSM6DS3_FIFO_ODR_208HZ_gc               (0b0101 << 3)
+#define LSM6DS3_FIFO_ODR_416HZ_gc               (0b0110 << 3)
+#define LSM6DS3_FIFO_ODR_833HZ_gc               (0b0111 << 3)
+#define LSM6DS3_FIFO_ODR_1660HZ_gc              (0b1000 << 3)
+#define LSM6DS3_FIFO_ODR_3330HZ_gc              (0b1001 << 3)
+#define LSM6DS3_FIFO_ODR_6660HZ_gc              (0b1010 << 3)
+#define LSM6DS3_FIFO_MODE_BYPASS_gc             0b000
+#define LSM6DS3_FIFO_MODE_CONTINUOUS_gc         0b110
+
+/* FIFO_STATUS1/FIFO_STATUS2, as returned by `lsm6ds3_fifo_status`. */
+#define LSM6DS3_FIFO_WTM_bm                     0x8000
+#define LSM6DS3_FIFO_OVER_RUN_bm                0x4000
+#define LSM6DS3_FIFO_FULL_bm                    0x2000
+#define LSM6DS3_FIFO_EMPTY_bm                   0x1000
+#define LSM6DS3_FIFO_DIFF_gm                    0x0FFF
+
+/* CTRL5_C: circular burst read over the gyro and accel output registers. */
+#define LSM6DS3_ROUNDING_XL_G_gc                (0b011 << 5)
+#define LSM6DS3_ROUNDING_gm                     (0b111 << 5)
+
+/* Timestamp counter: TAP_CFG enable, WAKE_UP_DUR resolution, CTRL10_C
+ * embedded function enable, and the value that resets it when written to
+ * TIMESTAMP2_REG. */
+#define LSM6DS3_TIMER_EN_bm                     0x80
+#define LSM6DS3_TIMER_HR_bm                     0x10
+#define LSM6DS3_FUNC_EN_bm                      0x04
+#define LSM6DS3_TIMESTAMP_RESET                 0xAA
+
+/* Timestamp LSB in microseconds, with and without TIMER_HR. */
+#define LSM6DS3_TIMESTAMP_HR_US                 25
+#define LSM6DS3_TIMESTAMP_US                    6400
+
+/* Embedded function events, for `lsm6ds3_events_init` and as returned by
+ * `lsm6ds3_events_read`. */
+#define LSM6DS3_EVENT_SINGLE_TAP_bm             0x01
+#define LSM6DS3_EVENT_DOUBLE_TAP_bm             0x02
+#define LSM6DS3_EVENT_WAKE_UP_bm                0x04
+#define LSM6DS3_EVENT_FREE_FALL_bm              0x08
+#define LSM6DS3_EVENT_STEP_bm                   0x10
+
+/* TAP_CFG: pedometer, tap axes and latched interrupts. */
+#define LSM6DS3_PEDO_EN_bm                      0x40
+#define LSM6DS3_TAP_XYZ_EN_gc                   0x0E
+#define LSM6DS3_LIR_bm                          0x01
+
+/* WAKE_UP_THS: enable double tap recognition. */
+#define LSM6DS3_SINGLE_DOUBLE_TAP_bm            0x80
+
+/* INT_DUR2 tap windows (DUR, QUIET, SHOCK) from the application note. */
+#define LSM6DS3_INT_DUR2_SINGLE_TAP             0x06
+#define LSM6DS3_INT_DUR2_DOUBLE_TAP             0x7F
+
+/* FREE_FALL: minimum free-fall duration, 6 samples. */
+#define LSM6DS3_FF_DUR_gc                       (0b00110 << 3)
+
+/* MD1_CFG routing of each event to INT1. */
+#define LSM6DS3_INT1_SINGLE_TAP_bm              0x40
+#define LSM6DS3_INT1_WU_bm                      0x20
+#define LSM6DS3_INT1_FF_bm                      0x10
+#define LSM6DS3_INT1_DOUBLE_TAP_bm              0x08
+
+/* INT1_CTRL: step detector. */
+#define LSM6DS3_INT1_STEP_DETECTOR_bm           0x80
+
+/* WAKE_UP_SRC, TAP_SRC and FUNC_SRC flags. */
+#define LSM6DS3_FF_IA_bm                        0x20
+#define LSM6DS3_WU_IA_bm                        0x08
+#define LSM6DS3_WU_XYZ_gm                       0x07
+#define LSM6DS3_SINGLE_TAP_bm                   0x20
+#define LSM6DS3_DOUBLE_TAP_bm                   0x10
+#define LSM6DS3_TAP_SIGN_XYZ_gm                 0x0F
+#define LSM6DS3_STEP_DETECTED_bm                0x10
+
 /********************************END OF MACROS*********************************/
 
 
@@ -54,6 +148,27 @@ typedef union lsm6ds3_data
   lsm6ds3_data_raw_t   byte;
 }lsm6ds3_data_t;
 
+/* Sources and step count behind a batch of events, see `lsm6ds3_events_read`. */
+typedef struct lsm6ds3_event
+{
+  uint8_t wake_up_src;
+  uint8_t tap_src;
+  uint8_t func_src;
+
+  uint16_t step_timestamp;
+  uint16_t step_count;
+}lsm6ds3_event_t;
+
+#ifdef SPI_USART_MSPI
+/* One DMA-streamed sample: the byte clocked in while the register address
+ * went out, followed by the output registers in `lsm6ds3_data_t` order. */
+typedef struct lsm6ds3_stream_rec
+{
+  uint8_t cmd;
+  lsm6ds3_data_t data;
+}lsm6ds3_stream_rec_t;
+#endif
+
 /***************************END OF CUSTOM DATA TYPES***************************/
 
 
@@ -63,6 +178,38 @@ void lsm6ds3_write(uint8_t reg_addr, uint8_t data);
 
 uint8_t lsm6ds3_read(uint8_t reg_addr);
 
+void lsm6ds3_read_burst(uint8_t reg_addr, uint8_t * buf, uint8_t len);
+
+void lsm6ds3_read_burst_async(spi_xfer_t * xfer, uint8_t reg_addr, uint8_t * buf, uint16_t len);
+
+void lsm6ds3_read_all(lsm6ds3_data_t * data);
+
+void lsm6ds3_fifo_init(uint16_t watermark, uint16_t datasets, uint8_t fifo_odr);
+
+uint16_t lsm6ds3_fifo_status(void);
+
+uint16_t lsm6ds3_fifo_available(uint16_t max_words, uint8_t set_words);
+
+uint16_t lsm6ds3_fifo_drain(int16_t * buf, uint16_t max_words, uint8_t set_words);
+
+uint32_t lsm6ds3_fifo_timestamp(const int16_t * set);
+
+void lsm6ds3_timestamp_init(uint8_t high_res);
+
+uint32_t lsm6ds3_timestamp_read(void);
+
+void lsm6ds3_events_init(uint8_t events, uint8_t tap_ths, uint8_t wake_ths, uint8_t ff_ths);
+
+uint8_t lsm6ds3_events_read(lsm6ds3_event_t * event);
+
+#ifdef SPI_USART_MSPI
+void lsm6ds3_stream_start(lsm6ds3_stream_rec_t * ring, uint8_t count, uint8_t evsys_chmux);
+
+uint8_t lsm6ds3_stream_read(lsm6ds3_data_t * data);
+
+uint16_t lsm6ds3_stream_lost(void);
+#endif
+
 void lsm6ds3_init(void);
 
 void interrupt_init(void);
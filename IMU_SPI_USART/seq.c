@@ -0,0 +1,96 @@
+/*------------------------------------------------------------------------------
+  seq.c --
+
+  Description:
+    Song sequencer for the DDS engine. See `seq.h`.
+
+------------------------------------------------------------------------------*/
+
+/********************************DEPENDENCIES**********************************/
+
+#include <stdint.h>
+#include "seq.h"
+#include "synth.h"
+
+/*****************************END OF DEPENDENCIES******************************/
+
+
+/*****************************FUNCTION DEFINITIONS*****************************/
+
+void seq_init(seq_t * seq)
+{
+    seq->song = 0;
+    seq->len = 0;
+    seq->pos = 0;
+    seq->wait = 0;
+    seq->voice = SYNTH_HANDLE_NONE;
+    seq->note = 0;
+    seq->playing = 0;
+}
+
+void seq_play(seq_t * seq, synth_t * syn, const seq_event_t * song, uint16_t len)
+{
+    seq_stop(seq, syn);
+
+    seq->song = song;
+    seq->len = len;
+    seq->pos = 0;
+    seq->wait = 0;
+    seq->playing = 1;
+}
+
+void seq_stop(seq_t * seq, synth_t * syn)
+{
+    if(seq->note)
+    {
+        synth_voice_off(syn, seq->voice);
+        seq->note = 0;
+    }
+
+    seq->playing = 0;
+}
+
+uint8_t seq_tick(seq_t * seq, synth_t * syn)
+{
+    if(seq->wait)
+    {
+        seq->wait--;
+    }
+
+    // everything due on this tick, so rests and notes of no length
+    // take no time
+    while(seq->playing && !seq->wait)
+    {
+        if(seq->note)
+        {
+            // the note is over, its rest begins
+            synth_voice_off(syn, seq->voice);
+            seq->note = 0;
+            seq->wait = seq->song[seq->pos++].rest;
+        }
+        else if(seq->pos >= seq->len)
+        {
+            seq->playing = 0;
+        }
+        else
+        {
+            const seq_event_t * ev = &seq->song[seq->pos];
+
+            if(ev->note && ev->length)
+            {
+                seq->voice = synth_note_on(syn, ev->note, ev->level, 0);
+                seq->note = ev->note;
+                seq->wait = ev->length;
+            }
+            else
+            {
+                seq->wait = (uint16_t)ev->length + ev->rest;
+                seq->pos++;
+            }
+        }
+    }
+
+    return seq->playing;
+}
+
+/***************************END OF FUNCTION DEFINITIONS************************/
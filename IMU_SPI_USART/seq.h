@@ -0,0 +1,133 @@
+#ifndef SEQ_H_  // Header guard.
+#define SEQ_H_
+
+/*------------------------------------------------------------------------------
+  seq.h --
+
+  Description:
+    Provides a sequencer that plays a song, a list of events, on the DDS
+    engine of `synth.h`, one step per call of `seq_tick`. The caller
+    ticks it SEQ_PPQ times per beat, from a timer interrupt on the AVR,
+    so the tempo is the tick rate, SEQ_TICKS_PER_MINUTE(bpm) / 60 per
+    second.
+
+      Each event plays `note` at `level` for `length` ticks, then waits
+    `rest` ticks more before the next event starts. A `note` of 0 is a
+    rest of `length` + `rest` ticks. Notes go through `synth_note_on`, so
+    they share the voices with any others played, and each is released
+    with `synth_voice_off`, so the same note played meanwhile by someone
+    else is left sounding.
+
+      The sequencer and the engine must not run at once: on the AVR,
+    `seq_tick` is called at the level of the interrupt that renders, and
+    the other functions with it masked.
+
+------------------------------------------------------------------------------*/
+
+/********************************DEPENDENCIES**********************************/
+
+#include <stdint.h>
+#include "synth.h"
+
+/*****************************END OF DEPENDENCIES******************************/
+
+
+/***********************************MACROS*************************************/
+
+/* Ticks per beat (quarter note); a tick is a 32nd note. */
+#define SEQ_PPQ                 8
+
+/* Ticks per minute at `bpm` beats per minute. */
+#define SEQ_TICKS_PER_MINUTE(bpm)   ((bpm) * 1UL * SEQ_PPQ)
+
+/* Tempo range, beats per minute. */
+#define SEQ_BPM_MIN             20
+#define SEQ_BPM_MAX             300
+
+/********************************END OF MACROS*********************************/
+
+
+/*******************************CUSTOM DATA TYPES******************************/
+
+/* One event of a song. */
+typedef struct seq_event
+{
+  uint8_t note;
+  uint8_t level;
+  uint8_t length;
+  uint8_t rest;
+}seq_event_t;
+
+/* Sequencer state; `note` is the note sounding, 0 for none, and `voice`
+ * the handle of the voice playing it. */
+typedef struct seq
+{
+  const seq_event_t * song;
+  uint16_t len;
+  uint16_t pos;
+  uint16_t wait;
+  uint16_t voice;
+  uint8_t note;
+  uint8_t playing;
+}seq_t;
+
+/***************************END OF CUSTOM DATA TYPES***************************/
+
+
+/*****************************FUNCTION PROTOTYPES******************************/
+
+/*------------------------------------------------------------------------------
+  seq_init --
+
+  Description:
+    Stops the sequencer, with no song.
+
+  Input(s): `seq` - Sequencer.
+  Output(s): N/A
+------------------------------------------------------------------------------*/
+void seq_init(seq_t * seq);
+
+/*------------------------------------------------------------------------------
+  seq_play --
+
+  Description:
+    Starts `song` from its first event, which the next `seq_tick` plays.
+    A note still sounding from before is released.
+
+  Input(s): `seq`  - Sequencer.
+            `syn`  - Engine.
+            `song` - Events; must stay valid while the song plays.
+            `len`  - Number of events.
+  Output(s): N/A
+------------------------------------------------------------------------------*/
+void seq_play(seq_t * seq, synth_t * syn, const seq_event_t * song, uint16_t len);
+
+/*------------------------------------------------------------------------------
+  seq_stop --
+
+  Description:
+    Stops the song and releases its note.
+
+  Input(s): `seq` - Sequencer.
+            `syn` - Engine.
+  Output(s): N/A
+------------------------------------------------------------------------------*/
+void seq_stop(seq_t * seq, synth_t * syn);
+
+/*------------------------------------------------------------------------------
+  seq_tick --
+
+  Description:
+    Advances the song by one tick, starting and releasing notes as
+    events begin and end. Once the last event is over the sequencer
+    stops by itself.
+
+  Input(s): `seq` - Sequencer.
+            `syn` - Engine.
+  Output(s): 1 while the song plays, 0 once it has ended.
+------------------------------------------------------------------------------*/
+uint8_t seq_tick(seq_t * seq, synth_t * syn);
+
+/**************************END OF FUNCTION PROTOTYPES**************************/
+
+#endif // End of header guard.
@@ -5,15 +5,34 @@
     Provides useful definitions for manipulating the relevant SPI
     module of the ATxmega128A1U. 
 
+    Compiles to nothing when SPI_USART_MSPI is defined, in which case
+    `usart_spi.c` provides the same interface on USARTF0 instead.
+
 ------------------------------------------------------------------------------*/
 
 /********************************DEPENDENCIES**********************************/
 
 #include <avr/io.h>
+#include <avr/interrupt.h>
+#include <stddef.h>
 #include "spi.h"
 
 /*****************************END OF DEPENDENCIES******************************/
 
+#ifndef SPI_USART_MSPI
+
+/******************************GLOBAL VARIABLES********************************/
+
+/* Pending transactions; `spi_queue[spi_head]` is the one on the bus. */
+static spi_xfer_t * volatile spi_queue[SPI_QUEUE_LEN];
+static volatile uint8_t spi_head = 0;
+static volatile uint8_t spi_tail = 0;
+
+/* Position within the transaction currently on the bus. */
+static uint16_t spi_pos = 0;
+
+/***************************END OF GLOBAL VARIABLES****************************/
+
 
 /*****************************FUNCTION DEFINITIONS*****************************/
 
@@ -23,7 +42,7 @@ void spi_init(void)
   /* Initialize the relevant SPI output signals to be in an "idle" state.
    * Refer to the relevant timing diagram within the LSM6DS3 datasheet.
    * (You may wish to utilize the macros defined in `spi.h`.) */
-    PORTF.OUTSET = SS_bm;                               // SS idles high
+    PORTF.OUTSET = SS_bm;                               // SS idles high in mode3
   
 
   /* Configure the pin direction of relevant SPI signals. */
@@ -33,7 +52,7 @@ void spi_init(void)
     /* Set the other relevant SPI configurations. */    // DORD is pin 5, defaulted to zero = MSB first, prescaler 4 gives 8MHz frequency
     SPIF.CTRL   =   SPI_PRESCALER_DIV4_gc           |   
                         SPI_MASTER_bm               |   
-                        SPI_MODE_0_gc               |   
+                        SPI_MODE_3_gc               |   
                         SPI_ENABLE_bm;
 }
 
@@ -68,4 +87,143 @@ uint8_t spi_read(void)
     return SPIF.DATA;
 }
 
+/* Asserts chip select for the transaction at the head of the queue and
+ * clocks out its first byte, or turns the interrupt off when idle. */
+static void spi_start(void)
+{
+    if(spi_head == spi_tail)
+    {
+        SPIF.INTCTRL = SPI_INTLVL_OFF_gc;
+        return;
+    }
+    
+    spi_xfer_t * xfer = spi_queue[spi_head];
+    
+    spi_pos = 0;
+    
+    if(xfer->cs_port)
+    {
+        xfer->cs_port->OUTCLR = xfer->cs_bm;
+    }
+    
+    SPIF.INTCTRL = SPI_INTLVL_LO_gc;
+    SPIF.DATA = xfer->tx_len ? xfer->tx[0] : SPI_DUMMY_BYTE;
+}
+
+/* Handles a completed byte of the transaction at the head of the queue.
+ * The caller must have observed SPIF.STATUS with the interrupt flag set
+ * (or be the SPIF interrupt itself). */
+static void spi_service(void)
+{
+    spi_xfer_t * xfer = spi_queue[spi_head];
+    uint8_t data = SPIF.DATA;
+    
+    if(spi_pos >= xfer->tx_len)
+    {
+        xfer->rx[spi_pos - xfer->tx_len] = data;
+    }
+    
+    if(++spi_pos < xfer->tx_len + xfer->rx_len)
+    {
+        SPIF.DATA = (spi_pos < xfer->tx_len) ? xfer->tx[spi_pos] : SPI_DUMMY_BYTE;
+        return;
+    }
+    
+    if(xfer->cs_port)
+    {
+        xfer->cs_port->OUTSET = xfer->cs_bm;
+    }
+    
+    spi_head = (spi_head + 1) & (SPI_QUEUE_LEN - 1);
+    
+    xfer->busy = 0;
+    
+    if(xfer->done)
+    {
+        xfer->done(xfer);
+    }
+    
+    spi_start();
+}
+
+/* True when the SPIF interrupt cannot currently be taken, in which case
+ * anyone waiting on the engine has to service it by polling. */
+static uint8_t spi_must_poll(void)
+{
+    return !(CPU_SREG & CPU_I_bm) || (PMIC.STATUS & (PMIC_LOLVLEX_bm | PMIC_MEDLVLEX_bm | PMIC_HILVLEX_bm));
+}
+
+/* Services one byte by polling, if one is pending. */
+static void spi_poll(void)
+{
+    if(SPIF.STATUS & SPI_IF_bm)
+    {
+        spi_service();
+    }
+}
+
+void spi_submit(spi_xfer_t * xfer)
+{
+    xfer->busy = 1;
+    
+    if(xfer->tx_len + xfer->rx_len == 0)
+    {
+        xfer->busy = 0;
+        
+        if(xfer->done)
+        {
+            xfer->done(xfer);
+        }
+        
+        return;
+    }
+    
+    /* wait for a free slot */
+    while(((spi_tail + 1) & (SPI_QUEUE_LEN - 1)) == spi_head)
+    {
+        if(spi_must_poll())
+        {
+            spi_poll();
+        }
+    }
+    
+    uint8_t sreg = CPU_SREG;
+    cli();
+    
+    spi_queue[spi_tail] = xfer;
+    spi_tail = (spi_tail + 1) & (SPI_QUEUE_LEN - 1);
+    
+    /* kick the engine if it was idle */
+    if(((spi_head + 1) & (SPI_QUEUE_LEN - 1)) == spi_tail)
+    {
+        spi_start();
+    }
+    
+    CPU_SREG = sreg;
+}
+
+void spi_wait(spi_xfer_t * xfer)
+{
+    while(xfer->busy)
+    {
+        if(spi_must_poll())
+        {
+            spi_poll();
+        }
+    }
+}
+
+void spi_transfer(spi_xfer_t * xfer)
+{
+    spi_submit(xfer);
+    spi_wait(xfer);
+}
+
+ISR(SPIF_INT_vect)
+{
+    spi_service();
+}
+
 /***************************END OF FUNCTION DEFINITIONS************************/
+
+#endif // SPI_USART_MSPI
@@ -23,8 +23,46 @@
 #define MISO_bm   (1<<6)
 #define SCK_bm    (1<<7)
 
+/* Number of transactions that can be queued at once (power of two). */
+#define SPI_QUEUE_LEN       8
+
+/* Byte clocked out while receiving. */
+#define SPI_DUMMY_BYTE      0x37
+
+/* Longest transaction `spi_stream_start` can repeat (USART MSPI only). */
+#define SPI_STREAM_MAX_LEN  16
+
 /********************************END OF MACROS*********************************/
 
+/*******************************CUSTOM DATA TYPES******************************/
+
+/* Describes a single chip-select framed SPI transaction. The first `tx_len`
+ * bytes of `tx` are clocked out (anything received meanwhile is discarded),
+ * after which `rx_len` bytes are clocked in to `rx` while SPI_DUMMY_BYTE
+ * is sent. `hdr` is scratch space for short command headers, so that `tx`
+ * may point into the descriptor itself. The descriptor must stay valid
+ * until `busy` is cleared. */
+typedef struct spi_xfer
+{
+  PORT_t * cs_port;
+  uint8_t cs_bm;
+
+  const uint8_t * tx;
+  uint16_t tx_len;
+  uint8_t * rx;
+  uint16_t rx_len;
+
+  uint8_t hdr[2];
+
+  /* Called from the SPIF interrupt once chip select is released, or NULL. */
+  void (*done)(struct spi_xfer * xfer);
+
+  /* Set by `spi_submit`, cleared when the transaction completes. */
+  volatile uint8_t busy;
+}spi_xfer_t;
+
+/***************************END OF CUSTOM DATA TYPES***************************/
+
 /*****************************FUNCTION PROTOTYPES******************************/
 
 /*------------------------------------------------------------------------------
@@ -60,6 +98,97 @@ void spi_write(uint8_t data);
 ------------------------------------------------------------------------------*/
 uint8_t spi_read(void);
 
+/*------------------------------------------------------------------------------
+  spi_submit -- 
+  
+  Description:
+    Queues a transaction to be carried out by the SPIF interrupt and returns
+    immediately. If the queue is full, waits for a slot to free up.
+
+    The polled `spi_write` and `spi_read` routines must not be used while
+    queued transactions are in flight.
+
+  Input(s): `xfer` - Pointer to transaction descriptor.
+  Output(s): N/A
+------------------------------------------------------------------------------*/
+void spi_submit(spi_xfer_t * xfer);
+
+/*------------------------------------------------------------------------------
+  spi_wait -- 
+  
+  Description:
+    Waits for a previously submitted transaction to complete. If the SPIF
+    interrupt cannot run (global interrupts disabled, or called from within
+    an interrupt), the transfer is serviced by polling instead.
+
+  Input(s): `xfer` - Pointer to transaction descriptor.
+  Output(s): N/A
+------------------------------------------------------------------------------*/
+void spi_wait(spi_xfer_t * xfer);
+
+/*------------------------------------------------------------------------------
+  spi_transfer -- 
+  
+  Description:
+    Blocking wrapper; submits a transaction and waits for it to complete.
+
+  Input(s): `xfer` - Pointer to transaction descriptor.
+  Output(s): N/A
+------------------------------------------------------------------------------*/
+void spi_transfer(spi_xfer_t * xfer);
+
+#ifdef SPI_USART_MSPI
+
+/*------------------------------------------------------------------------------
+  spi_stream_start -- 
+  
+  Description:
+    (USART MSPI transport only.) Hands the bus over to the DMA controller.
+    On every rising edge routed to event channel 0 by `evsys_chmux`, chip
+    select is cycled and a `len` byte transaction (the command byte `cmd`
+    followed by dummy bytes) is clocked out. Everything received lands in
+    `ring`, which holds `count` records of `len` bytes and wraps around.
+    The only interrupt taken is one (low level) per lap of the ring, to
+    count laps. The transaction API must not be used until
+    `spi_stream_stop` is called.
+
+  Input(s): `cmd`         - First byte of each transaction.
+            `len`         - Bytes per transaction (at most SPI_STREAM_MAX_LEN).
+            `ring`        - Receive ring, `len` * `count` bytes.
+            `count`       - Number of records in the ring.
+            `evsys_chmux` - EVSYS_CHMUX_* source of the trigger edge.
+  Output(s): N/A
+------------------------------------------------------------------------------*/
+void spi_stream_start(uint8_t cmd, uint8_t len, uint8_t * ring, uint8_t count, uint8_t evsys_chmux);
+
+/*------------------------------------------------------------------------------
+  spi_stream_stop -- 
+  
+  Description:
+    (USART MSPI transport only.) Stops the DMA stream and releases chip select.
+
+  Input(s): N/A
+  Output(s): N/A
+------------------------------------------------------------------------------*/
+void spi_stream_stop(void);
+
+/*------------------------------------------------------------------------------
+  spi_stream_pos -- 
+  
+  Description:
+    (USART MSPI transport only.) Returns the offset within the ring that the
+    DMA controller will write next and, in `laps` unless it is NULL, the
+    number of times it has wrapped around the ring since
+    `spi_stream_start`, modulo 256. Together they tell how far a reader
+    has fallen behind, even by more than a whole ring.
+
+  Input(s): `laps` - Where the lap count is stored, or NULL.
+  Output(s): Byte offset into the ring passed to `spi_stream_start`.
+------------------------------------------------------------------------------*/
+uint16_t spi_stream_pos(uint8_t * laps);
+
+#endif // SPI_USART_MSPI
+
 /**************************END OF FUNCTION PROTOTYPES**************************/
 
 #endif // End of header guard.
\ No newline at end of file
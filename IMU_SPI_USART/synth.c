@@ -0,0 +1,302 @@
+/*------------------------------------------------------------------------------
+  synth.c --
+
+  Description:
+    Polyphonic DDS engine for the DAC. See `synth.h`.
+
+------------------------------------------------------------------------------*/
+
+/********************************DEPENDENCIES**********************************/
+
+#include <stdint.h>
+#include "synth.h"
+
+/*****************************END OF DEPENDENCIES******************************/
+
+
+/***********************************MACROS*************************************/
+
+/* Phase increment of `mhz` millihertz. */
+#define SYNTH_INC(mhz)  ((uint32_t)(((uint64_t)(mhz) << 32) / (SYNTH_RATE * 1000ULL)))
+
+/********************************END OF MACROS*********************************/
+
+
+/******************************GLOBAL VARIABLES********************************/
+
+/* Increments of the top octave, C8 (108) to B8 (119); lower octaves are
+ * these halved. */
+static const uint32_t synth_top_octave[12] =
+{
+    SYNTH_INC(4186009), SYNTH_INC(4434922), SYNTH_INC(4698636), SYNTH_INC(4978032),
+    SYNTH_INC(5274041), SYNTH_INC(5587652), SYNTH_INC(5919911), SYNTH_INC(6271927),
+    SYNTH_INC(6644875), SYNTH_INC(7040000), SYNTH_INC(7458620), SYNTH_INC(7902133)
+};
+
+/***************************END OF GLOBAL VARIABLES****************************/
+
+
+/*****************************FUNCTION DEFINITIONS*****************************/
+
+void synth_init(synth_t * syn)
+{
+    for(uint8_t v = 0; v < SYNTH_VOICES; v++)
+    {
+        syn->voice[v].phase = 0;
+        syn->voice[v].inc = 0;
+        syn->voice[v].wave = synth_waves[0];
+        syn->voice[v].fade_wave = synth_waves[0];
+        syn->voice[v].fade = 0;
+        syn->voice[v].gate = 0;
+        syn->voice[v].note = 0;
+        syn->voice[v].level = 0;
+        syn->voice[v].target = 0;
+        syn->voice[v].serial = 0;
+    }
+
+    syn->shape = SYNTH_SINE;
+    syn->shape_next = SYNTH_SINE;
+    syn->next = 0;
+    syn->serial = 0;
+}
+
+uint32_t synth_increment(uint8_t note)
+{
+    if(note > SYNTH_NOTE_MAX)
+    {
+        note = SYNTH_NOTE_MAX;
+    }
+
+    return synth_top_octave[note % 12] >> (9 - note / 12);
+}
+
+const int16_t * synth_wave(uint8_t shape, uint8_t note)
+{
+    uint8_t band = note / 12;
+
+    if(shape == SYNTH_SINE || shape >= SYNTH_SHAPES)
+    {
+        return synth_waves[0];
+    }
+
+    band = (band < SYNTH_BAND_FIRST) ? 0 : band - SYNTH_BAND_FIRST;
+
+    if(band >= SYNTH_BANDS)
+    {
+        band = SYNTH_BANDS - 1;
+    }
+
+    return synth_waves[1 + (shape - 1) * SYNTH_BANDS + band];
+}
+
+void synth_set_shape(synth_t * syn, uint8_t shape)
+{
+    if(shape < SYNTH_SHAPES)
+    {
+        syn->shape_next = shape;
+    }
+}
+
+uint16_t synth_note_on(synth_t * syn, uint8_t note, uint8_t level, uint16_t gate)
+{
+    synth_voice_t * voice = 0;
+
+    if(!level)
+    {
+        synth_note_off(syn, note);
+        return SYNTH_HANDLE_NONE;
+    }
+
+    for(uint8_t v = 0; v < SYNTH_VOICES && !voice; v++)
+    {
+        if(!syn->voice[v].level && !syn->voice[v].target)
+        {
+            voice = &syn->voice[v];
+        }
+    }
+
+    // a free voice found above has level 0, so no releasing voice is quieter
+    for(uint8_t v = 0; v < SYNTH_VOICES; v++)
+    {
+        synth_voice_t * r = &syn->voice[v];
+
+        if(!r->target && (!voice || r->level < voice->level))
+        {
+            voice = r;
+        }
+    }
+
+    if(!voice)
+    {
+        voice = &syn->voice[syn->next];
+        syn->next = (syn->next + 1) % SYNTH_VOICES;
+    }
+
+    // a stolen voice keeps its phase and level, and ramps from there
+    voice->inc = synth_increment(note);
+    voice->wave = synth_wave(syn->shape_next, note);
+    voice->fade = 0;
+    voice->gate = gate;
+    voice->note = note;
+    voice->target = level;
+    voice->serial = ++syn->serial;
+
+    return ((uint16_t)voice->serial << 8) | (uint8_t)(voice - syn->voice);
+}
+
+void synth_note_off(synth_t * syn, uint8_t note)
+{
+    for(uint8_t v = 0; v < SYNTH_VOICES; v++)
+    {
+        if(syn->voice[v].note == note)
+        {
+            syn->voice[v].target = 0;
+            syn->voice[v].gate = 0;
+        }
+    }
+}
+
+void synth_voice_off(synth_t * syn, uint16_t handle)
+{
+    uint8_t v = (uint8_t)handle;
+
+    if(v < SYNTH_VOICES && syn->voice[v].serial == (uint8_t)(handle >> 8))
+    {
+        syn->voice[v].target = 0;
+        syn->voice[v].gate = 0;
+    }
+}
+
+// the table at the phase, interpolated between the two entries either
+// side of it
+static inline int16_t synth_sample(const int16_t * wave, uint32_t phase)
+{
+    uint8_t i = (uint8_t)(phase >> (32 - SYNTH_WAVE_BITS));
+    uint8_t frac = (uint8_t)(phase >> (24 - SYNTH_WAVE_BITS));
+    int16_t a = SYNTH_WAVE_READ(&wave[i]);
+    int16_t b = SYNTH_WAVE_READ(&wave[(i + 1) & (SYNTH_WAVE_LEN - 1)]);
+
+    return a + (int16_t)(((int32_t)(b - a) * frac) >> 8);
+}
+
+void synth_render(synth_t * syn, uint16_t * out, uint16_t n)
+{
+    // the voices are summed in place, as signed values
+    int16_t * mix = (int16_t *)out;
+    uint8_t shape = syn->shape_next;
+
+    // a voice still fading starts again, from the shape it was fading to
+    if(shape != syn->shape)
+    {
+        syn->shape = shape;
+
+        for(uint8_t v = 0; v < SYNTH_VOICES; v++)
+        {
+            synth_voice_t * voice = &syn->voice[v];
+
+            if(voice->level || voice->target)
+            {
+                voice->fade_wave = voice->wave;
+                voice->wave = synth_wave(shape, voice->note);
+                voice->fade = SYNTH_FADE;
+            }
+        }
+    }
+
+    for(uint16_t i = 0; i < n; i++)
+    {
+        mix[i] = 0;
+    }
+
+    for(uint8_t v = 0; v < SYNTH_VOICES; v++)
+    {
+        synth_voice_t * voice = &syn->voice[v];
+        const int16_t * wave = voice->wave;
+        uint32_t phase = voice->phase;
+        uint32_t inc = voice->inc;
+        uint8_t level = voice->level;
+        uint8_t target = voice->target;
+        uint8_t fade = voice->fade;
+
+        if(!level && !target)
+        {
+            continue;
+        }
+
+        if(level == target && !fade)
+        {
+            for(uint16_t i = 0; i < n; i++)
+            {
+                int16_t x = synth_sample(wave, phase);
+
+                mix[i] += (int16_t)(((int32_t)x * level) >> 8);
+                phase += inc;
+            }
+        }
+        else
+        {
+            const int16_t * fade_wave = voice->fade_wave;
+
+            for(uint16_t i = 0; i < n; i++)
+            {
+                int16_t x = synth_sample(wave, phase);
+
+                if(fade)
+                {
+                    int16_t x0 = synth_sample(fade_wave, phase);
+
+                    x += (int16_t)(((int32_t)(x0 - x) * fade) >> SYNTH_FADE_BITS);
+                    fade--;
+                }
+
+                mix[i] += (int16_t)(((int32_t)x * level) >> 8);
+                phase += inc;
+
+                if(level < target)
+                {
+                    level++;
+                }
+                else if(level > target)
+                {
+                    level--;
+                }
+            }
+        }
+
+        voice->phase = phase;
+        voice->level = level;
+        voice->fade = fade;
+
+        // the gate runs out to the block, so releases start on a block
+        if(voice->gate)
+        {
+            if(voice->gate <= n)
+            {
+                voice->gate = 0;
+                voice->target = 0;
+            }
+            else
+            {
+                voice->gate -= n;
+            }
+        }
+    }
+
+    for(uint16_t i = 0; i < n; i++)
+    {
+        int16_t y = (mix[i] >> SYNTH_MIX_SHIFT) + SYNTH_DAC_MID;
+
+        if(y < 0)
+        {
+            y = 0;
+        }
+        else if(y > SYNTH_DAC_MAX)
+        {
+            y = SYNTH_DAC_MAX;
+        }
+
+        out[i] = (uint16_t)y;
+    }
+}
+
+/***************************END OF FUNCTION DEFINITIONS************************/
@@ -0,0 +1,278 @@
+#ifndef SYNTH_H_  // Header guard.
+#define SYNTH_H_
+
+/*------------------------------------------------------------------------------
+  synth.h --
+
+  Description:
+    Provides a polyphonic DDS (direct digital synthesis) engine for the
+    12-bit DAC: SYNTH_VOICES voices, each a 32-bit phase accumulator
+    stepping through a SYNTH_WAVE_LEN entry wavetable at a fixed sample
+    rate, SYNTH_RATE, mixed into blocks of DAC codes.
+
+      A voice's pitch is its phase increment, f * 2^32 / SYNTH_RATE, so
+    pitch resolution is SYNTH_RATE / 2^32 Hz whatever the note; the top
+    bits of the phase index the table and the next 8 interpolate linearly
+    between two entries.
+
+      The wavetables are a bank in program memory, `synth_waves`, made by
+    host/synth_sim/wavegen (synth_waves.c): a sine, and a triangle, saw and
+    square for each of SYNTH_BANDS octaves, each holding only the
+    harmonics that stay below SYNTH_RATE / 2 at the top of its octave, so
+    no shape aliases. A note plays the table of its shape and octave.
+
+      A change of shape, `synth_set_shape`, is only staged: the next
+    `synth_render` takes it up, at a block boundary, and crossfades every
+    sounding voice from its old table to the new one over SYNTH_FADE
+    samples, at the same phase, so the timbre changes without a click.
+
+      Each voice has a level (0 to 255) that ramps one step per sample
+    towards its target, so notes start and stop without clicks, and an
+    optional gate, in samples, after which it releases by itself. Voices
+    are summed, shifted right by SYNTH_MIX_SHIFT and clipped to the DAC
+    range; one voice at full level swings over 1 / 2^SYNTH_MIX_SHIFT of
+    it.
+
+      Only integer arithmetic is used, so the code runs unchanged on the
+    AVR and on a host. The engine is not reentrant: on the AVR, notes
+    must be started and stopped with the interrupt that renders masked.
+    `synth_set_shape` is the exception, it may be called at any time.
+
+------------------------------------------------------------------------------*/
+
+/********************************DEPENDENCIES**********************************/
+
+#include <stdint.h>
+
+#ifdef __AVR__
+#include <avr/pgmspace.h>
+#endif
+
+/*****************************END OF DEPENDENCIES******************************/
+
+
+/***********************************MACROS*************************************/
+
+/* Voices mixed. */
+#ifndef SYNTH_VOICES
+#define SYNTH_VOICES            8
+#endif
+
+/* Samples per second. */
+#ifndef SYNTH_RATE
+#define SYNTH_RATE              16000UL
+#endif
+
+/* Entries per wavetable, 2^SYNTH_WAVE_BITS, indexed by the top bits of
+ * the phase. */
+#define SYNTH_WAVE_BITS         8
+#define SYNTH_WAVE_LEN          (1 << SYNTH_WAVE_BITS)
+
+/* Peak of the wavetables, signed. */
+#define SYNTH_WAVE_PEAK         2047
+
+/* Shapes. */
+#define SYNTH_SINE              0
+#define SYNTH_TRIANGLE          1
+#define SYNTH_SAW               2
+#define SYNTH_SQUARE            3
+#define SYNTH_SHAPES            4
+
+/* Band-limited octaves per shape but the sine: the first covers notes 0
+ * to 35 (up to 61.7 Hz), the others one octave each, up to 119. */
+#define SYNTH_BANDS             8
+#define SYNTH_BAND_FIRST        2
+
+/* Tables in the bank: the sine, then SYNTH_BANDS per other shape. */
+#define SYNTH_WAVES             (1 + (SYNTH_SHAPES - 1) * SYNTH_BANDS)
+
+/* The bank is read from program memory on the AVR. */
+#ifdef __AVR__
+#define SYNTH_FLASH             PROGMEM
+#define SYNTH_WAVE_READ(p)      ((int16_t)pgm_read_word(p))
+#else
+#define SYNTH_FLASH
+#define SYNTH_WAVE_READ(p)      (*(p))
+#endif
+
+/* Crossfade between shapes, 2^SYNTH_FADE_BITS samples (4 ms at 16 kHz). */
+#define SYNTH_FADE_BITS         6
+#define SYNTH_FADE              (1 << SYNTH_FADE_BITS)
+
+/* Mix scaling, see above. */
+#define SYNTH_MIX_SHIFT         1
+
+/* DAC code of silence, and the largest code. */
+#define SYNTH_DAC_MID           0x800
+#define SYNTH_DAC_MAX           0xFFF
+
+/* Highest (MIDI) note; B8, 7902 Hz, already close to Nyquist. */
+#define SYNTH_NOTE_MAX          119
+
+/* Handle of no voice, from `synth_note_on` with a level of 0. */
+#define SYNTH_HANDLE_NONE       0xFFFF
+
+#if SYNTH_RATE < 8000
+#error "SYNTH_RATE too low for the phase increments of the top octave"
+#endif
+
+/********************************END OF MACROS*********************************/
+
+
+/*******************************CUSTOM DATA TYPES******************************/
+
+/* One voice. It is free while both `level` and `target` are 0. While
+ * `fade` counts down, `fade_wave` is faded out. `serial` tells the notes
+ * started on it apart, see `synth_voice_off`. */
+typedef struct synth_voice
+{
+  uint32_t phase;
+  uint32_t inc;
+  const int16_t * wave;
+  const int16_t * fade_wave;
+  uint8_t fade;
+
+  uint16_t gate;
+  uint8_t note;
+  uint8_t level;
+  uint8_t target;
+  uint8_t serial;
+}synth_voice_t;
+
+/* Engine state; `shape` is the shape the voices play, `shape_next` the
+ * one staged, which new notes already start with. `serial` counts the
+ * notes started. */
+typedef struct synth
+{
+  synth_voice_t voice[SYNTH_VOICES];
+  uint8_t shape;
+  volatile uint8_t shape_next;
+  uint8_t next;
+  uint8_t serial;
+}synth_t;
+
+/***************************END OF CUSTOM DATA TYPES***************************/
+
+
+/******************************GLOBAL VARIABLES********************************/
+
+/* Wavetable bank (synth_waves.c), signed, peaking at SYNTH_WAVE_PEAK. */
+extern const int16_t synth_waves[SYNTH_WAVES][SYNTH_WAVE_LEN] SYNTH_FLASH;
+
+/***************************END OF GLOBAL VARIABLES****************************/
+
+
+/*****************************FUNCTION PROTOTYPES******************************/
+
+/*------------------------------------------------------------------------------
+  synth_init --
+
+  Description:
+    Silences every voice and selects SYNTH_SINE for new notes.
+
+  Input(s): `syn` - Engine.
+  Output(s): N/A
+------------------------------------------------------------------------------*/
+void synth_init(synth_t * syn);
+
+/*------------------------------------------------------------------------------
+  synth_increment --
+
+  Description:
+    Phase increment of a (MIDI) note at SYNTH_RATE, in equal temperament
+    with A4 (69) at 440 Hz. Notes above SYNTH_NOTE_MAX are clamped.
+
+  Input(s): `note` - Note, 60 is middle C.
+  Output(s): Phase increment per sample.
+------------------------------------------------------------------------------*/
+uint32_t synth_increment(uint8_t note);
+
+/*------------------------------------------------------------------------------
+  synth_wave --
+
+  Description:
+    Wavetable of a shape for a note: the band of the note's octave.
+
+  Input(s): `shape` - Shape, SYNTH_SINE to SYNTH_SQUARE.
+            `note`  - Note.
+  Output(s): Table in `synth_waves`.
+------------------------------------------------------------------------------*/
+const int16_t * synth_wave(uint8_t shape, uint8_t note);
+
+/*------------------------------------------------------------------------------
+  synth_set_shape --
+
+  Description:
+    Stages a shape for the sounding voices and for new notes, taken up
+    by the next `synth_render`. Safe to call while rendering runs.
+
+  Input(s): `syn`   - Engine.
+            `shape` - Shape, SYNTH_SINE to SYNTH_SQUARE.
+  Output(s): N/A
+------------------------------------------------------------------------------*/
+void synth_set_shape(synth_t * syn, uint8_t shape);
+
+/*------------------------------------------------------------------------------
+  synth_note_on --
+
+  Description:
+    Starts a note of the current shape on a free voice, or failing that
+    on the quietest voice releasing, or else on the voices in turn. The
+    voice ramps up to `level`; after `gate` samples it releases by itself,
+    or with a `gate` of 0 it holds until `synth_note_off` or
+    `synth_voice_off`. A `level` of 0 stops the note, as `synth_note_off`
+    does.
+
+  Input(s): `syn`   - Engine.
+            `note`  - Note.
+            `level` - Level, 1 to 255.
+            `gate`  - Samples to hold the note, 0 until released.
+  Output(s): Handle of the voice started, for `synth_voice_off`, or
+             SYNTH_HANDLE_NONE with a `level` of 0.
+------------------------------------------------------------------------------*/
+uint16_t synth_note_on(synth_t * syn, uint8_t note, uint8_t level, uint16_t gate);
+
+/*------------------------------------------------------------------------------
+  synth_note_off --
+
+  Description:
+    Releases every voice playing `note`.
+
+  Input(s): `syn`  - Engine.
+            `note` - Note.
+  Output(s): N/A
+------------------------------------------------------------------------------*/
+void synth_note_off(synth_t * syn, uint8_t note);
+
+/*------------------------------------------------------------------------------
+  synth_voice_off --
+
+  Description:
+    Releases the one voice a `synth_note_on` started, leaving any others
+    on the same note sounding. Nothing happens if the voice has since
+    been taken for another note (unless 256 notes have been started on it
+    meanwhile, which the handle cannot tell apart).
+
+  Input(s): `syn`    - Engine.
+            `handle` - Handle from `synth_note_on`.
+  Output(s): N/A
+------------------------------------------------------------------------------*/
+void synth_voice_off(synth_t * syn, uint16_t handle);
+
+/*------------------------------------------------------------------------------
+  synth_render --
+
+  Description:
+    Takes up a staged shape, then renders the next `n` samples of the mix
+    as DAC codes. Silent voices cost nothing.
+
+  Input(s): `syn` - Engine.
+            `out` - Where the samples are stored.
+            `n`   - Samples.
+  Output(s): N/A
+------------------------------------------------------------------------------*/
+void synth_render(synth_t * syn, uint16_t * out, uint16_t n);
+
+/**************************END OF FUNCTION PROTOTYPES**************************/
+
+#endif // End of header guard.
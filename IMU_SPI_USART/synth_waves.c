@@ -0,0 +1,508 @@
+/*------------------------------------------------------------------------------
+  synth_waves.c --
+
+  Description:
+    Wavetable bank of the DDS engine, see `synth.h`. Generated by
+    host/synth_sim/wavegen.c for a SYNTH_RATE of 16000 Hz; do not edit.
+
+------------------------------------------------------------------------------*/
+
+/********************************DEPENDENCIES**********************************/
+
+#include <stdint.h>
+#include "synth.h"
+
+/*****************************END OF DEPENDENCIES******************************/
+
+
+/***********************************MACROS*************************************/
+
+#if SYNTH_RATE != 16000UL || SYNTH_WAVE_LEN != 256 || SYNTH_WAVES != 25
+#error "synth_waves.c is for another SYNTH_RATE or bank, run wavegen again"
+#endif
+
+/********************************END OF MACROS*********************************/
+
+
+/******************************GLOBAL VARIABLES********************************/
+
+const int16_t synth_waves[SYNTH_WAVES][SYNTH_WAVE_LEN] SYNTH_FLASH =
+{
+    // sine
+    {
+        0, 50, 100, 151, 201, 251, 300, 350, 399, 449, 497, 546, 594, 642, 690, 737,
+        783, 830, 875, 920, 965, 1009, 1052, 1095, 1137, 1179, 1219, 1259, 1299, 1337, 1375, 1411,
+        1447, 1483, 1517, 1550, 1582, 1614, 1644, 1674, 1702, 1729, 1756, 1781, 1805, 1828, 1850, 1871,
+        1891, 1910, 1927, 1944, 1959, 1973, 1986, 1997, 2008, 2017, 2025, 2032, 2037, 2041, 2045, 2046,
+        2047, 2046, 2045, 2041, 2037, 2032, 2025, 2017, 2008, 1997, 1986, 1973, 1959, 1944, 1927, 1910,
+        1891, 1871, 1850, 1828, 1805, 1781, 1756, 1729, 1702, 1674, 1644, 1614, 1582, 1550, 1517, 1483,
+        1447, 1411, 1375, 1337, 1299, 1259, 1219, 1179, 1137, 1095, 1052, 1009, 965, 920, 875, 830,
+        783, 737, 690, 642, 594, 546, 497, 449, 399, 350, 300, 251, 201, 151, 100, 50,
+        0, -50, -100, -151, -201, -251, -300, -350, -399, -449, -497, -546, -594, -642, -690, -737,
+        -783, -830, -875, -920, -965, -1009, -1052, -1095, -1137, -1179, -1219, -1259, -1299, -1337, -1375, -1411,
+        -1447, -1483, -1517, -1550, -1582, -1614, -1644, -1674, -1702, -1729, -1756, -1781, -1805, -1828, -1850, -1871,
+        -1891, -1910, -1927, -1944, -1959, -1973, -1986, -1997, -2008, -2017, -2025, -2032, -2037, -2041, -2045, -2046,
+        -2047, -2046, -2045, -2041, -2037, -2032, -2025, -2017, -2008, -1997, -1986, -1973, -1959, -1944, -1927, -1910,
+        -1891, -1871, -1850, -1828, -1805, -1781, -1756, -1729, -1702, -1674, -1644, -1614, -1582, -1550, -1517, -1483,
+        -1447, -1411, -1375, -1337, -1299, -1259, -1219, -1179, -1137, -1095, -1052, -1009, -965, -920, -875, -830,
+        -783, -737, -690, -642, -594, -546, -497, -449, -399, -350, -300, -251, -201, -151, -100, -50
+    },
+    // triangle, notes 0 to 35, 127 harmonics
+    {
+        0, 32, 64, 96, 128, 160, 193, 225, 257, 289, 321, 353, 385, 417, 449, 481,
+        513, 545, 578, 610, 642, 674, 706, 738, 770, 802, 834, 866, 898, 930, 963, 995,
+        1027, 1059, 1091, 1123, 1155, 1187, 1219, 1251, 1283, 1316, 1348, 1380, 1412, 1444, 1476, 1508,
+        1540, 1572, 1604, 1636, 1668, 1701, 1733, 1765, 1797, 1829, 1861, 1893, 1925, 1957, 1989, 2022,
+        2047, 2022, 1989, 1957, 1925, 1893, 1861, 1829, 1797, 1765, 1733, 1701, 1668, 1636, 1604, 1572,
+        1540, 1508, 1476, 1444, 1412, 1380, 1348, 1316, 1283, 1251, 1219, 1187, 1155, 1123, 1091, 1059,
+        1027, 995, 963, 930, 898, 866, 834, 802, 770, 738, 706, 674, 642, 610, 578, 545,
+        513, 481, 449, 417, 385, 353, 321, 289, 257, 225, 193, 160, 128, 96, 64, 32,
+        0, -32, -64, -96, -128, -160, -193, -225, -257, -289, -321, -353, -385, -417, -449, -481,
+        -513, -545, -578, -610, -642, -674, -706, -738, -770, -802, -834, -866, -898, -930, -963, -995,
+        -1027, -1059, -1091, -1123, -1155, -1187, -1219, -1251, -1283, -1316, -1348, -1380, -1412, -1444, -1476, -1508,
+        -1540, -1572, -1604, -1636, -1668, -1701, -1733, -1765, -1797, -1829, -1861, -1893, -1925, -1957, -1989, -2022,
+        -2047, -2022, -1989, -1957, -1925, -1893, -1861, -1829, -1797, -1765, -1733, -1701, -1668, -1636, -1604, -1572,
+        -1540, -1508, -1476, -1444, -1412, -1380, -1348, -1316, -1283, -1251, -1219, -1187, -1155, -1123, -1091, -1059,
+        -1027, -995, -963, -930, -898, -866, -834, -802, -770, -738, -706, -674, -642, -610, -578, -545,
+        -513, -481, -449, -417, -385, -353, -321, -289, -257, -225, -193, -160, -128, -96, -64, -32
+    },
+    // triangle, notes 36 to 47, 64 harmonics
+    {
+        0, 32, 64, 96, 128, 160, 193, 225, 257, 289, 321, 353, 385, 417, 449, 482,
+        513, 545, 578, 610, 642, 674, 706, 738, 770, 802, 834, 867, 898, 930, 963, 995,
+        1027, 1059, 1091, 1123, 1155, 1187, 1219, 1252, 1283, 1315, 1348, 1380, 1412, 1443, 1476, 1509,
+        1540, 1572, 1604, 1637, 1668, 1700, 1733, 1766, 1797, 1828, 1861, 1895, 1925, 1955, 1991, 2026,
+        2040, 2026, 1991, 1955, 1925, 1895, 1861, 1828, 1797, 1766, 1733, 1700, 1668, 1637, 1604, 1572,
+        1540, 1509, 1476, 1443, 1412, 1380, 1348, 1315, 1283, 1252, 1219, 1187, 1155, 1123, 1091, 1059,
+        1027, 995, 963, 930, 898, 867, 834, 802, 770, 738, 706, 674, 642, 610, 578, 545,
+        513, 482, 449, 417, 385, 353, 321, 289, 257, 225, 193, 160, 128, 96, 64, 32,
+        0, -32, -64, -96, -128, -160, -193, -225, -257, -289, -321, -353, -385, -417, -449, -482,
+        -513, -545, -578, -610, -642, -674, -706, -738, -770, -802, -834, -867, -898, -930, -963, -995,
+        -1027, -1059, -1091, -1123, -1155, -1187, -1219, -1252, -1283, -1315, -1348, -1380, -1412, -1443, -1476, -1509,
+        -1540, -1572, -1604, -1637, -1668, -1700, -1733, -1766, -1797, -1828, -1861, -1895, -1925, -1955, -1991, -2026,
+        -2040, -2026, -1991, -1955, -1925, -1895, -1861, -1828, -1797, -1766, -1733, -1700, -1668, -1637, -1604, -1572,
+        -1540, -1509, -1476, -1443, -1412, -1380, -1348, -1315, -1283, -1252, -1219, -1187, -1155, -1123, -1091, -1059,
+        -1027, -995, -963, -930, -898, -867, -834, -802, -770, -738, -706, -674, -642, -610, -578, -545,
+        -513, -482, -449, -417, -385, -353, -321, -289, -257, -225, -193, -160, -128, -96, -64, -32
+    },
+    // triangle, notes 48 to 59, 32 harmonics
+    {
+        0, 32, 63, 96, 128, 161, 193, 225, 257, 288, 320, 352, 385, 418, 450, 482,
+        513, 545, 577, 609, 642, 674, 707, 739, 770, 801, 833, 866, 898, 931, 964, 995,
+        1027, 1058, 1090, 1122, 1155, 1188, 1221, 1252, 1283, 1314, 1346, 1379, 1412, 1445, 1478, 1509,
+        1540, 1570, 1602, 1635, 1669, 1703, 1736, 1767, 1796, 1825, 1856, 1891, 1928, 1965, 1998, 2020,
+        2028, 2020, 1998, 1965, 1928, 1891, 1856, 1825, 1796, 1767, 1736, 1703, 1669, 1635, 1602, 1570,
+        1540, 1509, 1478, 1445, 1412, 1379, 1346, 1314, 1283, 1252, 1221, 1188, 1155, 1122, 1090, 1058,
+        1027, 995, 964, 931, 898, 866, 833, 801, 770, 739, 707, 674, 642, 609, 577, 545,
+        513, 482, 450, 418, 385, 352, 320, 288, 257, 225, 193, 161, 128, 96, 63, 32,
+        0, -32, -63, -96, -128, -161, -193, -225, -257, -288, -320, -352, -385, -418, -450, -482,
+        -513, -545, -577, -609, -642, -674, -707, -739, -770, -801, -833, -866, -898, -931, -964, -995,
+        -1027, -1058, -1090, -1122, -1155, -1188, -1221, -1252, -1283, -1314, -1346, -1379, -1412, -1445, -1478, -1509,
+        -1540, -1570, -1602, -1635, -1669, -1703, -1736, -1767, -1796, -1825, -1856, -1891, -1928, -1965, -1998, -2020,
+        -2028, -2020, -1998, -1965, -1928, -1891, -1856, -1825, -1796, -1767, -1736, -1703, -1669, -1635, -1602, -1570,
+        -1540, -1509, -1478, -1445, -1412, -1379, -1346, -1314, -1283, -1252, -1221, -1188, -1155, -1122, -1090, -1058,
+        -1027, -995, -964, -931, -898, -866, -833, -801, -770, -739, -707, -674, -642, -609, -577, -545,
+        -513, -482, -450, -418, -385, -352, -320, -288, -257, -225, -193, -161, -128, -96, -63, -32
+    },
+    // triangle, notes 60 to 71, 16 harmonics
+    {
+        0, 31, 62, 93, 125, 157, 190, 223, 257, 290, 323, 356, 388, 420, 452, 482,
+        513, 544, 575, 606, 638, 671, 703, 737, 770, 804, 837, 870, 903, 934, 965, 996,
+        1026, 1057, 1087, 1118, 1150, 1183, 1216, 1250, 1284, 1319, 1353, 1386, 1418, 1449, 1480, 1509,
+        1538, 1567, 1597, 1627, 1659, 1693, 1728, 1765, 1803, 1841, 1877, 1911, 1942, 1967, 1986, 1998,
+        2002, 1998, 1986, 1967, 1942, 1911, 1877, 1841, 1803, 1765, 1728, 1693, 1659, 1627, 1597, 1567,
+        1538, 1509, 1480, 1449, 1418, 1386, 1353, 1319, 1284, 1250, 1216, 1183, 1150, 1118, 1087, 1057,
+        1026, 996, 965, 934, 903, 870, 837, 804, 770, 737, 703, 671, 638, 606, 575, 544,
+        513, 482, 452, 420, 388, 356, 323, 290, 257, 223, 190, 157, 125, 93, 62, 31,
+        0, -31, -62, -93, -125, -157, -190, -223, -257, -290, -323, -356, -388, -420, -452, -482,
+        -513, -544, -575, -606, -638, -671, -703, -737, -770, -804, -837, -870, -903, -934, -965, -996,
+        -1026, -1057, -1087, -1118, -1150, -1183, -1216, -1250, -1284, -1319, -1353, -1386, -1418, -1449, -1480, -1509,
+        -1538, -1567, -1597, -1627, -1659, -1693, -1728, -1765, -1803, -1841, -1877, -1911, -1942, -1967, -1986, -1998,
+        -2002, -1998, -1986, -1967, -1942, -1911, -1877, -1841, -1803, -1765, -1728, -1693, -1659, -1627, -1597, -1567,
+        -1538, -1509, -1480, -1449, -1418, -1386, -1353, -1319, -1284, -1250, -1216, -1183, -1150, -1118, -1087, -1057,
+        -1026, -996, -965, -934, -903, -870, -837, -804, -770, -737, -703, -671, -638, -606, -575, -544,
+        -513, -482, -452, -420, -388, -356, -323, -290, -257, -223, -190, -157, -125, -93, -62, -31
+    },
+    // triangle, notes 72 to 83, 8 harmonics
+    {
+        0, 30, 59, 89, 119, 150, 181, 212, 244, 276, 309, 343, 377, 411, 445, 480,
+        515, 549, 584, 619, 653, 686, 720, 752, 785, 816, 847, 877, 907, 937, 966, 995,
+        1023, 1052, 1081, 1110, 1139, 1169, 1200, 1231, 1264, 1297, 1331, 1366, 1402, 1439, 1476, 1514,
+        1552, 1590, 1627, 1664, 1701, 1736, 1769, 1801, 1830, 1857, 1880, 1901, 1918, 1932, 1942, 1948,
+        1950, 1948, 1942, 1932, 1918, 1901, 1880, 1857, 1830, 1801, 1769, 1736, 1701, 1664, 1627, 1590,
+        1552, 1514, 1476, 1439, 1402, 1366, 1331, 1297, 1264, 1231, 1200, 1169, 1139, 1110, 1081, 1052,
+        1023, 995, 966, 937, 907, 877, 847, 816, 785, 752, 720, 686, 653, 619, 584, 549,
+        515, 480, 445, 411, 377, 343, 309, 276, 244, 212, 181, 150, 119, 89, 59, 30,
+        0, -30, -59, -89, -119, -150, -181, -212, -244, -276, -309, -343, -377, -411, -445, -480,
+        -515, -549, -584, -619, -653, -686, -720, -752, -785, -816, -847, -877, -907, -937, -966, -995,
+        -1023, -1052, -1081, -1110, -1139, -1169, -1200, -1231, -1264, -1297, -1331, -1366, -1402, -1439, -1476, -1514,
+        -1552, -1590, -1627, -1664, -1701, -1736, -1769, -1801, -1830, -1857, -1880, -1901, -1918, -1932, -1942, -1948,
+        -1950, -1948, -1942, -1932, -1918, -1901, -1880, -1857, -1830, -1801, -1769, -1736, -1701, -1664, -1627, -1590,
+        -1552, -1514, -1476, -1439, -1402, -1366, -1331, -1297, -1264, -1231, -1200, -1169, -1139, -1110, -1081, -1052,
+        -1023, -995, -966, -937, -907, -877, -847, -816, -785, -752, -720, -686, -653, -619, -584, -549,
+        -515, -480, -445, -411, -377, -343, -309, -276, -244, -212, -181, -150, -119, -89, -59, -30
+    },
+    // triangle, notes 84 to 95, 4 harmonics
+    {
+        0, 27, 55, 82, 109, 137, 165, 193, 222, 251, 280, 310, 340, 371, 402, 434,
+        466, 499, 532, 566, 601, 636, 671, 707, 743, 780, 817, 855, 893, 931, 969, 1008,
+        1046, 1085, 1123, 1161, 1199, 1237, 1275, 1312, 1348, 1384, 1419, 1453, 1486, 1518, 1550, 1580,
+        1609, 1636, 1662, 1687, 1710, 1732, 1752, 1770, 1786, 1801, 1814, 1825, 1833, 1840, 1845, 1848,
+        1849, 1848, 1845, 1840, 1833, 1825, 1814, 1801, 1786, 1770, 1752, 1732, 1710, 1687, 1662, 1636,
+        1609, 1580, 1550, 1518, 1486, 1453, 1419, 1384, 1348, 1312, 1275, 1237, 1199, 1161, 1123, 1085,
+        1046, 1008, 969, 931, 893, 855, 817, 780, 743, 707, 671, 636, 601, 566, 532, 499,
+        466, 434, 402, 371, 340, 310, 280, 251, 222, 193, 165, 137, 109, 82, 55, 27,
+        0, -27, -55, -82, -109, -137, -165, -193, -222, -251, -280, -310, -340, -371, -402, -434,
+        -466, -499, -532, -566, -601, -636, -671, -707, -743, -780, -817, -855, -893, -931, -969, -1008,
+        -1046, -1085, -1123, -1161, -1199, -1237, -1275, -1312, -1348, -1384, -1419, -1453, -1486, -1518, -1550, -1580,
+        -1609, -1636, -1662, -1687, -1710, -1732, -1752, -1770, -1786, -1801, -1814, -1825, -1833, -1840, -1845, -1848,
+        -1849, -1848, -1845, -1840, -1833, -1825, -1814, -1801, -1786, -1770, -1752, -1732, -1710, -1687, -1662, -1636,
+        -1609, -1580, -1550, -1518, -1486, -1453, -1419, -1384, -1348, -1312, -1275, -1237, -1199, -1161, -1123, -1085,
+        -1046, -1008, -969, -931, -893, -855, -817, -780, -743, -707, -671, -636, -601, -566, -532, -499,
+        -466, -434, -402, -371, -340, -310, -280, -251, -222, -193, -165, -137, -109, -82, -55, -27
+    },
+    // triangle, notes 96 to 107, 2 harmonics
+    {
+        0, 41, 82, 122, 163, 204, 244, 285, 325, 365, 404, 444, 483, 522, 561, 599,
+        637, 675, 712, 748, 785, 820, 856, 891, 925, 958, 992, 1024, 1056, 1087, 1118, 1148,
+        1177, 1206, 1233, 1260, 1287, 1312, 1337, 1361, 1384, 1406, 1428, 1448, 1468, 1487, 1505, 1522,
+        1538, 1553, 1567, 1580, 1593, 1604, 1615, 1624, 1633, 1640, 1646, 1652, 1656, 1660, 1663, 1664,
+        1665, 1664, 1663, 1660, 1656, 1652, 1646, 1640, 1633, 1624, 1615, 1604, 1593, 1580, 1567, 1553,
+        1538, 1522, 1505, 1487, 1468, 1448, 1428, 1406, 1384, 1361, 1337, 1312, 1287, 1260, 1233, 1206,
+        1177, 1148, 1118, 1087, 1056, 1024, 992, 958, 925, 891, 856, 820, 785, 748, 712, 675,
+        637, 599, 561, 522, 483, 444, 404, 365, 325, 285, 244, 204, 163, 122, 82, 41,
+        0, -41, -82, -122, -163, -204, -244, -285, -325, -365, -404, -444, -483, -522, -561, -599,
+        -637, -675, -712, -748, -785, -820, -856, -891, -925, -958, -992, -1024, -1056, -1087, -1118, -1148,
+        -1177, -1206, -1233, -1260, -1287, -1312, -1337, -1361, -1384, -1406, -1428, -1448, -1468, -1487, -1505, -1522,
+        -1538, -1553, -1567, -1580, -1593, -1604, -1615, -1624, -1633, -1640, -1646, -1652, -1656, -1660, -1663, -1664,
+        -1665, -1664, -1663, -1660, -1656, -1652, -1646, -1640, -1633, -1624, -1615, -1604, -1593, -1580, -1567, -1553,
+        -1538, -1522, -1505, -1487, -1468, -1448, -1428, -1406, -1384, -1361, -1337, -1312, -1287, -1260, -1233, -1206,
+        -1177, -1148, -1118, -1087, -1056, -1024, -992, -958, -925, -891, -856, -820, -785, -748, -712, -675,
+        -637, -599, -561, -522, -483, -444, -404, -365, -325, -285, -244, -204, -163, -122, -82, -41
+    },
+    // triangle, notes 108 to 119, 1 harmonics
+    {
+        0, 41, 82, 122, 163, 204, 244, 285, 325, 365, 404, 444, 483, 522, 561, 599,
+        637, 675, 712, 748, 785, 820, 856, 891, 925, 958, 992, 1024, 1056, 1087, 1118, 1148,
+        1177, 1206, 1233, 1260, 1287, 1312, 1337, 1361, 1384, 1406, 1428, 1448, 1468, 1487, 1505, 1522,
+        1538, 1553, 1567, 1580, 1593, 1604, 1615, 1624, 1633, 1640, 1646, 1652, 1656, 1660, 1663, 1664,
+        1665, 1664, 1663, 1660, 1656, 1652, 1646, 1640, 1633, 1624, 1615, 1604, 1593, 1580, 1567, 1553,
+        1538, 1522, 1505, 1487, 1468, 1448, 1428, 1406, 1384, 1361, 1337, 1312, 1287, 1260, 1233, 1206,
+        1177, 1148, 1118, 1087, 1056, 1024, 992, 958, 925, 891, 856, 820, 785, 748, 712, 675,
+        637, 599, 561, 522, 483, 444, 404, 365, 325, 285, 244, 204, 163, 122, 82, 41,
+        0, -41, -82, -122, -163, -204, -244, -285, -325, -365, -404, -444, -483, -522, -561, -599,
+        -637, -675, -712, -748, -785, -820, -856, -891, -925, -958, -992, -1024, -1056, -1087, -1118, -1148,
+        -1177, -1206, -1233, -1260, -1287, -1312, -1337, -1361, -1384, -1406, -1428, -1448, -1468, -1487, -1505, -1522,
+        -1538, -1553, -1567, -1580, -1593, -1604, -1615, -1624, -1633, -1640, -1646, -1652, -1656, -1660, -1663, -1664,
+        -1665, -1664, -1663, -1660, -1656, -1652, -1646, -1640, -1633, -1624, -1615, -1604, -1593, -1580, -1567, -1553,
+        -1538, -1522, -1505, -1487, -1468, -1448, -1428, -1406, -1384, -1361, -1337, -1312, -1287, -1260, -1233, -1206,
+        -1177, -1148, -1118, -1087, -1056, -1024, -992, -958, -925, -891, -856, -820, -785, -748, -712, -675,
+        -637, -599, -561, -522, -483, -444, -404, -365, -325, -285, -244, -204, -163, -122, -82, -41
+    },
+    // saw, notes 0 to 35, 127 harmonics
+    {
+        0, 2047, 1551, 1823, 1606, 1750, 1607, 1703, 1595, 1664, 1576, 1630, 1555, 1597, 1532, 1566,
+        1508, 1536, 1483, 1507, 1457, 1478, 1432, 1449, 1406, 1420, 1380, 1392, 1353, 1364, 1327, 1335,
+        1300, 1307, 1274, 1279, 1247, 1252, 1220, 1224, 1194, 1196, 1167, 1168, 1140, 1140, 1113, 1113,
+        1086, 1085, 1059, 1057, 1032, 1030, 1005, 1002, 978, 975, 951, 947, 924, 920, 897, 892,
+        870, 865, 842, 837, 815, 809, 788, 782, 761, 755, 734, 727, 707, 700, 680, 672,
+        653, 645, 625, 617, 598, 590, 571, 562, 544, 535, 517, 507, 490, 480, 462, 452,
+        435, 425, 408, 398, 381, 370, 354, 343, 326, 315, 299, 288, 272, 260, 245, 233,
+        218, 206, 190, 178, 163, 151, 136, 123, 109, 96, 82, 69, 54, 41, 27, 14,
+        0, -14, -27, -41, -54, -69, -82, -96, -109, -123, -136, -151, -163, -178, -190, -206,
+        -218, -233, -245, -260, -272, -288, -299, -315, -326, -343, -354, -370, -381, -398, -408, -425,
+        -435, -452, -462, -480, -490, -507, -517, -535, -544, -562, -571, -590, -598, -617, -625, -645,
+        -653, -672, -680, -700, -707, -727, -734, -755, -761, -782, -788, -809, -815, -837, -842, -865,
+        -870, -892, -897, -920, -924, -947, -951, -975, -978, -1002, -1005, -1030, -1032, -1057, -1059, -1085,
+        -1086, -1113, -1113, -1140, -1140, -1168, -1167, -1196, -1194, -1224, -1220, -1252, -1247, -1279, -1274, -1307,
+        -1300, -1335, -1327, -1364, -1353, -1392, -1380, -1420, -1406, -1449, -1432, -1478, -1457, -1507, -1483, -1536,
+        -1508, -1566, -1532, -1597, -1555, -1630, -1576, -1664, -1595, -1703, -1607, -1750, -1606, -1823, -1551, -2047
+    },
+    // saw, notes 36 to 47, 64 harmonics
+    {
+        0, 1520, 2033, 1740, 1524, 1672, 1781, 1652, 1551, 1628, 1681, 1593, 1526, 1576, 1607, 1536,
+        1486, 1523, 1541, 1481, 1440, 1469, 1479, 1426, 1392, 1414, 1419, 1371, 1341, 1360, 1361, 1316,
+        1290, 1305, 1303, 1262, 1238, 1251, 1246, 1207, 1185, 1196, 1190, 1152, 1133, 1142, 1133, 1098,
+        1079, 1087, 1077, 1043, 1026, 1033, 1022, 988, 973, 978, 966, 934, 919, 923, 910, 879,
+        865, 869, 855, 824, 811, 814, 799, 770, 758, 760, 744, 715, 704, 705, 689, 661,
+        650, 650, 634, 606, 596, 596, 578, 551, 542, 541, 523, 497, 487, 487, 468, 442,
+        433, 432, 413, 387, 379, 377, 358, 333, 325, 323, 303, 278, 271, 268, 248, 224,
+        217, 213, 193, 169, 163, 159, 138, 114, 108, 104, 83, 60, 54, 50, 28, 5,
+        0, -5, -28, -50, -54, -60, -83, -104, -108, -114, -138, -159, -163, -169, -193, -213,
+        -217, -224, -248, -268, -271, -278, -303, -323, -325, -333, -358, -377, -379, -387, -413, -432,
+        -433, -442, -468, -487, -487, -497, -523, -541, -542, -551, -578, -596, -596, -606, -634, -650,
+        -650, -661, -689, -705, -704, -715, -744, -760, -758, -770, -799, -814, -811, -824, -855, -869,
+        -865, -879, -910, -923, -919, -934, -966, -978, -973, -988, -1022, -1033, -1026, -1043, -1077, -1087,
+        -1079, -1098, -1133, -1142, -1133, -1152, -1190, -1196, -1185, -1207, -1246, -1251, -1238, -1262, -1303, -1305,
+        -1290, -1316, -1361, -1360, -1341, -1371, -1419, -1414, -1392, -1426, -1479, -1469, -1440, -1481, -1541, -1523,
+        -1486, -1536, -1607, -1576, -1526, -1593, -1681, -1628, -1551, -1652, -1781, -1672, -1524, -1740, -2033, -1520
+    },
+    // saw, notes 48 to 59, 32 harmonics
+    {
+        0, 843, 1515, 1907, 2006, 1891, 1690, 1527, 1469, 1516, 1612, 1688, 1699, 1640, 1548, 1471,
+        1443, 1466, 1514, 1548, 1544, 1498, 1434, 1382, 1363, 1378, 1407, 1425, 1414, 1374, 1323, 1283,
+        1269, 1280, 1299, 1308, 1293, 1256, 1213, 1180, 1169, 1177, 1191, 1193, 1176, 1142, 1103, 1076,
+        1066, 1073, 1082, 1080, 1061, 1028, 994, 970, 962, 967, 973, 968, 948, 916, 884, 863,
+        857, 860, 863, 856, 835, 805, 775, 756, 750, 753, 754, 745, 723, 693, 666, 649,
+        644, 646, 645, 634, 611, 582, 556, 541, 537, 538, 536, 523, 500, 471, 447, 433,
+        430, 430, 427, 413, 389, 361, 338, 325, 322, 323, 318, 302, 277, 250, 229, 217,
+        215, 215, 208, 192, 166, 140, 119, 109, 108, 107, 99, 81, 55, 29, 10, 1,
+        0, -1, -10, -29, -55, -81, -99, -107, -108, -109, -119, -140, -166, -192, -208, -215,
+        -215, -217, -229, -250, -277, -302, -318, -323, -322, -325, -338, -361, -389, -413, -427, -430,
+        -430, -433, -447, -471, -500, -523, -536, -538, -537, -541, -556, -582, -611, -634, -645, -646,
+        -644, -649, -666, -693, -723, -745, -754, -753, -750, -756, -775, -805, -835, -856, -863, -860,
+        -857, -863, -884, -916, -948, -968, -973, -967, -962, -970, -994, -1028, -1061, -1080, -1082, -1073,
+        -1066, -1076, -1103, -1142, -1176, -1193, -1191, -1177, -1169, -1180, -1213, -1256, -1293, -1308, -1299, -1280,
+        -1269, -1283, -1323, -1374, -1414, -1425, -1407, -1378, -1363, -1382, -1434, -1498, -1544, -1548, -1514, -1466,
+        -1443, -1471, -1548, -1640, -1699, -1688, -1612, -1516, -1469, -1527, -1690, -1891, -2006, -1907, -1515, -843
+    },
+    // saw, notes 60 to 71, 16 harmonics
+    {
+        0, 433, 842, 1205, 1505, 1731, 1878, 1948, 1950, 1899, 1809, 1701, 1591, 1494, 1420, 1376,
+        1362, 1374, 1406, 1449, 1492, 1528, 1549, 1550, 1532, 1497, 1449, 1394, 1340, 1292, 1256, 1235,
+        1228, 1234, 1249, 1268, 1285, 1297, 1298, 1288, 1266, 1234, 1196, 1155, 1116, 1083, 1059, 1045,
+        1041, 1044, 1053, 1062, 1070, 1071, 1064, 1049, 1025, 995, 961, 927, 896, 871, 853, 842,
+        839, 842, 846, 851, 852, 848, 836, 818, 793, 764, 733, 703, 677, 656, 642, 634,
+        632, 634, 636, 637, 634, 626, 611, 590, 565, 536, 508, 481, 458, 441, 430, 424,
+        423, 423, 424, 422, 416, 404, 387, 364, 338, 311, 283, 259, 239, 225, 216, 212,
+        212, 212, 211, 206, 198, 183, 163, 139, 113, 85, 60, 38, 21, 9, 3, 0,
+        0, 0, -3, -9, -21, -38, -60, -85, -113, -139, -163, -183, -198, -206, -211, -212,
+        -212, -212, -216, -225, -239, -259, -283, -311, -338, -364, -387, -404, -416, -422, -424, -423,
+        -423, -424, -430, -441, -458, -481, -508, -536, -565, -590, -611, -626, -634, -637, -636, -634,
+        -632, -634, -642, -656, -677, -703, -733, -764, -793, -818, -836, -848, -852, -851, -846, -842,
+        -839, -842, -853, -871, -896, -927, -961, -995, -1025, -1049, -1064, -1071, -1070, -1062, -1053, -1044,
+        -1041, -1045, -1059, -1083, -1116, -1155, -1196, -1234, -1266, -1288, -1298, -1297, -1285, -1268, -1249, -1234,
+        -1228, -1235, -1256, -1292, -1340, -1394, -1449, -1497, -1532, -1550, -1549, -1528, -1492, -1449, -1406, -1374,
+        -1362, -1376, -1420, -1494, -1591, -1701, -1809, -1899, -1950, -1948, -1878, -1731, -1505, -1205, -842, -433
+    },
+    // saw, notes 72 to 83, 8 harmonics
+    {
+        0, 218, 433, 641, 839, 1025, 1196, 1349, 1484, 1599, 1693, 1766, 1818, 1850, 1862, 1858,
+        1838, 1804, 1759, 1706, 1646, 1583, 1518, 1455, 1394, 1338, 1288, 1245, 1210, 1183, 1164, 1154,
+        1150, 1153, 1162, 1174, 1190, 1207, 1224, 1240, 1253, 1263, 1269, 1270, 1265, 1255, 1240, 1219,
+        1194, 1165, 1133, 1098, 1062, 1026, 990, 956, 924, 895, 870, 849, 833, 820, 812, 807,
+        805, 807, 810, 814, 819, 823, 827, 828, 827, 823, 816, 805, 791, 773, 752, 728,
+        701, 673, 644, 614, 585, 556, 529, 505, 482, 463, 446, 433, 423, 416, 411, 409,
+        408, 409, 410, 411, 411, 409, 406, 401, 393, 382, 368, 351, 331, 309, 285, 259,
+        232, 205, 177, 151, 125, 101, 80, 60, 44, 30, 20, 12, 6, 3, 1, 0,
+        0, 0, -1, -3, -6, -12, -20, -30, -44, -60, -80, -101, -125, -151, -177, -205,
+        -232, -259, -285, -309, -331, -351, -368, -382, -393, -401, -406, -409, -411, -411, -410, -409,
+        -408, -409, -411, -416, -423, -433, -446, -463, -482, -505, -529, -556, -585, -614, -644, -673,
+        -701, -728, -752, -773, -791, -805, -816, -823, -827, -828, -827, -823, -819, -814, -810, -807,
+        -805, -807, -812, -820, -833, -849, -870, -895, -924, -956, -990, -1026, -1062, -1098, -1133, -1165,
+        -1194, -1219, -1240, -1255, -1265, -1270, -1269, -1263, -1253, -1240, -1224, -1207, -1190, -1174, -1162, -1153,
+        -1150, -1154, -1164, -1183, -1210, -1245, -1288, -1338, -1394, -1455, -1518, -1583, -1646, -1706, -1759, -1804,
+        -1838, -1858, -1862, -1850, -1818, -1766, -1693, -1599, -1484, -1349, -1196, -1025, -839, -641, -433, -218
+    },
+    // saw, notes 84 to 95, 4 harmonics
+    {
+        0, 109, 218, 326, 432, 536, 638, 737, 833, 925, 1013, 1097, 1176, 1250, 1319, 1382,
+        1440, 1492, 1538, 1579, 1613, 1642, 1664, 1681, 1693, 1698, 1699, 1694, 1685, 1671, 1653, 1631,
+        1605, 1577, 1545, 1511, 1474, 1436, 1397, 1356, 1315, 1273, 1232, 1191, 1151, 1111, 1073, 1036,
+        1001, 968, 937, 908, 882, 857, 836, 816, 799, 785, 772, 762, 755, 749, 745, 743,
+        742, 742, 744, 747, 750, 754, 758, 763, 767, 770, 774, 776, 777, 778, 777, 775,
+        771, 766, 759, 750, 739, 727, 713, 698, 680, 661, 641, 619, 596, 571, 546, 520,
+        493, 465, 437, 409, 381, 353, 325, 298, 271, 245, 221, 197, 174, 153, 133, 114,
+        97, 81, 67, 55, 44, 34, 26, 19, 14, 9, 6, 3, 2, 1, 0, 0,
+        0, 0, 0, -1, -2, -3, -6, -9, -14, -19, -26, -34, -44, -55, -67, -81,
+        -97, -114, -133, -153, -174, -197, -221, -245, -271, -298, -325, -353, -381, -409, -437, -465,
+        -493, -520, -546, -571, -596, -619, -641, -661, -680, -698, -713, -727, -739, -750, -759, -766,
+        -771, -775, -777, -778, -777, -776, -774, -770, -767, -763, -758, -754, -750, -747, -744, -742,
+        -742, -743, -745, -749, -755, -762, -772, -785, -799, -816, -836, -857, -882, -908, -937, -968,
+        -1001, -1036, -1073, -1111, -1151, -1191, -1232, -1273, -1315, -1356, -1397, -1436, -1474, -1511, -1545, -1577,
+        -1605, -1631, -1653, -1671, -1685, -1694, -1699, -1698, -1693, -1681, -1664, -1642, -1613, -1579, -1538, -1492,
+        -1440, -1382, -1319, -1250, -1176, -1097, -1013, -925, -833, -737, -638, -536, -432, -326, -218, -109
+    },
+    // saw, notes 96 to 107, 2 harmonics
+    {
+        0, 55, 109, 163, 218, 271, 325, 378, 430, 482, 533, 583, 632, 680, 728, 774,
+        819, 863, 906, 947, 987, 1026, 1063, 1098, 1132, 1165, 1195, 1224, 1252, 1277, 1301, 1323,
+        1343, 1362, 1378, 1393, 1406, 1417, 1426, 1434, 1439, 1443, 1445, 1445, 1444, 1441, 1436, 1429,
+        1421, 1412, 1401, 1388, 1374, 1358, 1342, 1324, 1304, 1284, 1262, 1240, 1216, 1191, 1166, 1140,
+        1113, 1085, 1057, 1028, 999, 969, 939, 909, 878, 848, 817, 786, 756, 725, 695, 665,
+        635, 605, 576, 547, 519, 491, 464, 437, 411, 386, 361, 338, 314, 292, 271, 250,
+        230, 212, 194, 176, 160, 145, 130, 117, 104, 92, 81, 71, 62, 53, 46, 39,
+        32, 27, 22, 18, 14, 11, 8, 6, 4, 3, 2, 1, 1, 0, 0, 0,
+        0, 0, 0, 0, -1, -1, -2, -3, -4, -6, -8, -11, -14, -18, -22, -27,
+        -32, -39, -46, -53, -62, -71, -81, -92, -104, -117, -130, -145, -160, -176, -194, -212,
+        -230, -250, -271, -292, -314, -338, -361, -386, -411, -437, -464, -491, -519, -547, -576, -605,
+        -635, -665, -695, -725, -756, -786, -817, -848, -878, -909, -939, -969, -999, -1028, -1057, -1085,
+        -1113, -1140, -1166, -1191, -1216, -1240, -1262, -1284, -1304, -1324, -1342, -1358, -1374, -1388, -1401, -1412,
+        -1421, -1429, -1436, -1441, -1444, -1445, -1445, -1443, -1439, -1434, -1426, -1417, -1406, -1393, -1378, -1362,
+        -1343, -1323, -1301, -1277, -1252, -1224, -1195, -1165, -1132, -1098, -1063, -1026, -987, -947, -906, -863,
+        -819, -774, -728, -680, -632, -583, -533, -482, -430, -378, -325, -271, -218, -163, -109, -55
+    },
+    // saw, notes 108 to 119, 1 harmonics
+    {
+        0, 27, 55, 82, 109, 136, 163, 190, 217, 244, 270, 297, 323, 349, 375, 400,
+        426, 451, 476, 500, 525, 548, 572, 595, 618, 641, 663, 685, 706, 727, 747, 767,
+        787, 806, 824, 843, 860, 877, 894, 910, 925, 940, 954, 968, 981, 994, 1006, 1017,
+        1028, 1038, 1048, 1057, 1065, 1072, 1079, 1086, 1091, 1096, 1101, 1104, 1107, 1110, 1111, 1112,
+        1113, 1112, 1111, 1110, 1107, 1104, 1101, 1096, 1091, 1086, 1079, 1072, 1065, 1057, 1048, 1038,
+        1028, 1017, 1006, 994, 981, 968, 954, 940, 925, 910, 894, 877, 860, 843, 824, 806,
+        787, 767, 747, 727, 706, 685, 663, 641, 618, 595, 572, 548, 525, 500, 476, 451,
+        426, 400, 375, 349, 323, 297, 270, 244, 217, 190, 163, 136, 109, 82, 55, 27,
+        0, -27, -55, -82, -109, -136, -163, -190, -217, -244, -270, -297, -323, -349, -375, -400,
+        -426, -451, -476, -500, -525, -548, -572, -595, -618, -641, -663, -685, -706, -727, -747, -767,
+        -787, -806, -824, -843, -860, -877, -894, -910, -925, -940, -954, -968, -981, -994, -1006, -1017,
+        -1028, -1038, -1048, -1057, -1065, -1072, -1079, -1086, -1091, -1096, -1101, -1104, -1107, -1110, -1111, -1112,
+        -1113, -1112, -1111, -1110, -1107, -1104, -1101, -1096, -1091, -1086, -1079, -1072, -1065, -1057, -1048, -1038,
+        -1028, -1017, -1006, -994, -981, -968, -954, -940, -925, -910, -894, -877, -860, -843, -824, -806,
+        -787, -767, -747, -727, -706, -685, -663, -641, -618, -595, -572, -548, -525, -500, -476, -451,
+        -426, -400, -375, -349, -323, -297, -270, -244, -217, -190, -163, -136, -109, -82, -55, -27
+    },
+    // square, notes 0 to 35, 127 harmonics
+    {
+        0, 1895, 1451, 1714, 1527, 1673, 1554, 1654, 1567, 1644, 1575, 1638, 1580, 1633, 1584, 1630,
+        1587, 1627, 1589, 1625, 1591, 1624, 1592, 1623, 1593, 1622, 1594, 1621, 1595, 1620, 1596, 1619,
+        1596, 1619, 1597, 1618, 1597, 1618, 1598, 1617, 1598, 1617, 1598, 1617, 1599, 1617, 1599, 1616,
+        1599, 1616, 1599, 1616, 1599, 1616, 1599, 1616, 1600, 1616, 1600, 1616, 1600, 1616, 1600, 1616,
+        1600, 1616, 1600, 1616, 1600, 1616, 1600, 1616, 1600, 1616, 1599, 1616, 1599, 1616, 1599, 1616,
+        1599, 1616, 1599, 1617, 1599, 1617, 1598, 1617, 1598, 1617, 1598, 1618, 1597, 1618, 1597, 1619,
+        1596, 1619, 1596, 1620, 1595, 1621, 1594, 1622, 1593, 1623, 1592, 1624, 1591, 1625, 1589, 1627,
+        1587, 1630, 1584, 1633, 1580, 1638, 1575, 1644, 1567, 1654, 1554, 1673, 1527, 1714, 1451, 1895,
+        0, -1895, -1451, -1714, -1527, -1673, -1554, -1654, -1567, -1644, -1575, -1638, -1580, -1633, -1584, -1630,
+        -1587, -1627, -1589, -1625, -1591, -1624, -1592, -1623, -1593, -1622, -1594, -1621, -1595, -1620, -1596, -1619,
+        -1596, -1619, -1597, -1618, -1597, -1618, -1598, -1617, -1598, -1617, -1598, -1617, -1599, -1617, -1599, -1616,
+        -1599, -1616, -1599, -1616, -1599, -1616, -1599, -1616, -1600, -1616, -1600, -1616, -1600, -1616, -1600, -1616,
+        -1600, -1616, -1600, -1616, -1600, -1616, -1600, -1616, -1600, -1616, -1599, -1616, -1599, -1616, -1599, -1616,
+        -1599, -1616, -1599, -1617, -1599, -1617, -1598, -1617, -1598, -1617, -1598, -1618, -1597, -1618, -1597, -1619,
+        -1596, -1619, -1596, -1620, -1595, -1621, -1594, -1622, -1593, -1623, -1592, -1624, -1591, -1625, -1589, -1627,
+        -1587, -1630, -1584, -1633, -1580, -1638, -1575, -1644, -1567, -1654, -1554, -1673, -1527, -1714, -1451, -1895
+    },
+    // square, notes 36 to 47, 64 harmonics
+    {
+        0, 1403, 1896, 1646, 1451, 1592, 1715, 1616, 1527, 1603, 1673, 1611, 1553, 1605, 1655, 1609,
+        1566, 1606, 1645, 1609, 1574, 1607, 1639, 1608, 1579, 1607, 1635, 1608, 1583, 1607, 1632, 1608,
+        1585, 1607, 1629, 1608, 1587, 1607, 1628, 1608, 1588, 1608, 1626, 1608, 1590, 1608, 1625, 1608,
+        1590, 1608, 1625, 1608, 1591, 1608, 1624, 1608, 1591, 1608, 1624, 1608, 1592, 1608, 1624, 1608,
+        1592, 1608, 1624, 1608, 1592, 1608, 1624, 1608, 1591, 1608, 1624, 1608, 1591, 1608, 1625, 1608,
+        1590, 1608, 1625, 1608, 1590, 1608, 1626, 1608, 1588, 1608, 1628, 1607, 1587, 1608, 1629, 1607,
+        1585, 1608, 1632, 1607, 1583, 1608, 1635, 1607, 1579, 1608, 1639, 1607, 1574, 1609, 1645, 1606,
+        1566, 1609, 1655, 1605, 1553, 1611, 1673, 1603, 1527, 1616, 1715, 1592, 1451, 1646, 1896, 1403,
+        0, -1403, -1896, -1646, -1451, -1592, -1715, -1616, -1527, -1603, -1673, -1611, -1553, -1605, -1655, -1609,
+        -1566, -1606, -1645, -1609, -1574, -1607, -1639, -1608, -1579, -1607, -1635, -1608, -1583, -1607, -1632, -1608,
+        -1585, -1607, -1629, -1608, -1587, -1607, -1628, -1608, -1588, -1608, -1626, -1608, -1590, -1608, -1625, -1608,
+        -1590, -1608, -1625, -1608, -1591, -1608, -1624, -1608, -1591, -1608, -1624, -1608, -1592, -1608, -1624, -1608,
+        -1592, -1608, -1624, -1608, -1592, -1608, -1624, -1608, -1591, -1608, -1624, -1608, -1591, -1608, -1625, -1608,
+        -1590, -1608, -1625, -1608, -1590, -1608, -1626, -1608, -1588, -1608, -1628, -1607, -1587, -1608, -1629, -1607,
+        -1585, -1608, -1632, -1607, -1583, -1608, -1635, -1607, -1579, -1608, -1639, -1607, -1574, -1609, -1645, -1606,
+        -1566, -1609, -1655, -1605, -1553, -1611, -1673, -1603, -1527, -1616, -1715, -1592, -1451, -1646, -1896, -1403
+    },
+    // square, notes 48 to 59, 32 harmonics
+    {
+        0, 777, 1403, 1781, 1896, 1814, 1646, 1503, 1450, 1495, 1593, 1682, 1716, 1685, 1616, 1551,
+        1525, 1549, 1603, 1655, 1675, 1656, 1611, 1568, 1550, 1567, 1605, 1643, 1658, 1643, 1609, 1576,
+        1563, 1576, 1606, 1637, 1649, 1637, 1609, 1581, 1569, 1580, 1607, 1633, 1644, 1633, 1608, 1583,
+        1573, 1583, 1607, 1631, 1641, 1631, 1608, 1585, 1575, 1585, 1608, 1630, 1640, 1630, 1608, 1585,
+        1576, 1585, 1608, 1630, 1640, 1630, 1608, 1585, 1575, 1585, 1608, 1631, 1641, 1631, 1607, 1583,
+        1573, 1583, 1608, 1633, 1644, 1633, 1607, 1580, 1569, 1581, 1609, 1637, 1649, 1637, 1606, 1576,
+        1563, 1576, 1609, 1643, 1658, 1643, 1605, 1567, 1550, 1568, 1611, 1656, 1675, 1655, 1603, 1549,
+        1525, 1551, 1616, 1685, 1716, 1682, 1593, 1495, 1450, 1503, 1646, 1814, 1896, 1781, 1403, 777,
+        0, -777, -1403, -1781, -1896, -1814, -1646, -1503, -1450, -1495, -1593, -1682, -1716, -1685, -1616, -1551,
+        -1525, -1549, -1603, -1655, -1675, -1656, -1611, -1568, -1550, -1567, -1605, -1643, -1658, -1643, -1609, -1576,
+        -1563, -1576, -1606, -1637, -1649, -1637, -1609, -1581, -1569, -1580, -1607, -1633, -1644, -1633, -1608, -1583,
+        -1573, -1583, -1607, -1631, -1641, -1631, -1608, -1585, -1575, -1585, -1608, -1630, -1640, -1630, -1608, -1585,
+        -1576, -1585, -1608, -1630, -1640, -1630, -1608, -1585, -1575, -1585, -1608, -1631, -1641, -1631, -1607, -1583,
+        -1573, -1583, -1608, -1633, -1644, -1633, -1607, -1580, -1569, -1581, -1609, -1637, -1649, -1637, -1606, -1576,
+        -1563, -1576, -1609, -1643, -1658, -1643, -1605, -1567, -1550, -1568, -1611, -1656, -1675, -1655, -1603, -1549,
+        -1525, -1551, -1616, -1685, -1716, -1682, -1593, -1495, -1450, -1503, -1646, -1814, -1896, -1781, -1403, -777
+    },
+    // square, notes 60 to 71, 16 harmonics
+    {
+        0, 399, 777, 1117, 1404, 1627, 1782, 1870, 1898, 1874, 1815, 1733, 1645, 1564, 1500, 1460,
+        1447, 1459, 1493, 1540, 1593, 1644, 1685, 1712, 1721, 1712, 1688, 1654, 1615, 1577, 1546, 1525,
+        1518, 1525, 1544, 1572, 1604, 1635, 1661, 1678, 1684, 1678, 1662, 1638, 1610, 1582, 1559, 1544,
+        1539, 1544, 1559, 1581, 1606, 1632, 1653, 1668, 1673, 1668, 1654, 1633, 1608, 1584, 1563, 1549,
+        1544, 1549, 1563, 1584, 1608, 1633, 1654, 1668, 1673, 1668, 1653, 1632, 1606, 1581, 1559, 1544,
+        1539, 1544, 1559, 1582, 1610, 1638, 1662, 1678, 1684, 1678, 1661, 1635, 1604, 1572, 1544, 1525,
+        1518, 1525, 1546, 1577, 1615, 1654, 1688, 1712, 1721, 1712, 1685, 1644, 1593, 1540, 1493, 1459,
+        1447, 1460, 1500, 1564, 1645, 1733, 1815, 1874, 1898, 1870, 1782, 1627, 1404, 1117, 777, 399,
+        0, -399, -777, -1117, -1404, -1627, -1782, -1870, -1898, -1874, -1815, -1733, -1645, -1564, -1500, -1460,
+        -1447, -1459, -1493, -1540, -1593, -1644, -1685, -1712, -1721, -1712, -1688, -1654, -1615, -1577, -1546, -1525,
+        -1518, -1525, -1544, -1572, -1604, -1635, -1661, -1678, -1684, -1678, -1662, -1638, -1610, -1582, -1559, -1544,
+        -1539, -1544, -1559, -1581, -1606, -1632, -1653, -1668, -1673, -1668, -1654, -1633, -1608, -1584, -1563, -1549,
+        -1544, -1549, -1563, -1584, -1608, -1633, -1654, -1668, -1673, -1668, -1653, -1632, -1606, -1581, -1559, -1544,
+        -1539, -1544, -1559, -1582, -1610, -1638, -1662, -1678, -1684, -1678, -1661, -1635, -1604, -1572, -1544, -1525,
+        -1518, -1525, -1546, -1577, -1615, -1654, -1688, -1712, -1721, -1712, -1685, -1644, -1593, -1540, -1493, -1459,
+        -1447, -1460, -1500, -1564, -1645, -1733, -1815, -1874, -1898, -1870, -1782, -1627, -1404, -1117, -777, -399
+    },
+    // square, notes 72 to 83, 8 harmonics
+    {
+        0, 201, 399, 592, 777, 953, 1118, 1269, 1406, 1526, 1630, 1717, 1787, 1840, 1876, 1897,
+        1904, 1898, 1880, 1853, 1819, 1779, 1735, 1689, 1643, 1599, 1558, 1522, 1491, 1466, 1448, 1437,
+        1434, 1437, 1447, 1463, 1484, 1508, 1536, 1566, 1596, 1626, 1654, 1680, 1702, 1720, 1733, 1741,
+        1744, 1741, 1733, 1721, 1704, 1684, 1661, 1636, 1611, 1585, 1561, 1539, 1519, 1503, 1491, 1484,
+        1482, 1484, 1491, 1503, 1519, 1539, 1561, 1585, 1611, 1636, 1661, 1684, 1704, 1721, 1733, 1741,
+        1744, 1741, 1733, 1720, 1702, 1680, 1654, 1626, 1596, 1566, 1536, 1508, 1484, 1463, 1447, 1437,
+        1434, 1437, 1448, 1466, 1491, 1522, 1558, 1599, 1643, 1689, 1735, 1779, 1819, 1853, 1880, 1898,
+        1904, 1897, 1876, 1840, 1787, 1717, 1630, 1526, 1406, 1269, 1118, 953, 777, 592, 399, 201,
+        0, -201, -399, -592, -777, -953, -1118, -1269, -1406, -1526, -1630, -1717, -1787, -1840, -1876, -1897,
+        -1904, -1898, -1880, -1853, -1819, -1779, -1735, -1689, -1643, -1599, -1558, -1522, -1491, -1466, -1448, -1437,
+        -1434, -1437, -1447, -1463, -1484, -1508, -1536, -1566, -1596, -1626, -1654, -1680, -1702, -1720, -1733, -1741,
+        -1744, -1741, -1733, -1721, -1704, -1684, -1661, -1636, -1611, -1585, -1561, -1539, -1519, -1503, -1491, -1484,
+        -1482, -1484, -1491, -1503, -1519, -1539, -1561, -1585, -1611, -1636, -1661, -1684, -1704, -1721, -1733, -1741,
+        -1744, -1741, -1733, -1720, -1702, -1680, -1654, -1626, -1596, -1566, -1536, -1508, -1484, -1463, -1447, -1437,
+        -1434, -1437, -1448, -1466, -1491, -1522, -1558, -1599, -1643, -1689, -1735, -1779, -1819, -1853, -1880, -1898,
+        -1904, -1897, -1876, -1840, -1787, -1717, -1630, -1526, -1406, -1269, -1118, -953, -777, -592, -399, -201
+    },
+    // square, notes 84 to 95, 4 harmonics
+    {
+        0, 100, 201, 300, 399, 496, 592, 686, 778, 868, 956, 1040, 1122, 1200, 1275, 1346,
+        1414, 1477, 1537, 1593, 1644, 1691, 1734, 1772, 1806, 1836, 1862, 1883, 1900, 1914, 1923, 1928,
+        1930, 1928, 1923, 1915, 1904, 1890, 1874, 1856, 1835, 1813, 1789, 1764, 1738, 1712, 1685, 1657,
+        1630, 1603, 1577, 1551, 1526, 1502, 1480, 1459, 1440, 1423, 1408, 1395, 1384, 1376, 1370, 1366,
+        1365, 1366, 1370, 1376, 1384, 1395, 1408, 1423, 1440, 1459, 1480, 1502, 1526, 1551, 1577, 1603,
+        1630, 1657, 1685, 1712, 1738, 1764, 1789, 1813, 1835, 1856, 1874, 1890, 1904, 1915, 1923, 1928,
+        1930, 1928, 1923, 1914, 1900, 1883, 1862, 1836, 1806, 1772, 1734, 1691, 1644, 1593, 1537, 1477,
+        1414, 1346, 1275, 1200, 1122, 1040, 956, 868, 778, 686, 592, 496, 399, 300, 201, 100,
+        0, -100, -201, -300, -399, -496, -592, -686, -778, -868, -956, -1040, -1122, -1200, -1275, -1346,
+        -1414, -1477, -1537, -1593, -1644, -1691, -1734, -1772, -1806, -1836, -1862, -1883, -1900, -1914, -1923, -1928,
+        -1930, -1928, -1923, -1915, -1904, -1890, -1874, -1856, -1835, -1813, -1789, -1764, -1738, -1712, -1685, -1657,
+        -1630, -1603, -1577, -1551, -1526, -1502, -1480, -1459, -1440, -1423, -1408, -1395, -1384, -1376, -1370, -1366,
+        -1365, -1366, -1370, -1376, -1384, -1395, -1408, -1423, -1440, -1459, -1480, -1502, -1526, -1551, -1577, -1603,
+        -1630, -1657, -1685, -1712, -1738, -1764, -1789, -1813, -1835, -1856, -1874, -1890, -1904, -1915, -1923, -1928,
+        -1930, -1928, -1923, -1914, -1900, -1883, -1862, -1836, -1806, -1772, -1734, -1691, -1644, -1593, -1537, -1477,
+        -1414, -1346, -1275, -1200, -1122, -1040, -956, -868, -778, -686, -592, -496, -399, -300, -201, -100
+    },
+    // square, notes 96 to 107, 2 harmonics
+    {
+        0, 50, 100, 151, 201, 251, 300, 350, 399, 449, 497, 546, 594, 642, 690, 737,
+        783, 830, 875, 920, 965, 1009, 1052, 1095, 1137, 1179, 1219, 1259, 1299, 1337, 1375, 1411,
+        1447, 1483, 1517, 1550, 1582, 1614, 1644, 1674, 1702, 1729, 1756, 1781, 1805, 1828, 1850, 1871,
+        1891, 1910, 1927, 1944, 1959, 1973, 1986, 1997, 2008, 2017, 2025, 2032, 2037, 2041, 2045, 2046,
+        2047, 2046, 2045, 2041, 2037, 2032, 2025, 2017, 2008, 1997, 1986, 1973, 1959, 1944, 1927, 1910,
+        1891, 1871, 1850, 1828, 1805, 1781, 1756, 1729, 1702, 1674, 1644, 1614, 1582, 1550, 1517, 1483,
+        1447, 1411, 1375, 1337, 1299, 1259, 1219, 1179, 1137, 1095, 1052, 1009, 965, 920, 875, 830,
+        783, 737, 690, 642, 594, 546, 497, 449, 399, 350, 300, 251, 201, 151, 100, 50,
+        0, -50, -100, -151, -201, -251, -300, -350, -399, -449, -497, -546, -594, -642, -690, -737,
+        -783, -830, -875, -920, -965, -1009, -1052, -1095, -1137, -1179, -1219, -1259, -1299, -1337, -1375, -1411,
+        -1447, -1483, -1517, -1550, -1582, -1614, -1644, -1674, -1702, -1729, -1756, -1781, -1805, -1828, -1850, -1871,
+        -1891, -1910, -1927, -1944, -1959, -1973, -1986, -1997, -2008, -2017, -2025, -2032, -2037, -2041, -2045, -2046,
+        -2047, -2046, -2045, -2041, -2037, -2032, -2025, -2017, -2008, -1997, -1986, -1973, -1959, -1944, -1927, -1910,
+        -1891, -1871, -1850, -1828, -1805, -1781, -1756, -1729, -1702, -1674, -1644, -1614, -1582, -1550, -1517, -1483,
+        -1447, -1411, -1375, -1337, -1299, -1259, -1219, -1179, -1137, -1095, -1052, -1009, -965, -920, -875, -830,
+        -783, -737, -690, -642, -594, -546, -497, -449, -399, -350, -300, -251, -201, -151, -100, -50
+    },
+    // square, notes 108 to 119, 1 harmonics
+    {
+        0, 50, 100, 151, 201, 251, 300, 350, 399, 449, 497, 546, 594, 642, 690, 737,
+        783, 830, 875, 920, 965, 1009, 1052, 1095, 1137, 1179, 1219, 1259, 1299, 1337, 1375, 1411,
+        1447, 1483, 1517, 1550, 1582, 1614, 1644, 1674, 1702, 1729, 1756, 1781, 1805, 1828, 1850, 1871,
+        1891, 1910, 1927, 1944, 1959, 1973, 1986, 1997, 2008, 2017, 2025, 2032, 2037, 2041, 2045, 2046,
+        2047, 2046, 2045, 2041, 2037, 2032, 2025, 2017, 2008, 1997, 1986, 1973, 1959, 1944, 1927, 1910,
+        1891, 1871, 1850, 1828, 1805, 1781, 1756, 1729, 1702, 1674, 1644, 1614, 1582, 1550, 1517, 1483,
+        1447, 1411, 1375, 1337, 1299, 1259, 1219, 1179, 1137, 1095, 1052, 1009, 965, 920, 875, 830,
+        783, 737, 690, 642, 594, 546, 497, 449, 399, 350, 300, 251, 201, 151, 100, 50,
+        0, -50, -100, -151, -201, -251, -300, -350, -399, -449, -497, -546, -594, -642, -690, -737,
+        -783, -830, -875, -920, -965, -1009, -1052, -1095, -1137, -1179, -1219, -1259, -1299, -1337, -1375, -1411,
+        -1447, -1483, -1517, -1550, -1582, -1614, -1644, -1674, -1702, -1729, -1756, -1781, -1805, -1828, -1850, -1871,
+        -1891, -1910, -1927, -1944, -1959, -1973, -1986, -1997, -2008, -2017, -2025, -2032, -2037, -2041, -2045, -2046,
+        -2047, -2046, -2045, -2041, -2037, -2032, -2025, -2017, -2008, -1997, -1986, -1973, -1959, -1944, -1927, -1910,
+        -1891, -1871, -1850, -1828, -1805, -1781, -1756, -1729, -1702, -1674, -1644, -1614, -1582, -1550, -1517, -1483,
+        -1447, -1411, -1375, -1337, -1299, -1259, -1219, -1179, -1137, -1095, -1052, -1009, -965, -920, -875, -830,
+        -783, -737, -690, -642, -594, -546, -497, -449, -399, -350, -300, -251, -201, -151, -100, -50
+    }
+};
+
+/***************************END OF GLOBAL VARIABLES****************************/
@@ -4,35 +4,123 @@
   Description:
     Provides some useful definitions regarding the USART system of the
     ATxmega128A1U.
+
+    Output is buffered in one of two ways. By default bytes go through a
+    ring buffer drained one at a time by the data register empty interrupt.
+    With USART_TX_DMA defined they are collected in two alternating buffers
+    instead, and DMA channel 3, triggered by the data register becoming
+    empty, sends one buffer while the other fills: one interrupt per block
+    rather than per byte.
+
+    Input is queued by the receive complete interrupt (medium level) in a
+    ring buffer, so characters arriving while the main loop is busy wait
+    there instead of being overwritten in DATA.
   
 ------------------------------------------------------------------------------*/
 
 /********************************DEPENDENCIES**********************************/
 
 #include <avr/io.h>
+#include <avr/interrupt.h>
 #include "usart.h"
 
 /*****************************END OF DEPENDENCIES******************************/
 
 /***********************************MACROS*************************************/
 
-/* At 2 MHz SYSclk, 5 BSEL, -6 BSCALE corresponds to 115200 bps */
-#define BSEL     (5)
-#define BSCALE   (-6)
+#ifndef USART_TX_DMA
+
+#if (USART_TX_BUF_LEN & (USART_TX_BUF_LEN - 1)) || USART_TX_BUF_LEN > 256
+#error "USART_TX_BUF_LEN must be a power of two, at most 256"
+#endif
+
+#define USART_TX_MASK   (USART_TX_BUF_LEN - 1)
+
+#else
+
+/* The DMA buffers are filled by count, not masked; the length only has
+ * to fit the block transfer count. */
+#if USART_TX_BUF_LEN < 1 || USART_TX_BUF_LEN > 65535
+#error "USART_TX_BUF_LEN must be 1 to 65535 with USART_TX_DMA"
+#endif
+
+#endif
+
+#if (USART_RX_BUF_LEN & (USART_RX_BUF_LEN - 1)) || USART_RX_BUF_LEN > 256
+#error "USART_RX_BUF_LEN must be a power of two, at most 256"
+#endif
+
+#define USART_RX_MASK   (USART_RX_BUF_LEN - 1)
+
+/* BSEL as written to the baud rate registers. */
+#define USART_BSEL      ((uint16_t)(BSEL))
+
+/* usart.h picks BSCALE and checks the baud rate error with the
+ * preprocessor, which works in at least 64 bits; check that the compiler
+ * arrives at the same BSEL, in 12 bits and within the same tolerance. */
+_Static_assert((BSEL) == USART_BSEL && USART_BSEL <= 4095,
+               "BSEL differs between the preprocessor and the compiler");
+#if BSCALE <= 0
+_Static_assert(USART_BAUD_REAL * 1000 <= USART_BAUD * (1000 + USART_BAUD_TOL) &&
+               USART_BAUD_REAL * 1000 >= USART_BAUD * (1000 - USART_BAUD_TOL),
+               "USARTD0 baud rate error differs between the preprocessor and the compiler");
+#endif
 
 /********************************END OF MACROS*********************************/
 
-/*****************************FUNCTION DEFINITIONS*****************************/
+/******************************GLOBAL VARIABLES********************************/
 
-char usartd0_in_char(void)
-{
-  /* intentionally left blank */
-}
+#ifndef USART_TX_DMA
+
+/* Transmit ring buffer; bytes are added at the head and sent from the tail. */
+static volatile uint8_t usart_tx_buf[USART_TX_BUF_LEN];
+static volatile uint8_t usart_tx_head = 0;
+static volatile uint8_t usart_tx_tail = 0;
+
+#else
+
+/* Transmit buffers; `usart_dma_fill` is being filled while DMA CH3 sends
+ * the other one (if `usart_dma_busy`). */
+static uint8_t usart_dma_buf[2][USART_TX_BUF_LEN];
+static volatile uint8_t usart_dma_fill = 0;
+static volatile uint16_t usart_dma_len = 0;
+static volatile uint8_t usart_dma_busy = 0;
+
+#endif
+
+static uint16_t usart_tx_high_water = 0;
+static uint16_t usart_tx_overflows = 0;
+
+/* Receive ring buffer; the interrupt adds at the head, readers take from
+ * the tail. */
+static volatile uint8_t usart_rx_buf[USART_RX_BUF_LEN];
+static volatile uint8_t usart_rx_head = 0;
+static volatile uint8_t usart_rx_tail = 0;
 
-void usartd0_in_string(char * buf)
+static volatile uint16_t usart_rx_overflows = 0;
+static volatile uint16_t usart_rx_overruns = 0;
+static volatile uint16_t usart_rx_frame_errors = 0;
+
+/* Line assembly: position in the caller's buffer, whether the last
+ * character was a CR (so that the LF of a CR LF is skipped), and whether
+ * characters of the line were discarded for want of room. */
+static uint8_t usart_line_pos = 0;
+static uint8_t usart_line_cr = 0;
+static uint8_t usart_line_over = 0;
+
+/***************************END OF GLOBAL VARIABLES****************************/
+
+/*****************************FUNCTION DEFINITIONS*****************************/
+
+#ifdef USART_TX_DMA
+/* Loads the 24-bit source or destination address of a DMA channel. */
+static void usart_dma_addr(volatile uint8_t * reg, const volatile void * addr)
 {
-  /* intentionally left blank */
+    reg[0] = (uint8_t)((uintptr_t)addr);
+    reg[1] = (uint8_t)((uintptr_t)addr >> 8);
+    reg[2] = (uint8_t)(((uint32_t)((uintptr_t)addr)) >> 16);
 }
+#endif
 
 void usartd0_init(void)
 {
@@ -42,8 +130,8 @@ void usartd0_init(void)
     PORTD.DIRCLR = PIN2_bm;
 
   /* Configure baud rate. */
-    USARTD0.BAUDCTRLA = (uint8_t)BSEL;
-    USARTD0.BAUDCTRLB = (uint8_t)((BSCALE << 4)|(BSEL >> 8));
+    USARTD0.BAUDCTRLA = (uint8_t)USART_BSEL;
+    USARTD0.BAUDCTRLB = (uint8_t)((BSCALE << 4)|(USART_BSEL >> 8));
 
   /* Configure remainder of serial protocol. */
   /* (In this example, a protocol with 8 data bits, no parity, and
@@ -54,21 +142,430 @@ void usartd0_init(void)
                     ~USART_SBMODE_bm;
 
   /* Enable receiver and/or transmitter systems. */
-    USARTD0.CTRLB = USART_RXEN_bm | USART_TXEN_bm;
+    USARTD0.CTRLB = USART_RXEN_bm | USART_TXEN_bm | (USART_CLK2X ? USART_CLK2X_bm : 0);
+
+  /* Queue received characters from the (medium level) receive complete
+   * interrupt. */
+    USARTD0.CTRLA = USART_RXCINTLVL_MED_gc;
+
+#ifdef USART_TX_DMA
+  /* DMA CH3 sends one byte into DATA each time it is empty, from a
+   * buffer chosen per block; the source address and count are loaded by
+   * `usart_dma_start`. */
+    DMA.CH3.CTRLA = DMA_CH_RESET_bm;
+    DMA.CH3.ADDRCTRL = DMA_CH_SRCRELOAD_NONE_gc | DMA_CH_SRCDIR_INC_gc |
+                       DMA_CH_DESTRELOAD_NONE_gc | DMA_CH_DESTDIR_FIXED_gc;
+    DMA.CH3.TRIGSRC = DMA_CH_TRIGSRC_USARTD0_DRE_gc;
+    DMA.CH3.REPCNT = 0;
+    usart_dma_addr(&DMA.CH3.DESTADDR0, &USARTD0.DATA);
+    DMA.CH3.CTRLB = DMA_CH_TRNINTLVL_LO_gc;
+
+    DMA.CTRL |= DMA_ENABLE_bm;
+#endif
+}
+
+/* True when an interrupt of level `lvlen` (a PMIC level enable bit) cannot
+ * currently be taken, in which case anyone waiting on it has to poll. */
+static uint8_t usart_must_poll(uint8_t lvlen)
+{
+    return !(CPU_SREG & CPU_I_bm) || !(PMIC.CTRL & lvlen) ||
+           (PMIC.STATUS & (PMIC_LOLVLEX_bm | PMIC_MEDLVLEX_bm | PMIC_HILVLEX_bm));
+}
+
+/* The transmit interrupt (data register empty, or DMA CH3 transaction
+ * complete) is low level. */
+static uint8_t usart_tx_must_poll(void)
+{
+    return usart_must_poll(PMIC_LOLVLEN_bm);
+}
+
+/* Takes the received character out of DATA, counting errors, and queues it.
+ * The caller must have seen RXCIF set (or be the RXC interrupt itself). */
+static void usart_rx_service(void)
+{
+  /* Error flags belong to the character in DATA; read them first. */
+    uint8_t status = USARTD0.STATUS;
+    uint8_t c = USARTD0.DATA;
+    
+    if(status & USART_BUFOVF_bm)
+    {
+        if(usart_rx_overruns != 0xFFFF) usart_rx_overruns++;
+    }
+    
+    if(status & USART_FERR_bm)
+    {
+        if(usart_rx_frame_errors != 0xFFFF) usart_rx_frame_errors++;
+        return;
+    }
+    
+    uint8_t head = (usart_rx_head + 1) & USART_RX_MASK;
+    
+    if(head == usart_rx_tail)
+    {
+        if(usart_rx_overflows != 0xFFFF) usart_rx_overflows++;
+        return;
+    }
+    
+    usart_rx_buf[usart_rx_head] = c;
+    usart_rx_head = head;
+}
+
+uint8_t usartd0_try_read(char * c)
+{
+  /* Nobody else will drain the receiver; do it here. (From a low level
+   * handler the interrupt may still be taken, hence the cli.) */
+    if(usart_must_poll(PMIC_MEDLVLEN_bm))
+    {
+        uint8_t sreg = CPU_SREG;
+        cli();
+        
+        if(USARTD0.STATUS & USART_RXCIF_bm)
+        {
+            usart_rx_service();
+        }
+        
+        CPU_SREG = sreg;
+    }
+    
+    uint8_t tail = usart_rx_tail;
+    
+    if(tail == usart_rx_head)
+    {
+        return 0;
+    }
+    
+    *c = (char)usart_rx_buf[tail];
+    usart_rx_tail = (tail + 1) & USART_RX_MASK;
+    
+    return 1;
+}
+
+char usartd0_in_char(void)
+{
+    char c;
+    
+    while(!usartd0_try_read(&c));
+    
+    return c;
+}
+
+/* Feeds `c` to the line being assembled in `buf`. Returns 1 once the line
+ * has ended, with `buf` null-terminated and its length in `usart_line_pos`
+ * (the caller resets it). */
+static uint8_t usart_line_put(char * buf, uint8_t size, char c)
+{
+    if(c == '\n' && usart_line_cr)
+    {
+        usart_line_cr = 0;
+        return 0;
+    }
+    
+    usart_line_cr = (c == '\r');
+    
+    if(c == '\r' || c == '\n')
+    {
+        buf[usart_line_pos] = '\0';
+        return 1;
+    }
+    
+    if(usart_line_pos == 0)
+    {
+        usart_line_over = 0;
+    }
+    
+    if(usart_line_pos < size - 1)
+    {
+        buf[usart_line_pos++] = c;
+    }
+    else
+    {
+        usart_line_over = 1;
+    }
+    
+    return 0;
+}
+
+uint8_t usartd0_in_string(char * buf, uint8_t size)
+{
+    uint8_t len;
+    
+    usart_line_pos = 0;
+    usart_line_over = 0;
+    
+    while(!usart_line_put(buf, size, usartd0_in_char()));
+    
+    len = usart_line_pos;
+    usart_line_pos = 0;
+    
+    return len;
+}
+
+uint8_t usartd0_try_line(char * buf, uint8_t size)
+{
+    char c;
+    
+    while(usartd0_try_read(&c))
+    {
+        if(usart_line_put(buf, size, c) && usart_line_pos)
+        {
+            uint8_t len = usart_line_pos;
+            usart_line_pos = 0;
+            return len;
+        }
+    }
+    
+    return 0;
+}
+
+uint8_t usartd0_line_truncated(void)
+{
+    return usart_line_over;
+}
+
+#ifndef USART_TX_DMA
+
+/* Moves the next queued byte to the transmitter, or turns the data register
+ * empty interrupt off once the buffer is empty. The caller must have seen
+ * DREIF set (or be the DRE interrupt itself). */
+static void usart_tx_service(void)
+{
+    if(usart_tx_tail == usart_tx_head)
+    {
+        USARTD0.CTRLA = (USARTD0.CTRLA & ~USART_DREINTLVL_gm) | USART_DREINTLVL_OFF_gc;
+        return;
+    }
+    
+    USARTD0.DATA = usart_tx_buf[usart_tx_tail];
+    usart_tx_tail = (usart_tx_tail + 1) & USART_TX_MASK;
+}
+
+/* Adds `c` to the buffer, which must have room, and makes sure the data
+ * register empty interrupt is on. Interrupts must be disabled. */
+static void usart_tx_put(uint8_t c)
+{
+    uint8_t fill;
+    
+    usart_tx_buf[usart_tx_head] = c;
+    usart_tx_head = (usart_tx_head + 1) & USART_TX_MASK;
+    
+    fill = (usart_tx_head - usart_tx_tail) & USART_TX_MASK;
+    
+    if(fill > usart_tx_high_water)
+    {
+        usart_tx_high_water = fill;
+    }
+    
+    USARTD0.CTRLA = (USARTD0.CTRLA & ~USART_DREINTLVL_gm) | USART_DREINTLVL_LO_gc;
+}
+
+static uint8_t usart_tx_full(void)
+{
+    return ((usart_tx_head + 1) & USART_TX_MASK) == usart_tx_tail;
+}
+
+#endif
+
+static void usart_tx_overflow(void)
+{
+    if(usart_tx_overflows != 0xFFFF)
+    {
+        usart_tx_overflows++;
+    }
+}
+
+#ifndef USART_TX_DMA
+
+void usartd0_out_char(char c)
+{
+    if(usart_tx_full())
+    {
+        usart_tx_overflow();
+        
+        while(usart_tx_full())
+        {
+            if(usart_tx_must_poll() && (USARTD0.STATUS & USART_DREIF_bm))
+            {
+                usart_tx_service();
+            }
+        }
+    }
+    
+    uint8_t sreg = CPU_SREG;
+    cli();
+    
+    usart_tx_put(c);
+    
+    CPU_SREG = sreg;
+}
+
+#else
+
+/* Hands the buffer being filled to DMA CH3, if it holds anything, and
+ * starts filling the other one. Interrupts must be disabled, or this is
+ * the channel's transaction complete interrupt. */
+static void usart_dma_start(void)
+{
+    if(!usart_dma_len)
+    {
+        usart_dma_busy = 0;
+        return;
+    }
+    
+    DMA.CH3.TRFCNT = usart_dma_len;
+    usart_dma_addr(&DMA.CH3.SRCADDR0, usart_dma_buf[usart_dma_fill]);
+    DMA.CH3.CTRLA = DMA_CH_ENABLE_bm | DMA_CH_SINGLE_bm | DMA_CH_BURSTLEN_1BYTE_gc;
+    
+    usart_dma_fill ^= 1;
+    usart_dma_len = 0;
+    usart_dma_busy = 1;
+}
+
+/* Handles a finished block: clears the flag and starts the next one. */
+static void usart_dma_service(void)
+{
+    DMA.CH3.CTRLB = DMA_CH_TRNIF_bm | DMA_CH_TRNINTLVL_LO_gc;
+    usart_dma_start();
+}
 
-  /* Enable interrupt (optional). */
-    /* USARTD0.CTRLA = USART_RXCINTLVL_MED_gc; */
+/* Copies up to `len` bytes into the buffer being filled and starts DMA if
+ * it is idle. Returns the number of bytes taken. Interrupts must be
+ * disabled. */
+static uint16_t usart_dma_put(const uint8_t * bytes, uint16_t len)
+{
+    uint16_t room = USART_TX_BUF_LEN - usart_dma_len;
+    uint8_t * dest = &usart_dma_buf[usart_dma_fill][usart_dma_len];
+    
+    if(len > room)
+    {
+        len = room;
+    }
+    
+    for(uint16_t i = 0; i < len; i++)
+    {
+        dest[i] = bytes[i];
+    }
+    
+    usart_dma_len += len;
+    
+    if(usart_dma_len > usart_tx_high_water)
+    {
+        usart_tx_high_water = usart_dma_len;
+    }
+    
+    if(!usart_dma_busy)
+    {
+        usart_dma_start();
+    }
+    
+    return len;
 }
 
 void usartd0_out_char(char c)
 {
-    while(!(USARTD0.STATUS & USART_DREIF_bm));
-    USARTD0.DATA = c;
+    uint8_t stalled = 0;
+    
+    for(;;)
+    {
+        uint8_t sreg = CPU_SREG;
+        cli();
+        
+        uint16_t n = usart_dma_put((const uint8_t *)&c, 1);
+        
+        CPU_SREG = sreg;
+        
+        if(n)
+        {
+            return;
+        }
+        
+        /* both buffers are full: wait for the one on the wire */
+        if(!stalled)
+        {
+            stalled = 1;
+            usart_tx_overflow();
+        }
+        
+        if(usart_tx_must_poll() && (DMA.CH3.CTRLB & DMA_CH_TRNIF_bm))
+        {
+            usart_dma_service();
+        }
+    }
 }
 
+#endif
+
 void usartd0_out_string(const char * str)
 {
     while(*str) usartd0_out_char(*(str++));
 }
 
+uint16_t usartd0_write(const void * buf, uint16_t len)
+{
+    const uint8_t * bytes = (const uint8_t *)buf;
+    uint16_t n = 0;
+    
+    uint8_t sreg = CPU_SREG;
+    cli();
+    
+#ifndef USART_TX_DMA
+    while(n < len && !usart_tx_full())
+    {
+        usart_tx_put(bytes[n++]);
+    }
+#else
+    n = usart_dma_put(bytes, len);
+#endif
+    
+    CPU_SREG = sreg;
+    
+    if(n < len)
+    {
+        usart_tx_overflow();
+    }
+    
+    return n;
+}
+
+uint16_t usartd0_tx_high_water(void)
+{
+    return usart_tx_high_water;
+}
+
+uint16_t usartd0_tx_overflows(void)
+{
+    return usart_tx_overflows;
+}
+
+uint16_t usartd0_rx_overflows(void)
+{
+    return usart_rx_overflows;
+}
+
+uint16_t usartd0_rx_overruns(void)
+{
+    return usart_rx_overruns;
+}
+
+uint16_t usartd0_rx_frame_errors(void)
+{
+    return usart_rx_frame_errors;
+}
+
+ISR(USARTD0_RXC_vect)
+{
+    usart_rx_service();
+}
+
+#ifndef USART_TX_DMA
+ISR(USARTD0_DRE_vect)
+{
+    usart_tx_service();
+}
+#else
+ISR(DMA_CH3_vect)
+{
+    usart_dma_service();
+}
+#endif
+
 /***************************END OF FUNCTION DEFINITIONS************************/
\ No newline at end of file
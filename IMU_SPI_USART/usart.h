@@ -13,13 +13,99 @@
 /********************************DEPENDENCIES**********************************/
 
 #include <avr/io.h>
+#include "clock.h"
 
 /*****************************END OF DEPENDENCIES******************************/
 
 /***********************************MACROS*************************************/
-/* At 2 MHz SYSclk, 5 BSEL, -6 BSCALE corresponds to 115200 bps */
-#define BSEL     (5)
+/* USARTD0 baud rate, for the whole project. BSEL, BSCALE and CLK2X are
+ * derived from it and F_CPU below. At 32 MHz anything up to 2 Mbps (4 Mbps
+ * with CLK2X) whose error is within USART_BAUD_TOL builds; 1 and 2 Mbps
+ * are exact. */
+#ifndef USART_BAUD
+#define USART_BAUD          115200UL
+#endif
+
+/* Largest baud rate error accepted at build time, in tenths of a percent.
+ * Both ends of the link contribute, so keep well inside the receiver's
+ * tolerance (about +/-2% with 8 data bits). */
+#ifndef USART_BAUD_TOL
+#define USART_BAUD_TOL      10
+#endif
+
+/* Double speed mode, only when 16 samples per bit would not fit. */
+#ifndef USART_CLK2X
+#if USART_BAUD > F_CPU / 16
+#define USART_CLK2X         1
+#else
+#define USART_CLK2X         0
+#endif
+#endif
+
+#define USART_SAMPLES       (USART_CLK2X ? 8 : 16)
+
+/* BSEL for a fractional BSCALE of -n:
+ *   BSEL = 2^n * (F_CPU / (samples * baud) - 1), rounded.
+ * The most negative BSCALE whose BSEL fits in 12 bits is used, for the
+ * finest resolution. BSEL and BSCALE may still be given on the command
+ * line instead. F_CPU * 2^(n+1) passes 2^32, so this is worked out in
+ * unsigned long long: the preprocessor does so anyway, the compiler must
+ * too (usart.c checks that both agree). */
+#define USART_BSEL_FRAC(n)  ((((F_CPU * 1ULL * (2UL << (n))) / (USART_SAMPLES * USART_BAUD)) + 1) / 2 - (1UL << (n)))
+
+#ifndef BSEL
+#if F_CPU < USART_SAMPLES * USART_BAUD
+#error "USART_BAUD is too high for F_CPU"
+#elif USART_BSEL_FRAC(7) <= 4095
+#define BSCALE   (-7)
+#define BSEL     USART_BSEL_FRAC(7)
+#elif USART_BSEL_FRAC(6) <= 4095
 #define BSCALE   (-6)
+#define BSEL     USART_BSEL_FRAC(6)
+#elif USART_BSEL_FRAC(5) <= 4095
+#define BSCALE   (-5)
+#define BSEL     USART_BSEL_FRAC(5)
+#elif USART_BSEL_FRAC(4) <= 4095
+#define BSCALE   (-4)
+#define BSEL     USART_BSEL_FRAC(4)
+#elif USART_BSEL_FRAC(3) <= 4095
+#define BSCALE   (-3)
+#define BSEL     USART_BSEL_FRAC(3)
+#elif USART_BSEL_FRAC(2) <= 4095
+#define BSCALE   (-2)
+#define BSEL     USART_BSEL_FRAC(2)
+#elif USART_BSEL_FRAC(1) <= 4095
+#define BSCALE   (-1)
+#define BSEL     USART_BSEL_FRAC(1)
+#elif USART_BSEL_FRAC(0) <= 4095
+#define BSCALE   (0)
+#define BSEL     USART_BSEL_FRAC(0)
+#else
+#error "USART_BAUD is too low for F_CPU"
+#endif
+#endif
+
+/* Baud rate actually produced, for the error check (BSCALE <= 0 only). */
+#if defined(BSEL) && BSCALE <= 0
+#define USART_BAUD_REAL     (((F_CPU * 1ULL) << -(BSCALE)) / (USART_SAMPLES * ((BSEL) + (1UL << -(BSCALE)))))
+
+#if USART_BAUD_REAL * 1000 > USART_BAUD * (1000 + USART_BAUD_TOL) || \
+    USART_BAUD_REAL * 1000 < USART_BAUD * (1000 - USART_BAUD_TOL)
+#error "USARTD0 baud rate error exceeds USART_BAUD_TOL at this F_CPU"
+#endif
+#endif
+
+/* Size of the transmit ring buffer. Must be a power of two, at most 256.
+ * With USART_TX_DMA defined, the size of each of the two DMA buffers,
+ * which may be any length up to 65535. */
+#ifndef USART_TX_BUF_LEN
+#define USART_TX_BUF_LEN    64
+#endif
+
+/* Size of the receive ring buffer. Must be a power of two, at most 256. */
+#ifndef USART_RX_BUF_LEN
+#define USART_RX_BUF_LEN    64
+#endif
 
 /********************************END OF MACROS*********************************/
 
@@ -34,6 +120,11 @@
   Description:
     Returns a single character via the receiver of the USARTD0 module.
 
+    Characters are queued in the receive ring buffer by the receive
+    complete interrupt. Waits until one is available; where that
+    interrupt cannot be taken (interrupts or the medium level disabled,
+    or called from an interrupt handler) the receiver is polled.
+
   Input(s): N/A
   Output(s): Character received from USARTD0 module.
 ------------------------------------------------------------------------------*/
@@ -43,15 +134,63 @@ char usartd0_in_char(void);
   usartd0_in_string -- 
   
   Description:
-    Reads in a string with the receiever of the USARTD0 module.
+    Reads in a line with the receiever of the USARTD0 module, waiting
+    until it is complete.
 
-    The string is to be stored within a pre-allocated buffer, accessible
-    via the character pointer `buf`.
+    The line is to be stored within a pre-allocated buffer, accessible
+    via the character pointer `buf`, of `size` bytes. A line ends at CR,
+    LF or CR LF; the terminator is not stored and the string is always
+    null-terminated. Characters beyond `size` - 1 are discarded.
 
   Input(s): `buf` - Pointer to character buffer.
-  Output(s): N/A
+            `size` - Size of the buffer in bytes (at least 1).
+  Output(s): Length of the line stored.
+------------------------------------------------------------------------------*/
+uint8_t usartd0_in_string(char * buf, uint8_t size);
+
+/*------------------------------------------------------------------------------
+  usartd0_try_read -- 
+  
+  Description:
+    Takes the oldest received character out of the receive ring buffer,
+    if there is one, without waiting.
+
+  Input(s): `c` - Where to store the character.
+  Output(s): 1 if a character was stored, 0 if none was waiting.
+------------------------------------------------------------------------------*/
+uint8_t usartd0_try_read(char * c);
+
+/*------------------------------------------------------------------------------
+  usartd0_try_line -- 
+  
+  Description:
+    Non-blocking form of `usartd0_in_string`. Moves whatever has been
+    received into `buf` and returns once the buffer is empty, so a
+    main loop can assemble a line across calls while doing other work.
+
+    The same `buf` and `size` must be passed until a line is returned;
+    the position within it is kept here, so there is one line being
+    assembled at a time. Empty lines are not returned.
+
+  Input(s): `buf` - Pointer to character buffer.
+            `size` - Size of the buffer in bytes (at least 2).
+  Output(s): Length of the null-terminated line in `buf` once one has
+             ended, otherwise 0.
 ------------------------------------------------------------------------------*/
-void usartd0_in_string(char * buf);
+uint8_t usartd0_try_line(char * buf, uint8_t size);
+
+/*------------------------------------------------------------------------------
+  usartd0_line_truncated -- 
+  
+  Description:
+    Tells whether the line last returned by `usartd0_in_string` or
+    `usartd0_try_line` lost characters for want of room in its buffer,
+    so that a caller can refuse it rather than act on part of it.
+
+  Input(s): N/A
+  Output(s): 1 if characters were discarded, otherwise 0.
+------------------------------------------------------------------------------*/
+uint8_t usartd0_line_truncated(void);
 
 /*------------------------------------------------------------------------------
   usartd0_init -- 
@@ -70,6 +209,11 @@ void usartd0_init(void);
   Description:
     Outputs a character via the transmitter of the USARTD0 module.
 
+    The character is queued in the transmit ring buffer, which the
+    data register empty interrupt drains. Waits only while the buffer
+    is full; where that interrupt cannot be taken (interrupts disabled,
+    or called from an interrupt handler) the buffer is drained by polling.
+
   Input(s): `c` - Read-only character.
   Output(s): N/A
 ------------------------------------------------------------------------------*/
@@ -89,6 +233,87 @@ void usartd0_out_char(char c);
 ------------------------------------------------------------------------------*/
 void usartd0_out_string(const char * str);
 
+/*------------------------------------------------------------------------------
+  usartd0_write -- 
+  
+  Description:
+    Queues as many of the `len` bytes at `buf` as fit in the transmit ring
+    buffer, without waiting, and returns how many were taken. The rest is
+    the caller's to retry or drop.
+
+  Input(s): `buf` - Bytes to send.
+            `len` - Number of bytes.
+  Output(s): Number of bytes queued.
+------------------------------------------------------------------------------*/
+uint16_t usartd0_write(const void * buf, uint16_t len);
+
+/*------------------------------------------------------------------------------
+  usartd0_tx_high_water -- 
+  
+  Description:
+    Returns the largest number of bytes that have been waiting in the
+    transmit ring buffer at once (USART_TX_BUF_LEN - 1 means it has filled
+    up), or with USART_TX_DMA in the buffer being filled (USART_TX_BUF_LEN
+    means it has filled up while the other one was being sent).
+
+  Input(s): N/A
+  Output(s): High-water mark in bytes.
+------------------------------------------------------------------------------*/
+uint16_t usartd0_tx_high_water(void);
+
+/*------------------------------------------------------------------------------
+  usartd0_tx_overflows -- 
+  
+  Description:
+    Returns how many times a write found the transmit buffer full:
+    `usartd0_write` calls that could not queue everything, and
+    `usartd0_out_char` calls that had to wait. With USART_TX_DMA this is
+    the producer stall count: both buffers were full, so the producer
+    had to wait for DMA to finish a block.
+
+  Input(s): N/A
+  Output(s): Overflow count (saturates at 65535).
+------------------------------------------------------------------------------*/
+uint16_t usartd0_tx_overflows(void);
+
+/*------------------------------------------------------------------------------
+  usartd0_rx_overflows -- 
+  
+  Description:
+    Returns how many received characters were dropped because the
+    receive ring buffer was full.
+
+  Input(s): N/A
+  Output(s): Dropped character count (saturates at 65535).
+------------------------------------------------------------------------------*/
+uint16_t usartd0_rx_overflows(void);
+
+/*------------------------------------------------------------------------------
+  usartd0_rx_overruns -- 
+  
+  Description:
+    Returns how many times the receiver reported a buffer overflow, i.e.
+    characters were lost in hardware before the receive complete
+    interrupt could take them.
+
+  Input(s): N/A
+  Output(s): Overrun count (saturates at 65535).
+------------------------------------------------------------------------------*/
+uint16_t usartd0_rx_overruns(void);
+
+/*------------------------------------------------------------------------------
+  usartd0_rx_frame_errors -- 
+  
+  Description:
+    Returns how many characters arrived with a framing error (no valid
+    stop bit, usually a baud rate mismatch or line noise). Such
+    characters are discarded.
+
+  Input(s): N/A
+  Output(s): Framing error count (saturates at 65535).
+------------------------------------------------------------------------------*/
+uint16_t usartd0_rx_frame_errors(void);
+
 
 /**************************END OF FUNCTION PROTOTYPES**************************/
 
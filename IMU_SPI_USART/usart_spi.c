@@ -0,0 +1,273 @@
+/*------------------------------------------------------------------------------
+  usart_spi.c --
+
+  Description:
+    Alternate transport for the LSM6DS3: implements the interface of `spi.h`
+    on USARTF0 in master SPI (MSPI) mode instead of on SPIF. Unlike SPIF, a
+    USART can be serviced by the DMA controller, which allows the IMU to be
+    sampled with no CPU involvement at all (see `spi_stream_start`).
+
+    Selected at build time by defining SPI_USART_MSPI for the whole project;
+    `spi.c` then compiles to nothing and this file takes its place.
+
+    USARTF0 is remapped onto PF4..PF7, so the IMU wiring is:
+      PF4  SS   -> CS
+      PF5  XCK0 -> SCL/SPC
+      PF6  RXD0 <- SDO
+      PF7  TXD0 -> SDA/SDI
+    Note that SCK and MOSI sit on swapped pins compared to SPIF.
+
+------------------------------------------------------------------------------*/
+
+/********************************DEPENDENCIES**********************************/
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <stddef.h>
+#include "spi.h"
+
+/*****************************END OF DEPENDENCIES******************************/
+
+#ifdef SPI_USART_MSPI
+
+/***********************************MACROS*************************************/
+
+/* CTRLC bit 1 selects the clock phase in MSPI mode. */
+#define USPI_UCPHA_bm       (1<<1)
+
+/* fXCK = fPER / (2 * (BSEL + 1)); BSEL 1 matches SPI_PRESCALER_DIV4_gc. */
+#define USPI_BSEL           (1)
+
+/* XCK0/TXD0/RXD0 once USARTF0 is remapped to the upper nibble of PORTF. */
+#define USPI_XCK_bm         (1<<5)
+#define USPI_RXD_bm         (1<<6)
+#define USPI_TXD_bm         (1<<7)
+
+/********************************END OF MACROS*********************************/
+
+/******************************GLOBAL VARIABLES********************************/
+
+/* Written by DMA CH0 to PORTF.OUTSET and then PORTF.OUTCLR. */
+static const uint8_t spi_stream_cs_pulse[2] = {SS_bm, SS_bm};
+
+/* Command byte followed by dummy bytes, clocked out by DMA CH1. */
+static uint8_t spi_stream_tx[SPI_STREAM_MAX_LEN];
+
+/* Receive ring filled by DMA CH2, and the laps CH2 has completed around
+ * it (modulo 256), counted by its block interrupt. */
+static uint8_t * spi_stream_ring = NULL;
+static volatile uint8_t spi_stream_laps = 0;
+
+/***************************END OF GLOBAL VARIABLES****************************/
+
+
+/*****************************FUNCTION DEFINITIONS*****************************/
+
+/* Loads the 24-bit source or destination address of a DMA channel. */
+static void spi_dma_addr(volatile uint8_t * reg, const volatile void * addr)
+{
+    reg[0] = (uint8_t)((uintptr_t)addr);
+    reg[1] = (uint8_t)((uintptr_t)addr >> 8);
+    reg[2] = (uint8_t)(((uint32_t)((uintptr_t)addr)) >> 16);
+}
+
+void spi_init(void)
+{
+    /* SS idles high; XCK idles high in mode 3 (inverted via INVEN). */
+    PORTF.OUTSET = (SS_bm | USPI_XCK_bm | USPI_TXD_bm);
+    PORTF.DIRSET = (SS_bm | USPI_XCK_bm | USPI_TXD_bm);
+    PORTF.DIRCLR = (USPI_RXD_bm);
+
+    /* Move USARTF0 from PF0..PF3 to PF4..PF7. */
+    PORTF.REMAP |= PORT_USART0_bm;
+
+    /* Mode 3: inverted clock plus UCPHA. MSB first (UDORD cleared). */
+    PORTF.PIN5CTRL = PORT_INVEN_bm;
+
+    USARTF0.BAUDCTRLA = (uint8_t)USPI_BSEL;
+    USARTF0.BAUDCTRLB = (uint8_t)(USPI_BSEL >> 8);
+
+    USARTF0.CTRLC = USART_CMODE_MSPI_gc | USPI_UCPHA_bm;
+
+    USARTF0.CTRLB = USART_RXEN_bm | USART_TXEN_bm;
+}
+
+/* Clocks one byte out and returns the byte clocked in. */
+static uint8_t spi_transceive(uint8_t data)
+{
+    USARTF0.DATA = data;
+
+    while(!(USARTF0.STATUS & USART_RXCIF_bm));
+
+    return USARTF0.DATA;
+}
+
+void spi_write(uint8_t data)
+{
+    spi_transceive(data);
+}
+
+uint8_t spi_read(void)
+{
+    return spi_transceive(SPI_DUMMY_BYTE);
+}
+
+/* Control-plane traffic (register setup, status reads) is rare enough that
+ * the transaction API is carried out synchronously here; sampling goes
+ * through the DMA stream instead. */
+void spi_submit(spi_xfer_t * xfer)
+{
+    xfer->busy = 1;
+
+    if(xfer->cs_port)
+    {
+        xfer->cs_port->OUTCLR = xfer->cs_bm;
+    }
+
+    for(uint16_t i = 0; i < xfer->tx_len; i++)
+    {
+        spi_transceive(xfer->tx[i]);
+    }
+
+    for(uint16_t i = 0; i < xfer->rx_len; i++)
+    {
+        xfer->rx[i] = spi_transceive(SPI_DUMMY_BYTE);
+    }
+
+    if(xfer->cs_port)
+    {
+        xfer->cs_port->OUTSET = xfer->cs_bm;
+    }
+
+    xfer->busy = 0;
+
+    if(xfer->done)
+    {
+        xfer->done(xfer);
+    }
+}
+
+void spi_wait(spi_xfer_t * xfer)
+{
+    while(xfer->busy);
+}
+
+void spi_transfer(spi_xfer_t * xfer)
+{
+    spi_submit(xfer);
+}
+
+void spi_stream_start(uint8_t cmd, uint8_t len, uint8_t * ring, uint8_t count, uint8_t evsys_chmux)
+{
+    spi_stream_tx[0] = cmd;
+
+    for(uint8_t i = 1; i < len; i++)
+    {
+        spi_stream_tx[i] = SPI_DUMMY_BYTE;
+    }
+
+    spi_stream_ring = ring;
+    spi_stream_laps = 0;
+
+    /* Event channel 0 carries the sensor's data-ready edge. The pin sense
+     * configuration (rising edge) is left to the application. */
+    EVSYS.CH0MUX = evsys_chmux;
+
+    /* Reset only the channels used here; CH3 may be carrying USARTD0
+     * output (see USART_TX_DMA in `usart.c`). */
+    DMA.CH0.CTRLA = DMA_CH_RESET_bm;
+    DMA.CH1.CTRLA = DMA_CH_RESET_bm;
+    DMA.CH2.CTRLA = DMA_CH_RESET_bm;
+
+    /* CH0: on each data-ready event, write SS to OUTSET then OUTCLR. This ends
+     * the previous read (if any) and opens the next one. Once it finishes,
+     * double buffering hands over to CH1. */
+    DMA.CH0.ADDRCTRL = DMA_CH_SRCRELOAD_BURST_gc | DMA_CH_SRCDIR_INC_gc |
+                       DMA_CH_DESTRELOAD_BURST_gc | DMA_CH_DESTDIR_INC_gc;
+    DMA.CH0.TRIGSRC = DMA_CH_TRIGSRC_EVSYS_CH0_gc;
+    DMA.CH0.TRFCNT = sizeof(spi_stream_cs_pulse);
+    DMA.CH0.REPCNT = 0;
+    spi_dma_addr(&DMA.CH0.SRCADDR0, spi_stream_cs_pulse);
+    spi_dma_addr(&DMA.CH0.DESTADDR0, &PORTF.OUTSET);
+    DMA.CH0.CTRLA = DMA_CH_REPEAT_bm | DMA_CH_SINGLE_bm | DMA_CH_BURSTLEN_2BYTE_gc;
+
+    /* CH1: clock out the command and dummy bytes, paced by DRE. Once it
+     * finishes, CH0 is re-armed for the next event. */
+    DMA.CH1.ADDRCTRL = DMA_CH_SRCRELOAD_TRANSACTION_gc | DMA_CH_SRCDIR_INC_gc |
+                       DMA_CH_DESTRELOAD_NONE_gc | DMA_CH_DESTDIR_FIXED_gc;
+    DMA.CH1.TRIGSRC = DMA_CH_TRIGSRC_USARTF0_DRE_gc;
+    DMA.CH1.TRFCNT = len;
+    DMA.CH1.REPCNT = 0;
+    spi_dma_addr(&DMA.CH1.SRCADDR0, spi_stream_tx);
+    spi_dma_addr(&DMA.CH1.DESTADDR0, &USARTF0.DATA);
+    DMA.CH1.CTRLA = DMA_CH_REPEAT_bm | DMA_CH_SINGLE_bm | DMA_CH_BURSTLEN_1BYTE_gc;
+
+    /* CH2: store every received byte, wrapping around the ring forever. In
+     * repeat mode its transaction flag is raised at the end of every block,
+     * i.e. once per lap, which the low level interrupt counts. */
+    DMA.CH2.ADDRCTRL = DMA_CH_SRCRELOAD_NONE_gc | DMA_CH_SRCDIR_FIXED_gc |
+                       DMA_CH_DESTRELOAD_BLOCK_gc | DMA_CH_DESTDIR_INC_gc;
+    DMA.CH2.TRIGSRC = DMA_CH_TRIGSRC_USARTF0_RXC_gc;
+    DMA.CH2.TRFCNT = (uint16_t)len * count;
+    DMA.CH2.REPCNT = 0;
+    spi_dma_addr(&DMA.CH2.SRCADDR0, &USARTF0.DATA);
+    spi_dma_addr(&DMA.CH2.DESTADDR0, ring);
+    DMA.CH2.CTRLB = DMA_CH_TRNIF_bm | DMA_CH_TRNINTLVL_LO_gc;
+    DMA.CH2.CTRLA = DMA_CH_ENABLE_bm | DMA_CH_REPEAT_bm | DMA_CH_SINGLE_bm | DMA_CH_BURSTLEN_1BYTE_gc;
+
+    DMA.CTRL = (DMA.CTRL & ~DMA_DBUFMODE_gm) | DMA_ENABLE_bm | DMA_DBUFMODE_CH01_gc;
+    DMA.CH0.CTRLA |= DMA_CH_ENABLE_bm;
+}
+
+void spi_stream_stop(void)
+{
+    DMA.CH0.CTRLA = 0;
+    DMA.CH1.CTRLA = 0;
+    DMA.CH2.CTRLA = 0;
+    DMA.CH2.CTRLB = DMA_CH_TRNIF_bm;
+    DMA.CTRL &= ~DMA_DBUFMODE_gm;
+
+    PORTF.OUTSET = SS_bm;
+
+    spi_stream_ring = NULL;
+}
+
+/* Laps completed, including one whose interrupt is still pending (as it is
+ * while interrupts are masked). */
+static uint8_t spi_stream_laps_now(void)
+{
+    return spi_stream_laps + ((DMA.CH2.CTRLB & DMA_CH_TRNIF_bm) ? 1 : 0);
+}
+
+uint16_t spi_stream_pos(uint8_t * laps)
+{
+    uint16_t dest;
+    uint8_t n;
+
+    /* the DMA may carry between the two bytes, or wrap around the ring
+     * between reading the laps and the address; read until stable */
+    do
+    {
+        n = spi_stream_laps_now();
+        dest = DMA.CH2.DESTADDR0 | ((uint16_t)DMA.CH2.DESTADDR1 << 8);
+    } while(dest != (DMA.CH2.DESTADDR0 | ((uint16_t)DMA.CH2.DESTADDR1 << 8)) ||
+            n != spi_stream_laps_now());
+
+    if(laps)
+    {
+        *laps = n;
+    }
+
+    return dest - (uint16_t)(uintptr_t)spi_stream_ring;
+}
+
+ISR(DMA_CH2_vect)
+{
+    DMA.CH2.CTRLB = DMA_CH_TRNIF_bm | DMA_CH_TRNINTLVL_LO_gc;
+
+    spi_stream_laps++;
+}
+
+/***************************END OF FUNCTION DEFINITIONS************************/
+
+#endif // SPI_USART_MSPI
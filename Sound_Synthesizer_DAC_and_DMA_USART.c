@@ -1,190 +1,284 @@
 /*
 Name:			Thomas Creel
-Description:	sound synthesizer with triangle and sine waveforms, as well as
-				12 keys
+Description:	sound synthesizer with sine, triangle, saw and square
+				waveforms, as well as 12 keys
+
+				the keys play C6 to B6 for 250 ms each, and any number
+				of them can sound together: notes go to the polyphonic
+				dds engine of IMU_SPI_USART/synth.h, SYNTH_VOICES voices
+				mixed in integer arithmetic at a fixed SYNTH_RATE. 's'
+				switches to the next of sine, triangle, saw and square,
+				notes already sounding included: the change is staged
+				and taken up at the next block, where each voice
+				crossfades to the new waveform over SYNTH_FADE samples,
+				so there is no gap and no click. 'L' halves the block
+				length, down to SYNTH_BLOCK_MIN, and then goes back to
+				SYNTH_BLOCK, for less latency or less interrupt load
+
+				'Q' plays the song (mary had a little lamb until another
+				is uploaded), or stops it. the song plays in the
+				background, off the TCC0 compare A interrupt, through
+				the sequencer of IMU_SPI_USART/seq.h, so the keys and
+				everything else keep working meanwhile. '+' and '-'
+				change the tempo by 10 bpm (120 at start up)
+
+				a song is uploaded as lines of decimal numbers, each
+				event four of them: note (60 is middle C, 0 a rest),
+				level (1 to 255), length and rest after it, both in
+				ticks of SEQ_PPQ (8) per beat
+
+				  @<bpm> <note> <level> <length> <rest> ...
+				  @+ <note> <level> <length> <rest> ...
+
+				the first replaces the song and sets the tempo, the
+				second adds events to it, up to SONG_EVENTS. each line
+				is answered with "ok <events>", or "?" if it was
+				malformed, held too many events or ran past 127
+				characters, in which case the song is left as it was.
+				uploading stops the song
+
+				the waveforms come from a bank of band-limited tables
+				in flash (IMU_SPI_USART/synth_waves.c, made by
+				host/synth_sim/wavegen), one per octave for all but the
+				sine, read with linear interpolation
+
+				TCC1 overflows at SYNTH_RATE and, through event channel
+				1, has the dma write one sample to DACA CH1 each time.
+				DMA CH0 and CH1 run double buffered, each streaming one
+				of two blocks of SYNTH_BLOCK samples and handing over to
+				the other when done; the transfer complete interrupt of
+				each then renders its block again while the other one
+				plays, a block (4 ms at 64 samples and 16 kHz) ahead of
+				the DAC. the dma is set up once: a new block length is
+				written to each channel by its own interrupt, while it
+				waits for the other one
+
+				build together with IMU_SPI_USART/usart.c,
+				IMU_SPI_USART/synth.c, IMU_SPI_USART/synth_waves.c,
+				IMU_SPI_USART/seq.c and IMU_SPI_USART/clock.c, at the
+				default F_CPU of 32 MHz.
+				the terminal runs at USART_BAUD, 115200 by default;
+				-DUSART_BAUD=9600 for the old 9600 bps. host/synth_sim
+				renders the engine to a wav file and times it
 								
 */ 
 
-extern void clock_init(void);
-
 #include <avr/io.h>
 #include <avr/interrupt.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "IMU_SPI_USART/clock.h"
+#include "IMU_SPI_USART/usart.h"
+#include "IMU_SPI_USART/synth.h"
+#include "IMU_SPI_USART/seq.h"
+
+// samples per dma block, i.e. per interrupt, at most and at least
+#ifndef SYNTH_BLOCK
+#define SYNTH_BLOCK	64
+#endif
+
+#define SYNTH_BLOCK_MIN	16
+
+#if SYNTH_BLOCK < SYNTH_BLOCK_MIN || SYNTH_BLOCK > 255
+#error "SYNTH_BLOCK out of range"
+#endif
+
+// both dma channels: one sample per trigger, block after block
+#define DMA_CH_MODE	(DMA_CH_REPEAT_bm | DMA_CH_SINGLE_bm | DMA_CH_BURSTLEN_2BYTE_gc)
 
+// level of the notes the keys play, out of 255
+#define KEY_LEVEL	160
 
-// 32 MHz, 9600 bps
-#define BSCALE -4
-#define BSEL 3317
+// events the song buffer holds, and the tempo at start up
+#define SONG_EVENTS	128
+#define SONG_BPM	120
+
+// TCC0 runs from the peripheral clock / 1024
+#define SEQ_TIMER_HZ	(F_CPU / 1024)
+
+#if SEQ_TIMER_HZ * 60 / SEQ_TICKS_PER_MINUTE(SEQ_BPM_MIN) > 0xFFFF
+#error "SEQ_BPM_MIN too slow for TCC0 at this F_CPU"
+#endif
+
+#if F_CPU / SYNTH_RATE > 0x10000
+#error "SYNTH_RATE too low for TCC1 at this F_CPU"
+#endif
 
 void dma_init(void);
 void dac_init(void);
 void tcc1_init(void);
 void analog_init(void);
-void usartd0_init(void);
-void usartd0_out_char(char c);
-void usartd0_out_string(const char * str);
-
-// for fun
+void note(uint8_t n, uint16_t gate);
+void block_refill(uint8_t n);
 void tcc0_init(void);
+void tempo_set(uint16_t bpm);
+int16_t song_parse(char * p, seq_event_t * dest, uint16_t room);
+void song_upload(char * line);
+void reply_events(uint16_t n);
+
 
+synth_t synth;
 
-volatile uint8_t data = 0;
-volatile uint8_t dataflag = 0;
-volatile uint8_t waveflag = 0;
+// the two blocks the dma plays in turn
+uint16_t synth_block[2][SYNTH_BLOCK];
+
+// samples per block: the length 'L' asks for, and the one each channel
+// plays
+volatile uint8_t block_len_next = SYNTH_BLOCK;
+uint8_t block_len[2];
 
 char keys[12] =
 {
 	'W', '3', 'E', '4', 'R', 'T', '6', 'Y', '7', 'U', '8', 'I'
 };
 
-uint16_t notes[12] =
+// notes of the keys, C6 (84) to B6
+uint8_t notes[12] =
 {
-	0x77, 0x70, 0x6A, 0x64, 0x5E, 0x59, 0x54, 0x4F, 0x4B, 0x47, 0x43, 0x3F
+	84, 85, 86, 87, 88, 89, 90, 91, 92, 93, 94, 95
 };
 
-// Mary had a little lamb
+seq_t seq;
+
+// tempo, and TCC0 counts per sequencer tick
+uint16_t tempo_bpm;
+volatile uint16_t tick_period;
+
+// Mary had a little lamb, until a song is uploaded: each note a beat,
+// then a quarter beat of rest, half a beat after the 8th and 11th
 // E, D, C, D, E, E, E
 // D, D, D, E, E, E
 // E, D, C, D, E, E, E
 // E, D, D, E, D, C
-uint16_t song[23] =
-{
-	0x5E, 0x6A, 0x77, 0x5E, 0x5E, 0x5E,
-	0x6A, 0x6A, 0x6A, 0x5E, 0x5E,
-	0x5E, 0x6A, 0x77, 0x5E, 0x5E, 0x5E,
-	0x5E, 0x6A, 0x6A, 0x5E, 0x6A, 0x77
-};
-
-uint16_t sinewave[256] =
-{
-	0x800,0x832,0x864,0x896,0x8c8,0x8fa,0x92c,0x95e,0x98f,0x9c0,0x9f1,0xa22,0xa52,0xa82,0xab1,0xae0,
-	0xb0f,0xb3d,0xb6b,0xb98,0xbc5,0xbf1,0xc1c,0xc47,0xc71,0xc9a,0xcc3,0xceb,0xd12,0xd39,0xd5f,0xd83,
-	0xda7,0xdca,0xded,0xe0e,0xe2e,0xe4e,0xe6c,0xe8a,0xea6,0xec1,0xedc,0xef5,0xf0d,0xf24,0xf3a,0xf4f,
-	0xf63,0xf76,0xf87,0xf98,0xfa7,0xfb5,0xfc2,0xfcd,0xfd8,0xfe1,0xfe9,0xff0,0xff5,0xff9,0xffd,0xffe,
-	0xfff,0xffe,0xffd,0xff9,0xff5,0xff0,0xfe9,0xfe1,0xfd8,0xfcd,0xfc2,0xfb5,0xfa7,0xf98,0xf87,0xf76,
-	0xf63,0xf4f,0xf3a,0xf24,0xf0d,0xef5,0xedc,0xec1,0xea6,0xe8a,0xe6c,0xe4e,0xe2e,0xe0e,0xded,0xdca,
-	0xda7,0xd83,0xd5f,0xd39,0xd12,0xceb,0xcc3,0xc9a,0xc71,0xc47,0xc1c,0xbf1,0xbc5,0xb98,0xb6b,0xb3d,
-	0xb0f,0xae0,0xab1,0xa82,0xa52,0xa22,0x9f1,0x9c0,0x98f,0x95e,0x92c,0x8fa,0x8c8,0x896,0x864,0x832,
-	0x800,0x7cd,0x79b,0x769,0x737,0x705,0x6d3,0x6a1,0x670,0x63f,0x60e,0x5dd,0x5ad,0x57d,0x54e,0x51f,
-	0x4f0,0x4c2,0x494,0x467,0x43a,0x40e,0x3e3,0x3b8,0x38e,0x365,0x33c,0x314,0x2ed,0x2c6,0x2a0,0x27c,
-	0x258,0x235,0x212,0x1f1,0x1d1,0x1b1,0x193,0x175,0x159,0x13e,0x123,0x10a,0xf2,0xdb,0xc5,0xb0,
-	0x9c,0x89,0x78,0x67,0x58,0x4a,0x3d,0x32,0x27,0x1e,0x16,0xf,0xa,0x6,0x2,0x1,
-	0x0,0x1,0x2,0x6,0xa,0xf,0x16,0x1e,0x27,0x32,0x3d,0x4a,0x58,0x67,0x78,0x89,
-	0x9c,0xb0,0xc5,0xdb,0xf2,0x10a,0x123,0x13e,0x159,0x175,0x193,0x1b1,0x1d1,0x1f1,0x212,0x235,
-	0x258,0x27c,0x2a0,0x2c6,0x2ed,0x314,0x33c,0x365,0x38e,0x3b8,0x3e3,0x40e,0x43a,0x467,0x494,0x4c2,
-	0x4f0,0x51f,0x54e,0x57d,0x5ad,0x5dd,0x60e,0x63f,0x670,0x6a1,0x6d3,0x705,0x737,0x769,0x79b,0x7cd
-};
-
-uint16_t trianglewave[256] =
+seq_event_t song[SONG_EVENTS] =
 {
-	0x20,0x40,0x60,0x80,0xa0,0xc0,0xe0,0x100,0x120,0x140,0x160,0x180,0x1a0,0x1c0,0x1e0,0x200,
-	0x220,0x240,0x260,0x280,0x2a0,0x2c0,0x2e0,0x300,0x320,0x340,0x360,0x380,0x3a0,0x3c0,0x3e0,0x400,
-	0x420,0x440,0x460,0x480,0x4a0,0x4c0,0x4e0,0x500,0x520,0x540,0x560,0x580,0x5a0,0x5c0,0x5e0,0x600,
-	0x620,0x640,0x660,0x680,0x6a0,0x6c0,0x6e0,0x700,0x720,0x740,0x760,0x780,0x7a0,0x7c0,0x7e0,0x800,
-	0x81f,0x83f,0x85f,0x87f,0x89f,0x8bf,0x8df,0x8ff,0x91f,0x93f,0x95f,0x97f,0x99f,0x9bf,0x9df,0x9ff,
-	0xa1f,0xa3f,0xa5f,0xa7f,0xa9f,0xabf,0xadf,0xaff,0xb1f,0xb3f,0xb5f,0xb7f,0xb9f,0xbbf,0xbdf,0xbff,
-	0xc1f,0xc3f,0xc5f,0xc7f,0xc9f,0xcbf,0xcdf,0xcff,0xd1f,0xd3f,0xd5f,0xd7f,0xd9f,0xdbf,0xddf,0xdff,
-	0xe1f,0xe3f,0xe5f,0xe7f,0xe9f,0xebf,0xedf,0xeff,0xf1f,0xf3f,0xf5f,0xf7f,0xf9f,0xfbf,0xfdf,0xfff,
-	0xfdf,0xfbf,0xf9f,0xf7f,0xf5f,0xf3f,0xf1f,0xeff,0xedf,0xebf,0xe9f,0xe7f,0xe5f,0xe3f,0xe1f,0xdff,
-	0xddf,0xdbf,0xd9f,0xd7f,0xd5f,0xd3f,0xd1f,0xcff,0xcdf,0xcbf,0xc9f,0xc7f,0xc5f,0xc3f,0xc1f,0xbff,
-	0xbdf,0xbbf,0xb9f,0xb7f,0xb5f,0xb3f,0xb1f,0xaff,0xadf,0xabf,0xa9f,0xa7f,0xa5f,0xa3f,0xa1f,0x9ff,
-	0x9df,0x9bf,0x99f,0x97f,0x95f,0x93f,0x91f,0x8ff,0x8df,0x8bf,0x89f,0x87f,0x85f,0x83f,0x81f,0x800,
-	0x7e0,0x7c0,0x7a0,0x780,0x760,0x740,0x720,0x700,0x6e0,0x6c0,0x6a0,0x680,0x660,0x640,0x620,0x600,
-	0x5e0,0x5c0,0x5a0,0x580,0x560,0x540,0x520,0x500,0x4e0,0x4c0,0x4a0,0x480,0x460,0x440,0x420,0x400,
-	0x3e0,0x3c0,0x3a0,0x380,0x360,0x340,0x320,0x300,0x2e0,0x2c0,0x2a0,0x280,0x260,0x240,0x220,0x200,
-	0x1e0,0x1c0,0x1a0,0x180,0x160,0x140,0x120,0x100,0xe0,0xc0,0xa0,0x80,0x60,0x40,0x20,0x0
+	{88, 160, 8, 2}, {86, 160, 8, 2}, {84, 160, 8, 2}, {88, 160, 8, 2},
+	{88, 160, 8, 2}, {88, 160, 8, 2}, {86, 160, 8, 2}, {86, 160, 8, 4},
+	{86, 160, 8, 2}, {88, 160, 8, 2}, {88, 160, 8, 4}, {88, 160, 8, 2},
+	{86, 160, 8, 2}, {84, 160, 8, 2}, {88, 160, 8, 2}, {88, 160, 8, 2},
+	{88, 160, 8, 2}, {88, 160, 8, 2}, {86, 160, 8, 2}, {86, 160, 8, 2},
+	{88, 160, 8, 2}, {86, 160, 8, 2}, {84, 160, 8, 2}
 };
+uint16_t song_len = 23;
 
+// an upload line being received, after its '@'
+char upload_line[128];
+uint8_t uploading = 0;
 
 int main(void)
 {
 	clock_init();
-	dma_init();
+	synth_init(&synth);
+	seq_init(&seq);
 	dac_init();
+	dma_init();
 	tcc1_init();
 	analog_init();
 	
 	PMIC_CTRL = PMIC_MEDLVLEN_bm | PMIC_LOLVLEN_bm;
 	sei();
 	
+	// also enables the (medium level) receive interrupt
 	usartd0_init();
 	
-	
-	// for fun
+	tempo_set(SONG_BPM);
 	tcc0_init();
 	
 	while(1)
 	{
-		// Depending on button press of 's' choose between sinewave and trianglewave
-		if(dataflag)
+		char data;
+		
+		// an upload line is assembled as it arrives, keys wait meanwhile
+		if(uploading)
 		{
-			dataflag = 0;
-			// if 's' switch between sinewave and trianglewave
-			if(data == 's')
+			if(usartd0_try_line(upload_line, sizeof(upload_line)))
 			{
-				// poll DMA status for when its ready to be reset
-				while(!((DMA.INTFLAGS & DMA_CH1TRNIF_bm) >> 1));
+				// the end of a line too long for the buffer was lost
+				if(usartd0_line_truncated())
+				{
+					usartd0_out_string("?\r\n");
+				}
+				else
+				{
+					song_upload(upload_line);
+				}
 				
-				dma_init();
-
+				uploading = 0;
 			}
+		}
+		else if(usartd0_try_read(&data))
+		{
+			// echo without waiting; if the transmit buffer is full the echo is dropped
+			usartd0_write(&data, 1);
 			
-			uint16_t ms50 = 1562;
-			uint16_t ms125 = 3906;
-			uint16_t ms250 = 7812;
-			uint16_t ms500 = 15625;
-			uint16_t ms1000 = 31250;
+			// if 's' switch to the next waveform, from the next block on
+			if(data == 's')
+			{
+				synth_set_shape(&synth, (synth.shape_next + 1) % SYNTH_SHAPES);
+			}
+			
+			// if 'L' halve the block length, each channel takes it up
+			// at its next block
+			if(data == 'L')
+			{
+				uint8_t len = block_len_next / 2;
+				
+				block_len_next = (len < SYNTH_BLOCK_MIN) ? SYNTH_BLOCK : len;
+			}
 			
+			// the note sounds on by itself, so keys can overlap
 			for(uint8_t i = 0; i < 12; i++)
 			{
 				if(data == keys[i])
 				{
-					TCC1.PER = notes[i];
-					
-					TCC0.CNT = 0;
-					TCC0.PER = ms250;
-					
-					while(!(TCC0.INTFLAGS & TC0_OVFIF_bm));
-					TCC0.INTFLAGS |= TC0_OVFIF_bm;
-					
-					TCC1.PER = 0;
-					
+					note(notes[i], SYNTH_RATE / 4);
 				}
 			}
 			
-			/* JUST FOR FUN */
-			// Plays mary had a little lamb
-			
+			// play or stop the song, which goes on in the background
 			if(data == 'Q')
 			{
-				for(int i = 0; i < 23; i++)
+				cli();
+				if(seq.playing)
 				{
-					TCC0.CNT = 0;
-					TCC0.PER = ms500;
-				
-					TCC1.PER = song[i];
-					
-					while(!(TCC0.INTFLAGS & TC0_OVFIF_bm));
-					TCC0.INTFLAGS |= TC0_OVFIF_bm;
-					
-					TCC0.CNT = 0;
-					TCC0.PER = ms125;
-					if( i == 7 | i == 10)
-					{
-						TCC0.PER = ms250;
-					}
-					
-					TCC1.PER = 0;
-					
-					while(!(TCC0.INTFLAGS & TC0_OVFIF_bm));
-					TCC0.INTFLAGS |= TC0_OVFIF_bm;	
+					seq_stop(&seq, &synth);
+				}
+				else
+				{
+					seq_play(&seq, &synth, song, song_len);
 				}
-				TCC1.PER = 0;
+				sei();
+			}
+			
+			if(data == '+')
+			{
+				tempo_set(tempo_bpm + 10);
+			}
+			
+			if(data == '-')
+			{
+				tempo_set(tempo_bpm - 10);
+			}
+			
+			// the rest of the line is a song upload
+			if(data == '@')
+			{
+				uploading = 1;
 			}
 
 		}
 	}
 }
 
+// starts a note for gate samples, with the dma interrupts that render
+// masked
+void note(uint8_t n, uint16_t gate)
+{
+	cli();
+	synth_note_on(&synth, n, KEY_LEVEL, gate);
+	sei();
+}
+
 void analog_init(void)
 {
 	// POWER_DOWN_L PC7, make false (drive high), for analog backpack prevent shutdown
@@ -194,60 +288,50 @@ void analog_init(void)
 	PORTC.DIRSET = PIN7_bm;
 }
 
+// writes a 24 bit dma address register from a pointer
+void dma_addr(volatile uint8_t * reg, const volatile void * addr)
+{
+	reg[0] = (uint8_t)((uintptr_t)addr);
+	reg[1] = (uint8_t)((uintptr_t)addr >> 8);
+	reg[2] = (uint8_t)(((uint32_t)((uintptr_t)addr)) >> 16);
+}
 
+// dma CH0 and CH1, double buffered: each streams its block to the dac,
+// one sample per TCC1 overflow, and hands over to the other one when
+// the block is done
 void dma_init(void)
 {
-	if(waveflag == 0)
-	{
-		waveflag = 1;
-	}
-	else if(waveflag == 1)
-	{
-		waveflag = 0;
-	}
-	
 	// Reset DMAC
+	DMA.CTRL = 0;
 	DMA.CTRL = DMA_RESET_bm;
 	
-	// Single burst, repeat block, 2 bursts per block
-	DMA.CH1.CTRLA |=  DMA_CH_BURSTLEN_2BYTE_gc | DMA_CH_SINGLE_bm | DMA_CH_REPEAT_bm;
-
-	// Reload source when done, increment address from src, releast dest, inc dest
-	DMA.CH1.ADDRCTRL = DMA_CH_SRCRELOAD_BLOCK_gc | DMA_CH_SRCDIR_INC_gc | DMA_CH_DESTRELOAD_BURST_gc | DMA_CH_DESTDIR_INC_gc;
-	
-	// CH1 triggers event system
-	DMA.CH1.TRIGSRC = DMA_CH_TRIGSRC_EVSYS_CH1_gc;
-	
-	// Depending on button press of 's' choose between sinewave (0) and trianglewave (1)
-	if(waveflag == 1)
+	for(uint8_t n = 0; n < 2; n++)
 	{
-		// Total bytes in block transfer
-		DMA.CH1.TRFCNT = (uint16_t)(sizeof(sinewave));
+		DMA_CH_t * ch = n ? &DMA.CH1 : &DMA.CH0;
 		
-		// Configuring source address as sinewave location
-		DMA_CH1_SRCADDR0 = (uint8_t)((uintptr_t)sinewave);
-		DMA_CH1_SRCADDR1 = (uint8_t)((uintptr_t)sinewave >> 8);
-		DMA_CH1_SRCADDR2 = (uint8_t)(((uint32_t)((uintptr_t)sinewave))>>16);
-	}
-	else if(waveflag == 0)
-	{
-		// Total bytes in block transfer
-		DMA.CH1.TRFCNT = (uint16_t)(sizeof(trianglewave));
+		// both blocks start out silent
+		block_len[n] = block_len_next;
+		synth_render(&synth, synth_block[n], block_len[n]);
+		
+		// Reload source when done, increment address from src, reload dest, inc dest
+		ch->ADDRCTRL = DMA_CH_SRCRELOAD_BLOCK_gc | DMA_CH_SRCDIR_INC_gc |
+					   DMA_CH_DESTRELOAD_BURST_gc | DMA_CH_DESTDIR_INC_gc;
 		
-		// Configuring source address as sinewave location
-		DMA_CH1_SRCADDR0 = (uint8_t)((uintptr_t)trianglewave);
-		DMA_CH1_SRCADDR1 = (uint8_t)((uintptr_t)trianglewave >> 8);
-		DMA_CH1_SRCADDR2 = (uint8_t)(((uint32_t)((uintptr_t)trianglewave))>>16);
+		// triggered by event channel 1, the TCC1 overflow
+		ch->TRIGSRC = DMA_CH_TRIGSRC_EVSYS_CH1_gc;
+		ch->TRFCNT = block_len[n] * sizeof(synth_block[0][0]);
+		ch->REPCNT = 0;
+		dma_addr(&ch->SRCADDR0, synth_block[n]);
+		dma_addr(&ch->DESTADDR0, &DACA.CH1DATA);
+		
+		// one interrupt per block
+		ch->CTRLB = DMA_CH_TRNINTLVL_LO_gc;
+		ch->CTRLA = DMA_CH_MODE;
 	}
 	
-	// Configuring destination address as DAC DATA register
-	DMA_CH1_DESTADDR0 = (uint8_t)((uintptr_t)&DACA_CH1DATA);
-	DMA_CH1_DESTADDR1 = (uint8_t)((uintptr_t)&DACA_CH1DATA >> 8);
-	DMA_CH1_DESTADDR2 = (uint8_t)(((uint32_t)((uintptr_t)&DACA_CH1DATA))>>16);
-	
-	// Enable DMA
-	DMA.CH1.CTRLA |= DMA_CH_ENABLE_bm;
-	DMA.CTRL |= DMA_ENABLE_bm;
+	DMA.CTRL = DMA_ENABLE_bm | DMA_DBUFMODE_CH01_gc;
+	// written whole, never or'ed into, so no stale bits survive
+	DMA.CH0.CTRLA = DMA_CH_ENABLE_bm | DMA_CH_MODE;
 }
 
 void dac_init(void){
@@ -267,8 +351,8 @@ void dac_init(void){
 
 void tcc1_init(void)
 {
-	// 32MHz, 0 Hz starting frequency, prescaler 1
-	TCC1.PER =  0;
+	// one overflow per sample, prescaler 1
+	TCC1.PER = (uint16_t)(F_CPU / SYNTH_RATE - 1);
 	
 	// Prescaler
 	TCC1.CTRLA = TC_CLKSEL_DIV1_gc;
@@ -277,54 +361,204 @@ void tcc1_init(void)
 	EVSYS.CH1MUX = EVSYS_CHMUX_TCC1_OVF_gc;
 }
 
+// TCC0 runs free, compare A fires once per sequencer tick and is moved
+// on by a tick each time, so a new tempo takes effect from the next tick
 void tcc0_init(void)
 {
-	// .3 second timer
-	TCC0.PER = 18750;
+	TCC0.CTRLA = TC_CLKSEL_OFF_gc;
+	TCC0.CTRLB = TC_WGMODE_NORMAL_gc;
+	TCC0.PER = 0xFFFF;
+	TCC0.CNT = 0;
+	TCC0.CCA = tick_period;
+	TCC0.INTFLAGS = TC0_CCAIF_bm;
 	
+	// the level the dma interrupts render at, so the two never overlap
+	TCC0.INTCTRLB = TC_CCAINTLVL_LO_gc;
 	TCC0.CTRLA = TC_CLKSEL_DIV1024_gc;
 }
 
-void usartd0_init(void)
-{	
-  /* Configure relevant TxD and RxD pins. */
-	PORTD.OUTSET = PIN3_bm;
-	PORTD.DIRSET = PIN3_bm;
-	PORTD.DIRCLR = PIN2_bm;
-
-  /* Configure baud rate. */
-	USARTD0.BAUDCTRLA = (uint8_t)BSEL;
-	USARTD0.BAUDCTRLB = (uint8_t)((BSCALE << 4)|(BSEL >> 8));
-
-  /* Configure remainder of serial protocol. */
-  /* (In this example, a protocol with 8 data bits, no parity, and
-   *  one stop bit is chosen.) */
-	USARTD0.CTRLC =	(USART_CMODE_ASYNCHRONOUS_gc |
-					 USART_PMODE_DISABLED_gc  	 |
-					 USART_CHSIZE_8BIT_gc)       &
-					~USART_SBMODE_bm;
-
-  /* Enable receiver and/or transmitter systems. */
-	USARTD0.CTRLB = USART_RXEN_bm | USART_TXEN_bm;
-
-  /* Enable interrupt as medium level. */
-	USARTD0.CTRLA = USART_RXCINTLVL_MED_gc; 
+// sets the tempo, within SEQ_BPM_MIN and SEQ_BPM_MAX
+void tempo_set(uint16_t bpm)
+{
+	if(bpm < SEQ_BPM_MIN)
+	{
+		bpm = SEQ_BPM_MIN;
+	}
+	else if(bpm > SEQ_BPM_MAX)
+	{
+		bpm = SEQ_BPM_MAX;
+	}
+	
+	tempo_bpm = bpm;
+	
+	cli();
+	tick_period = (uint16_t)(SEQ_TIMER_HZ * 60 / SEQ_TICKS_PER_MINUTE(bpm));
+	sei();
+}
+
+// parses the events of an upload line into dest, if not NULL, with
+// room for that many; returns the events, or -1 if the line is
+// malformed or they do not fit
+int16_t song_parse(char * p, seq_event_t * dest, uint16_t room)
+{
+	int16_t n = 0;
+	
+	while(1)
+	{
+		uint8_t field[4];
+		
+		while(*p == ' ' || *p == ',')
+		{
+			p++;
+		}
+		
+		if(!*p)
+		{
+			return n;
+		}
+		
+		for(uint8_t k = 0; k < 4; k++)
+		{
+			char * end;
+			unsigned long v = strtoul(p, &end, 10);
+			
+			if(end == p || v > 255)
+			{
+				return -1;
+			}
+			
+			field[k] = (uint8_t)v;
+			p = end;
+			
+			while(*p == ' ' || *p == ',')
+			{
+				p++;
+			}
+		}
+		
+		if((uint16_t)n >= room)
+		{
+			return -1;
+		}
+		
+		if(dest)
+		{
+			dest[n].note = field[0];
+			dest[n].level = field[1];
+			dest[n].length = field[2];
+			dest[n].rest = field[3];
+		}
+		
+		n++;
+	}
+}
+
+// "<bpm> events" replaces the song, "+ events" adds to it. the line is
+// checked whole before the song changes
+void song_upload(char * line)
+{
+	uint16_t start = 0;
+	char * p = line;
+	unsigned long bpm = 0;
+	
+	if(*p == '+')
+	{
+		start = song_len;
+		p++;
+	}
+	else
+	{
+		char * end;
+		
+		bpm = strtoul(p, &end, 10);
+		
+		if(end == p || bpm < SEQ_BPM_MIN || bpm > SEQ_BPM_MAX)
+		{
+			usartd0_out_string("?\r\n");
+			return;
+		}
+		
+		p = end;
+	}
+	
+	if(song_parse(p, NULL, SONG_EVENTS - start) < 0)
+	{
+		usartd0_out_string("?\r\n");
+		return;
+	}
+	
+	// the sequencer reads the song from its interrupt
+	cli();
+	seq_stop(&seq, &synth);
+	sei();
+	
+	song_len = start + song_parse(p, song + start, SONG_EVENTS - start);
+	
+	if(bpm)
+	{
+		tempo_set((uint16_t)bpm);
+	}
+	
+	reply_events(song_len);
+}
+
+// "ok <n>"
+void reply_events(uint16_t n)
+{
+	char buf[12];
+	uint8_t i = sizeof(buf);
+	
+	buf[--i] = '\0';
+	buf[--i] = '\n';
+	buf[--i] = '\r';
+	
+	do
+	{
+		buf[--i] = '0' + n % 10;
+		n /= 10;
+	} while(n);
+	
+	usartd0_out_string("ok ");
+	usartd0_out_string(&buf[i]);
+}
+
+// renders block n again once its channel is done with it. the channel
+// waits for the other one to finish, so it can take a new length here
+// without stopping the dma
+void block_refill(uint8_t n)
+{
+	DMA_CH_t * ch = n ? &DMA.CH1 : &DMA.CH0;
+	uint8_t len = block_len_next;
+	
+	if(len != block_len[n])
+	{
+		block_len[n] = len;
+		ch->TRFCNT = len * sizeof(synth_block[0][0]);
+	}
+	
+	synth_render(&synth, synth_block[n], len);
 }
 
-void usartd0_out_char(char c)
+// one sequencer tick
+ISR(TCC0_CCA_vect)
 {
-	while(!(USARTD0.STATUS & USART_DREIF_bm));
-	USARTD0.DATA = c;
+	TCC0.CCA += tick_period;
+	
+	seq_tick(&seq, &synth);
 }
 
-void usartd0_out_string(const char * str)
+// block 0 played, dma goes on with block 1: render block 0 again
+ISR(DMA_CH0_vect)
 {
-	while(*str) usartd0_out_char(*(str++));
+	DMA.CH0.CTRLB = DMA_CH_TRNIF_bm | DMA_CH_TRNINTLVL_LO_gc;
+	
+	block_refill(0);
 }
 
-ISR(USARTD0_RXC_vect)
+// block 1 played, dma goes on with block 0
+ISR(DMA_CH1_vect)
 {
-	dataflag = 1;
-	data = USARTD0.DATA;
-	usartd0_out_char(data);
+	DMA.CH1.CTRLB = DMA_CH_TRNIF_bm | DMA_CH_TRNINTLVL_LO_gc;
+	
+	block_refill(1);
 }
@@ -0,0 +1,204 @@
+/*------------------------------------------------------------------------------
+  adc_enob.c --
+
+  Description:
+    Runs the ADC app's oversample-and-decimate stage (`decimate.c`) on a
+    Linux host and measures the effective number of bits it delivers.
+
+      Synthetic conversions are a DC level plus Gaussian noise, rounded
+    and clipped to the signed 12-bit range the ADC produces. For every
+    decimation (0 to DECIMATE_BITS_MAX extra bits) and filter, many random
+    levels are run through a fresh decimator and each output is compared
+    with the true level, skipping the first outputs while the filter
+    settles. The RMS error e, in LSBs of the 12-bit ADC, gives
+
+      ENOB = 12 - log2(e * sqrt(12))
+
+    i.e. the resolution of an ideal quantizer with the same error. The
+    exit status is non-zero unless, for each filter, n extra bits of
+    decimation gain at least 0.8 n bits over no decimation, as long as the
+    noise is large enough to dither (-s of 0.5 LSB or more; with less the
+    gain stalls, which is what the table then shows).
+
+    Build (from this directory):
+      cc -O2 -std=c99 -I../../IMU_SPI_USART ../../IMU_SPI_USART/decimate.c adc_enob.c -o adc_enob -lm
+
+    Usage:
+      adc_enob [-s noise_lsb] [-n levels] [-r seed]
+
+      Defaults: 0.7 LSB noise (RMS), 200 levels.
+
+------------------------------------------------------------------------------*/
+
+/********************************DEPENDENCIES**********************************/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "decimate.h"
+
+/*****************************END OF DEPENDENCIES******************************/
+
+
+/***********************************MACROS*************************************/
+
+/* Outputs compared per level, after the filter has settled. */
+#define ENOB_OUTPUTS        64
+
+/* Outputs skipped first; covers the CIC and moving average responses. */
+#define ENOB_SETTLE         DECIMATE_MAVG_LEN
+
+#define ENOB_MIN_GAIN       0.8
+
+/********************************END OF MACROS*********************************/
+
+
+/*****************************FUNCTION DEFINITIONS*****************************/
+
+static uint64_t rng_state = 0x9E3779B97F4A7C15ULL;
+
+/* xorshift64*, uniform in (0, 1). */
+static double rng_uniform(void)
+{
+  rng_state ^= rng_state >> 12;
+  rng_state ^= rng_state << 25;
+  rng_state ^= rng_state >> 27;
+
+  return ((rng_state * 2685821657736338717ULL) >> 11) * (1.0 / 9007199254740992.0) + 1e-300;
+}
+
+static double rng_gauss(void)
+{
+  return sqrt(-2.0 * log(rng_uniform())) * cos(6.283185307179586 * rng_uniform());
+}
+
+/* One conversion of `level` (in LSBs) with `noise` LSB RMS of noise. */
+static int16_t convert(double level, double noise)
+{
+  double v = floor(level + noise * rng_gauss() + 0.5);
+
+  if(v > 2047)
+  {
+    v = 2047;
+  }
+
+  if(v < -2048)
+  {
+    v = -2048;
+  }
+
+  return (int16_t)v;
+}
+
+/* ENOB of a decimator setting over `levels` random DC levels. */
+static double enob(uint8_t bits, uint8_t filter, double noise, int levels)
+{
+  double sq = 0;
+  long n = 0;
+
+  for(int l = 0; l < levels; l++)
+  {
+    // away from the rails, where clipping would bias the mean
+    double level = (rng_uniform() - 0.5) * 3800;
+    decimate_t dec;
+    int outputs = 0;
+
+    decimate_init(&dec, bits, filter);
+
+    while(outputs < ENOB_SETTLE + ENOB_OUTPUTS)
+    {
+      int16_t y;
+
+      if(!decimate_push(&dec, convert(level, noise), &y))
+      {
+        continue;
+      }
+
+      if(outputs++ >= ENOB_SETTLE)
+      {
+        double e = y / 16.0 - level;
+
+        sq += e * e;
+        n++;
+      }
+    }
+  }
+
+  return 12 - log2(sqrt(sq / n) * sqrt(12));
+}
+
+int main(int argc, char ** argv)
+{
+  static const char * const names[] = {"boxcar", "cic2", "mavg"};
+  double noise = 0.7;
+  int levels = 200;
+  int ok = 1;
+
+  for(int i = 1; i < argc; i++)
+  {
+    if(!strcmp(argv[i], "-s") && i + 1 < argc)
+    {
+      noise = atof(argv[++i]);
+    }
+    else if(!strcmp(argv[i], "-n") && i + 1 < argc)
+    {
+      levels = atoi(argv[++i]);
+    }
+    else if(!strcmp(argv[i], "-r") && i + 1 < argc)
+    {
+      rng_state = strtoull(argv[++i], NULL, 0) | 1;
+    }
+    else
+    {
+      fprintf(stderr, "usage: adc_enob [-s noise_lsb] [-n levels] [-r seed]\n");
+      return 2;
+    }
+  }
+
+  if(levels < 1)
+  {
+    levels = 1;
+  }
+
+  printf("noise %.2f LSB RMS, %d levels\n", noise, levels);
+  printf("bits  conversions");
+
+  for(int f = 0; f < 3; f++)
+  {
+    printf("  %8s", names[f]);
+  }
+
+  printf("\n");
+
+  double first[3] = {0};
+
+  for(uint8_t bits = 0; bits <= DECIMATE_BITS_MAX; bits++)
+  {
+    printf("%4u  %11u", bits, 1u << (2 * bits));
+
+    for(uint8_t f = 0; f < 3; f++)
+    {
+      double e = enob(bits, f, noise, levels);
+
+      printf("  %8.2f", e);
+
+      if(!bits)
+      {
+        first[f] = e;
+      }
+      else if(noise >= 0.5 && e - first[f] < ENOB_MIN_GAIN * bits)
+      {
+        ok = 0;
+      }
+    }
+
+    printf("\n");
+  }
+
+  printf("%s\n", ok ? "ok" : "FAIL: decimation did not gain the expected resolution");
+
+  return ok ? 0 : 1;
+}
+
+/***************************END OF FUNCTION DEFINITIONS************************/
@@ -0,0 +1,427 @@
+/*------------------------------------------------------------------------------
+  attitude_bench.c --
+
+  Description:
+    Runs the gyro app's fixed-point attitude filter (`attitude.c`) on a
+    Linux host against a double-precision reference, then times it.
+
+      The reference is the same complementary filter in doubles: body
+    rates integrated every sample, roll and pitch pulled 2^-ATT_ACCEL_SHIFT
+    of the way towards libm's atan2 of the gravity vector every
+    ATT_ACCEL_DECIM samples, accelerometer samples off 1 g by more than
+    0.25 g skipped. Both are fed the same int16 samples, synthesized from
+    a known motion with sensor noise at the app's ranges (125 dps,
+    +/-2 g): a held tilt from level, a slow wobble about all three axes,
+    a spin that wraps yaw several times, and shaking that the accelerometer
+    gate has to reject. Every scenario runs at both of the app's rates,
+    1666 Hz (FIFO build) and 208 Hz (one interrupt per sample).
+
+      For each scenario the largest and RMS difference between the two
+    filters is printed per axis, and, for information, the reference's own
+    largest roll or pitch error from the true motion after the first 8 s.
+    Both filters start level and settle with a time constant of
+    ATT_ACCEL_DECIM << ATT_ACCEL_SHIFT samples, about 1.2 s at 1666 Hz but
+    9.8 s at 208 Hz, so at 208 Hz that error is mostly the start still
+    settling. The exit status is non-zero unless every difference stays
+    within ATT_TOL_DEG.
+
+      `attitude_update` is then timed over a recorded sample stream and
+    reported in ns and host cycles (where the cycle counter can be read)
+    per update, averaged over the ATT_ACCEL_DECIM updates between
+    corrections, and separately for the gyro-only and correcting updates.
+    Host timings say nothing about the AVR's cycles; they compare builds.
+
+    Build (from this directory):
+      cc -O2 -std=c99 -I../../IMU_SPI_USART ../../IMU_SPI_USART/attitude.c attitude_bench.c -o attitude_bench -lm
+
+    Usage:
+      attitude_bench
+
+------------------------------------------------------------------------------*/
+
+/********************************DEPENDENCIES**********************************/
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "attitude.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define ATT_TSC         1
+#include <x86intrin.h>
+#endif
+
+/*****************************END OF DEPENDENCIES******************************/
+
+
+/***********************************MACROS*************************************/
+
+/* The app's ranges (Gyroscope_Pitch_Yaw_Roll.c): 125 dps full scale is
+ * 4.375 mdps/LSB, +/-2 g full scale is 0.061 mg/LSB. */
+#define GYRO_UDPS_PER_LSB  4375
+#define ACCEL_ONE_G        16393
+
+/* Sensor noise, rms LSB: about 0.2 dps and 3 mg. */
+#define GYRO_NOISE         45.0
+#define ACCEL_NOISE        50.0
+
+/* Largest difference from the reference allowed, degrees. */
+#define ATT_TOL_DEG        0.25
+
+/* Seconds per scenario. */
+#define ATT_SECONDS        20.0
+
+/* Updates per timing pass. */
+#define BENCH_UPDATES      (ATT_ACCEL_DECIM * 250000)
+
+#ifndef M_PI
+#define M_PI               3.14159265358979323846
+#endif
+
+/********************************END OF MACROS*********************************/
+
+
+/*******************************CUSTOM DATA TYPES******************************/
+
+/* The double-precision reference filter, angles in degrees. */
+typedef struct ref
+{
+  double rpy[3];
+  double dps_per_lsb, odr;
+  double g_sq_min, g_sq_max;
+  int decim;
+}ref_t;
+
+/* True roll, pitch, yaw in degrees at time `t`, and linear acceleration in
+ * g added to gravity (body frame). */
+typedef void (*motion_fn)(double t, double * rpy, double * lin);
+
+typedef struct scenario
+{
+  const char * name;
+  motion_fn motion;
+}scenario_t;
+
+/***************************END OF CUSTOM DATA TYPES***************************/
+
+
+/******************************GLOBAL VARIABLES********************************/
+
+static uint32_t att_rand_state = 12345;
+
+/* Keeps the timed updates from being optimized away. */
+static volatile int16_t att_sink;
+
+/***************************END OF GLOBAL VARIABLES****************************/
+
+
+/*****************************FUNCTION DEFINITIONS*****************************/
+
+static double now_s(void)
+{
+  struct timespec t;
+
+  clock_gettime(CLOCK_MONOTONIC, &t);
+
+  return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+static uint64_t now_cycles(void)
+{
+#ifdef ATT_TSC
+  return __rdtsc();
+#else
+  return 0;
+#endif
+}
+
+/* Roughly normal noise with unit variance, from the sum of 12 uniforms. */
+static double noise(void)
+{
+  double sum = -6.0;
+
+  for(int i = 0; i < 12; i++)
+  {
+    att_rand_state = att_rand_state * 1664525u + 1013904223u;
+    sum += (att_rand_state >> 8) / 16777216.0;
+  }
+
+  return sum;
+}
+
+static int16_t clamp16(double v)
+{
+  v = floor(v + 0.5);
+
+  return (int16_t)(v > 32767 ? 32767 : v < -32768 ? -32768 : v);
+}
+
+/* Wraps an angle difference to -180..180 degrees. */
+static double wrap_deg(double a)
+{
+  return a - 360.0 * floor((a + 180.0) / 360.0);
+}
+
+static void motion_tilt(double t, double * rpy, double * lin)
+{
+  // level for a second, then rolled and pitched, held
+  double k = (t < 1.0) ? 0.0 : (t < 2.0) ? t - 1.0 : 1.0;
+
+  rpy[0] = 30.0 * k;
+  rpy[1] = -20.0 * k;
+  rpy[2] = 45.0 * k;
+  lin[0] = lin[1] = lin[2] = 0.0;
+}
+
+static void motion_wobble(double t, double * rpy, double * lin)
+{
+  rpy[0] = 25.0 * sin(2 * M_PI * 0.3 * t);
+  rpy[1] = 15.0 * sin(2 * M_PI * 0.45 * t + 1.0);
+  rpy[2] = 60.0 * sin(2 * M_PI * 0.2 * t + 2.0);
+  lin[0] = lin[1] = lin[2] = 0.0;
+}
+
+static void motion_spin(double t, double * rpy, double * lin)
+{
+  // 100 dps about z, past +/-180 every few seconds, slightly tilted
+  rpy[0] = 5.0;
+  rpy[1] = -5.0;
+  rpy[2] = 100.0 * t;
+  lin[0] = lin[1] = lin[2] = 0.0;
+}
+
+static void motion_shake(double t, double * rpy, double * lin)
+{
+  // tilted and still, but shaken hard in bursts: those samples are off
+  // 1 g and must not drag roll and pitch
+  double burst = (fmod(t, 4.0) < 1.0) ? 1.0 : 0.0;
+
+  rpy[0] = -10.0;
+  rpy[1] = 20.0;
+  rpy[2] = 0.0;
+  lin[0] = burst * 0.9 * sin(2 * M_PI * 7.0 * t);
+  lin[1] = burst * 0.9 * cos(2 * M_PI * 5.0 * t);
+  lin[2] = burst * 0.6 * sin(2 * M_PI * 3.0 * t);
+}
+
+/* Synthesizes the samples of `motion` at time `t`: the filter's small-angle
+ * model, Euler rates as body rates, and gravity rotated into the body. */
+static void sample(motion_fn motion, double t, double odr, int16_t * gyro, int16_t * accel)
+{
+  double a[3], b[3], lin[3];
+  double dt = 1.0 / odr;
+
+  motion(t - dt, a, lin);
+  motion(t, b, lin);
+
+  for(int i = 0; i < 3; i++)
+  {
+    double dps = (b[i] - a[i]) / dt;
+
+    gyro[i] = clamp16(dps * 1e6 / GYRO_UDPS_PER_LSB + GYRO_NOISE * noise());
+  }
+
+  double r = b[0] * M_PI / 180, p = b[1] * M_PI / 180;
+
+  accel[0] = clamp16((-sin(p) + lin[0]) * ACCEL_ONE_G + ACCEL_NOISE * noise());
+  accel[1] = clamp16((cos(p) * sin(r) + lin[1]) * ACCEL_ONE_G + ACCEL_NOISE * noise());
+  accel[2] = clamp16((cos(p) * cos(r) + lin[2]) * ACCEL_ONE_G + ACCEL_NOISE * noise());
+}
+
+static void ref_init(ref_t * ref, double odr)
+{
+  double g_sq = (double)ACCEL_ONE_G * ACCEL_ONE_G;
+
+  ref->rpy[0] = ref->rpy[1] = ref->rpy[2] = 0.0;
+  ref->dps_per_lsb = GYRO_UDPS_PER_LSB * 1e-6;
+  ref->odr = odr;
+  ref->g_sq_min = 0.75 * 0.75 * g_sq;
+  ref->g_sq_max = 1.25 * 1.25 * g_sq;
+  ref->decim = 0;
+}
+
+static void ref_update(ref_t * ref, const int16_t * gyro, const int16_t * accel)
+{
+  for(int i = 0; i < 3; i++)
+  {
+    ref->rpy[i] = wrap_deg(ref->rpy[i] + gyro[i] * ref->dps_per_lsb / ref->odr);
+  }
+
+  if(++ref->decim < ATT_ACCEL_DECIM)
+  {
+    return;
+  }
+
+  ref->decim = 0;
+
+  double ax = accel[0], ay = accel[1], az = accel[2];
+  double g_sq = ax * ax + ay * ay + az * az;
+
+  if(g_sq < ref->g_sq_min || g_sq > ref->g_sq_max)
+  {
+    return;
+  }
+
+  double target[2] =
+  {
+    atan2(ay, az) * 180 / M_PI,
+    atan2(-ax, sqrt(ay * ay + az * az)) * 180 / M_PI
+  };
+
+  for(int i = 0; i < 2; i++)
+  {
+    ref->rpy[i] = wrap_deg(ref->rpy[i] + wrap_deg(target[i] - ref->rpy[i]) / (1 << ATT_ACCEL_SHIFT));
+  }
+}
+
+/* Runs `sc` through both filters at `odr`, prints the differences and
+ * returns whether they are all within ATT_TOL_DEG. */
+static int check(const scenario_t * sc, int odr)
+{
+  attitude_t att;
+  ref_t ref;
+  double max_diff[3] = {0, 0, 0}, sum_sq[3] = {0, 0, 0}, max_truth = 0;
+  long n = (long)(ATT_SECONDS * odr);
+
+  attitude_init(&att, ATT_GYRO_K(GYRO_UDPS_PER_LSB, odr), ACCEL_ONE_G);
+  ref_init(&ref, odr);
+  att_rand_state = 12345;
+
+  for(long k = 1; k <= n; k++)
+  {
+    double t = (double)k / odr;
+    int16_t gyro[3], accel[3], rpy[3];
+    double truth[3], lin[3];
+
+    sample(sc->motion, t, odr, gyro, accel);
+
+    attitude_update(&att, gyro, accel);
+    ref_update(&ref, gyro, accel);
+
+    attitude_get(&att, rpy);
+
+    for(int i = 0; i < 3; i++)
+    {
+      double d = fabs(wrap_deg(rpy[i] * (360.0 / 65536) - ref.rpy[i]));
+
+      max_diff[i] = (d > max_diff[i]) ? d : max_diff[i];
+      sum_sq[i] += d * d;
+    }
+
+    // the reference against the true roll and pitch, past the start
+    sc->motion(t, truth, lin);
+
+    for(int i = 0; i < 2 && t > 8.0; i++)
+    {
+      double d = fabs(wrap_deg(ref.rpy[i] - truth[i]));
+
+      max_truth = (d > max_truth) ? d : max_truth;
+    }
+  }
+
+  int ok = max_diff[0] <= ATT_TOL_DEG && max_diff[1] <= ATT_TOL_DEG && max_diff[2] <= ATT_TOL_DEG;
+
+  printf("%-7s %5d  %6.3f %6.3f %6.3f  %6.3f %6.3f %6.3f  %9.2f  %s\n", sc->name, odr,
+         max_diff[0], max_diff[1], max_diff[2], sqrt(sum_sq[0] / n), sqrt(sum_sq[1] / n),
+         sqrt(sum_sq[2] / n), max_truth, ok ? "ok" : "OFF");
+
+  return ok;
+}
+
+/* Times `attitude_update` over a recorded stream, per update. With `only`
+ * at 0 every update is timed, otherwise only those of that kind (1 gyro
+ * only, 2 correcting): the filter's decimation is preset so each timed
+ * update is of that kind. */
+static void bench(int only, double * ns, double * cycles)
+{
+  enum { STREAM = 4096 };
+  static int16_t gyro[STREAM][3], accel[STREAM][3];
+  attitude_t att;
+  double best_ns = 1e30, best_cyc = 1e30;
+
+  att_rand_state = 12345;
+
+  for(int k = 0; k < STREAM; k++)
+  {
+    sample(motion_wobble, (k + 1) / 1666.0, 1666.0, gyro[k], accel[k]);
+  }
+
+  attitude_init(&att, ATT_GYRO_K(GYRO_UDPS_PER_LSB, 1666), ACCEL_ONE_G);
+
+  for(int pass = 0; pass < 3; pass++)
+  {
+    double t = now_s();
+    uint64_t c = now_cycles();
+
+    for(long k = 0; k < BENCH_UPDATES; k++)
+    {
+      if(only)
+      {
+        att.decim = (only == 2) ? ATT_ACCEL_DECIM - 1 : 0;
+      }
+
+      attitude_update(&att, gyro[k & (STREAM - 1)], accel[k & (STREAM - 1)]);
+      att_sink = (int16_t)(att.roll >> 16);
+    }
+
+    c = now_cycles() - c;
+    t = now_s() - t;
+
+    if(t < best_ns)
+    {
+      best_ns = t;
+      best_cyc = (double)c;
+    }
+  }
+
+  *ns = best_ns * 1e9 / BENCH_UPDATES;
+  *cycles = best_cyc / BENCH_UPDATES;
+}
+
+int main(void)
+{
+  static const scenario_t scenarios[] =
+  {
+    {"tilt", motion_tilt},
+    {"wobble", motion_wobble},
+    {"spin", motion_spin},
+    {"shake", motion_shake}
+  };
+  static const int rates[] = {1666, 208};
+  int ok = 1;
+
+  printf("fixed point against double reference, degrees (tolerance %.2f)\n", ATT_TOL_DEG);
+  printf("motion    odr  max roll  pitch    yaw  rms roll  pitch    yaw  ref-truth\n");
+
+  for(unsigned s = 0; s < sizeof(scenarios) / sizeof(scenarios[0]); s++)
+  {
+    for(unsigned r = 0; r < sizeof(rates) / sizeof(rates[0]); r++)
+    {
+      ok &= check(&scenarios[s], rates[r]);
+    }
+  }
+
+  printf("update      ns/update  cycles/update\n");
+
+  static const char * const kinds[] = {"average", "gyro only", "correcting"};
+
+  for(int kind = 0; kind < 3; kind++)
+  {
+    double ns, cyc;
+
+    bench(kind, &ns, &cyc);
+
+#ifdef ATT_TSC
+    printf("%-10s  %9.2f  %13.1f\n", kinds[kind], ns, cyc);
+#else
+    printf("%-10s  %9.2f  %13s\n", kinds[kind], ns, "-");
+#endif
+  }
+
+  return ok ? 0 : 1;
+}
+
+/***************************END OF FUNCTION DEFINITIONS************************/
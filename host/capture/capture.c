@@ -0,0 +1,529 @@
+/*------------------------------------------------------------------------------
+  capture.c --
+
+  Description:
+    Capture decoding and staging. See `capture.h`.
+
+------------------------------------------------------------------------------*/
+
+/********************************DEPENDENCIES**********************************/
+
+#define _DEFAULT_SOURCE
+
+#include <fcntl.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "capture.h"
+#include "frame_decode.h"
+
+/*****************************END OF DEPENDENCIES******************************/
+
+
+/***********************************MACROS*************************************/
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "payloads are staged with memcpy and need a little-endian host"
+#endif
+
+/* ADC channels of an ADC_RANGED record; each row is staged as the results
+ * of all of them, then their log2 gains. */
+#define CAPTURE_RANGED_CHANNELS 4
+
+/********************************END OF MACROS*********************************/
+
+
+/*****************************FUNCTION DEFINITIONS*****************************/
+
+void capture_scale_init(capture_scale_t * scale, uint8_t ctrl1_xl)
+{
+  // FS_XL: 00 = 2 g, 01 = 16 g, 10 = 4 g, 11 = 8 g (0.061 mg/LSB at 2 g)
+  static const float accel_mg[4] = {0.061f, 0.488f, 0.122f, 0.244f};
+
+  scale->adc_volts = 2.5f / (2048.0f * 16.0f);
+  scale->accel_g = accel_mg[(ctrl1_xl >> 2) & 3] / 1000.0f;
+  scale->angle_deg = 360.0f / 65536.0f;
+  scale->tick_s = 25e-6;
+}
+
+static void capture_stream_setup(capture_stream_t * s, uint8_t type, const char * name,
+                                 unsigned stride, unsigned ncols, const char * c0,
+                                 const char * c1, const char * c2, const char * c3)
+{
+  s->type = type;
+  s->name = name;
+  s->stride = stride;
+  s->ncols = ncols;
+  s->col_names[0] = c0;
+  s->col_names[1] = c1;
+  s->col_names[2] = c2;
+  s->col_names[3] = c3;
+}
+
+void capture_init(capture_t * cap, const capture_scale_t * scale)
+{
+  memset(cap, 0, sizeof(*cap));
+
+  cap->scale = *scale;
+
+  capture_stream_setup(&cap->streams[0], FRAME_TYPE_ADC_SAMPLE, "adc", 1, 1,
+                       "volts", NULL, NULL, NULL);
+  capture_stream_setup(&cap->streams[1], FRAME_TYPE_ACCEL, "accel", 3, 3,
+                       "x_g", "y_g", "z_g", NULL);
+  capture_stream_setup(&cap->streams[2], FRAME_TYPE_ACCEL_TS, "accel_ts", 4, 4,
+                       "x_g", "y_g", "z_g", "t_s");
+  capture_stream_setup(&cap->streams[3], FRAME_TYPE_ATTITUDE, "attitude", 3, 3,
+                       "roll_deg", "pitch_deg", "yaw_deg", NULL);
+  capture_stream_setup(&cap->streams[4], FRAME_TYPE_ADC_SWEEP, "adc_sweep", 4, 4,
+                       "ch0_volts", "ch1_volts", "ch2_volts", "ch3_volts");
+  capture_stream_setup(&cap->streams[5], FRAME_TYPE_ADC_RANGED, "adc_ranged",
+                       2 * CAPTURE_RANGED_CHANNELS, CAPTURE_RANGED_CHANNELS,
+                       "ch0_volts", "ch1_volts", "ch2_volts", "ch3_volts");
+  capture_stream_setup(&cap->streams[6], FRAME_TYPE_ATTITUDE_TS, "attitude_ts", 4, 4,
+                       "roll_deg", "pitch_deg", "yaw_deg", "t_s");
+}
+
+void capture_free(capture_t * cap)
+{
+  for(int i = 0; i < CAPTURE_STREAMS; i++)
+  {
+    free(cap->streams[i].raw);
+
+    for(int c = 0; c < CAPTURE_COLS_MAX; c++)
+    {
+      free(cap->streams[i].cols[c]);
+    }
+  }
+
+  memset(cap->streams, 0, sizeof(cap->streams));
+}
+
+static capture_stream_t * capture_stream_of(capture_t * cap, uint8_t type)
+{
+  for(int i = 0; i < CAPTURE_STREAMS; i++)
+  {
+    if(cap->streams[i].type == type)
+    {
+      return &cap->streams[i];
+    }
+  }
+
+  return NULL;
+}
+
+/* memcpy, but inline for the few bytes of most records, where the call
+ * costs more than the copy. */
+static inline void capture_copy(uint8_t * dst, const uint8_t * src, size_t n)
+{
+  if(n < 32)
+  {
+    while(n--)
+    {
+      *dst++ = *src++;
+    }
+  }
+  else
+  {
+    memcpy(dst, src, n);
+  }
+}
+
+/* Appends `rows` records of raw payload to the staging array of `s`. */
+static void capture_stage(capture_stream_t * s, const uint8_t * payload, size_t rows)
+{
+  if(s->raw_rows + rows > s->raw_cap)
+  {
+    size_t cap = s->raw_cap ? s->raw_cap : 4096;
+
+    while(cap < s->raw_rows + rows)
+    {
+      cap *= 2;
+    }
+
+    s->raw = realloc(s->raw, cap * s->stride * sizeof(int16_t));
+    s->raw_cap = cap;
+  }
+
+  capture_copy((uint8_t *)(s->raw + s->raw_rows * s->stride), payload,
+               rows * s->stride * sizeof(int16_t));
+  s->raw_rows += rows;
+}
+
+/* Stages an ADC_RANGED payload: first channel, channel count, a log2 gain
+ * per channel, padded to even, then rows of results. Every row is staged
+ * with the results and gains of all channels; channels not sent get a
+ * gain of -1. */
+static void capture_ranged(capture_t * cap, capture_stream_t * s, const uint8_t * p, size_t len)
+{
+  unsigned first, count;
+  size_t head, rows;
+
+  if(len < 2)
+  {
+    cap->bad_len++;
+    return;
+  }
+
+  first = p[0];
+  count = p[1];
+  head = (2 + count + 1) & ~(size_t)1;
+
+  if(!count || first + count > CAPTURE_RANGED_CHANNELS || len <= head ||
+     (len - head) % (count * 2))
+  {
+    cap->bad_len++;
+    return;
+  }
+
+  rows = (len - head) / (count * 2);
+
+  for(size_t r = 0; r < rows; r++)
+  {
+    int16_t rec[2 * CAPTURE_RANGED_CHANNELS];
+
+    for(unsigned c = 0; c < CAPTURE_RANGED_CHANNELS; c++)
+    {
+      rec[c] = 0;
+      rec[CAPTURE_RANGED_CHANNELS + c] = -1;
+    }
+
+    for(unsigned i = 0; i < count; i++)
+    {
+      memcpy(&rec[first + i], p + head + 2 * (r * count + i), sizeof(int16_t));
+      rec[CAPTURE_RANGED_CHANNELS + first + i] = p[2 + i] & 7;
+    }
+
+    capture_stage(s, (const uint8_t *)rec, 1);
+  }
+}
+
+/* Checks and stages one decoded frame (type, seq, payload, crc). */
+static void capture_frame(capture_t * cap, const uint8_t * raw, size_t n)
+{
+  if(n < 4)
+  {
+    cap->bad_cobs++;
+    return;
+  }
+
+  uint16_t crc = (uint16_t)(raw[n - 2] | (raw[n - 1] << 8));
+
+  if(frame_crc16(raw, n - 2) != crc)
+  {
+    cap->bad_crc++;
+    return;
+  }
+
+  if(cap->have_seq)
+  {
+    cap->lost += (uint8_t)(raw[1] - cap->next_seq);
+  }
+
+  cap->have_seq = 1;
+  cap->next_seq = (uint8_t)(raw[1] + 1);
+  cap->frames++;
+
+  capture_stream_t * s = capture_stream_of(cap, raw[0]);
+  size_t plen = n - 4;
+
+  if(raw[0] == FRAME_TYPE_ADC_LOST && plen >= 4)
+  {
+    cap->adc_lost += (uint64_t)(raw[2] | (raw[3] << 8)) * (uint16_t)(raw[4] | (raw[5] << 8));
+  }
+  else if(!s)
+  {
+    cap->other++;
+  }
+  else if(s->type == FRAME_TYPE_ADC_RANGED)
+  {
+    capture_ranged(cap, s, raw + 2, plen);
+  }
+  else if(!plen || plen % (s->stride * 2))
+  {
+    cap->bad_len++;
+  }
+  else
+  {
+    capture_stage(s, raw + 2, plen / (s->stride * 2));
+  }
+}
+
+size_t capture_feed(capture_t * cap, const uint8_t * data, size_t len)
+{
+  uint8_t raw[FRAME_DECODE_MAX + 256];
+  const uint8_t * p = data;
+  const uint8_t * end = data + len;
+
+  if(!cap->synced)
+  {
+    const uint8_t * z = memchr(p, 0, len);
+
+    if(!z)
+    {
+      return 0;
+    }
+
+    cap->skipped += (uint64_t)(z - p);
+    cap->synced = 1;
+    p = z + 1;
+  }
+
+  // Each frame is decoded by following its COBS code bytes, which both
+  // copies the blocks out and finds the delimiter: a valid frame ends
+  // where a code byte would be. A zero inside a block is a delimiter too,
+  // ending a truncated frame. Frames still incomplete at `end` are left
+  // for the next call.
+  while(p < end)
+  {
+    const uint8_t * q = p;
+    size_t n = 0;
+    int bad = 0;
+
+    while(q < end && *q)
+    {
+      size_t run = *q - 1u;
+      const uint8_t * blk = q + 1;
+
+      if(run > (size_t)(end - blk))
+      {
+        run = (size_t)(end - blk);
+        bad = -1;                 // runs off the end, unless a zero comes first
+      }
+
+      if(n + run > FRAME_DECODE_MAX)
+      {
+        bad = 1;                  // too long: skip to the next delimiter
+        q = memchr(blk, 0, (size_t)(end - blk));
+        q = q ? q : end;
+        break;
+      }
+
+      size_t k = 0;
+
+      if(run < 32)
+      {
+        for(; k < run && blk[k]; k++)
+        {
+          raw[n + k] = blk[k];
+        }
+      }
+      else
+      {
+        const uint8_t * z = memchr(blk, 0, run);
+
+        k = z ? (size_t)(z - blk) : run;
+        memcpy(raw + n, blk, k);
+      }
+
+      n += k;
+
+      if(k < run || bad < 0)
+      {
+        q = blk + k;
+        bad = (k < run) ? 1 : bad;
+        break;
+      }
+
+      q = blk + run;
+
+      // every block but the last, and a full one, implies a zero
+      if(run < 0xFE && q < end && *q)
+      {
+        raw[n++] = 0;
+      }
+    }
+
+    if(q >= end)
+    {
+      break;                      // no delimiter yet
+    }
+
+    if(bad > 0)
+    {
+      cap->bad_cobs++;
+    }
+    else if(q > p)
+    {
+      capture_frame(cap, raw, n);
+    }
+
+    p = q + 1;
+  }
+
+  cap->bytes += (uint64_t)(p - data);
+
+  return (size_t)(p - data);
+}
+
+static void capture_stream_convert(capture_stream_t * s, const capture_scale_t * scale)
+{
+  size_t n = s->raw_rows;
+
+  if(!n)
+  {
+    return;
+  }
+
+  if(s->rows + n > s->cols_cap)
+  {
+    size_t cap = s->cols_cap ? s->cols_cap : 4096;
+
+    while(cap < s->rows + n)
+    {
+      cap *= 2;
+    }
+
+    for(unsigned c = 0; c < s->ncols; c++)
+    {
+      s->cols[c] = realloc(s->cols[c], cap * sizeof(float));
+    }
+
+    s->cols_cap = cap;
+  }
+
+  float ** out = s->cols;
+  size_t r = s->rows;
+
+  switch(s->type)
+  {
+    case FRAME_TYPE_ADC_SAMPLE:
+      capture_i16_to_f32(s->raw, n, scale->adc_volts, out[0] + r);
+      break;
+
+    case FRAME_TYPE_ACCEL:
+      capture_i16x3_to_f32(s->raw, n, scale->accel_g, out[0] + r, out[1] + r, out[2] + r);
+      break;
+
+    case FRAME_TYPE_ATTITUDE:
+      capture_i16x3_to_f32(s->raw, n, scale->angle_deg, out[0] + r, out[1] + r, out[2] + r);
+      break;
+
+    case FRAME_TYPE_ADC_SWEEP:
+      for(unsigned c = 0; c < 4; c++)
+      {
+        for(size_t i = 0; i < n; i++)
+        {
+          out[c][r + i] = s->raw[4 * i + c] * scale->adc_volts;
+        }
+      }
+      break;
+
+    case FRAME_TYPE_ADC_RANGED:
+      // results in 1/16 LSB of the input amplified by 2^gain, divided back
+      // down to the input; NaN where a channel was not sent
+      for(unsigned c = 0; c < CAPTURE_RANGED_CHANNELS; c++)
+      {
+        for(size_t i = 0; i < n; i++)
+        {
+          const int16_t * rec = s->raw + 2 * CAPTURE_RANGED_CHANNELS * i;
+          int16_t gain = rec[CAPTURE_RANGED_CHANNELS + c];
+
+          out[c][r + i] = (gain < 0) ? NAN : rec[c] * scale->adc_volts / (float)(1 << gain);
+        }
+      }
+      break;
+
+    case FRAME_TYPE_ACCEL_TS:
+      // x, y, z, dt records: the running sum of dt is inherently serial
+      for(size_t i = 0; i < n; i++)
+      {
+        const int16_t * rec = s->raw + 4 * i;
+
+        s->ticks += (uint16_t)rec[3];
+        out[0][r + i] = rec[0] * scale->accel_g;
+        out[1][r + i] = rec[1] * scale->accel_g;
+        out[2][r + i] = rec[2] * scale->accel_g;
+        out[3][r + i] = (float)(s->ticks * scale->tick_s);
+      }
+      break;
+
+    case FRAME_TYPE_ATTITUDE_TS:
+      // roll, pitch, yaw, dt records, as above
+      for(size_t i = 0; i < n; i++)
+      {
+        const int16_t * rec = s->raw + 4 * i;
+
+        s->ticks += (uint16_t)rec[3];
+        out[0][r + i] = rec[0] * scale->angle_deg;
+        out[1][r + i] = rec[1] * scale->angle_deg;
+        out[2][r + i] = rec[2] * scale->angle_deg;
+        out[3][r + i] = (float)(s->ticks * scale->tick_s);
+      }
+      break;
+  }
+
+  s->rows += n;
+  s->raw_rows = 0;
+}
+
+void capture_convert(capture_t * cap)
+{
+  for(int i = 0; i < CAPTURE_STREAMS; i++)
+  {
+    capture_stream_convert(&cap->streams[i], &cap->scale);
+  }
+}
+
+void capture_clear_rows(capture_t * cap)
+{
+  for(int i = 0; i < CAPTURE_STREAMS; i++)
+  {
+    cap->streams[i].rows = 0;
+  }
+}
+
+int capture_map(capture_file_t * file, const char * path)
+{
+  struct stat st;
+  int fd = open(path, O_RDONLY);
+
+  file->data = NULL;
+  file->len = 0;
+
+  if(fd < 0)
+  {
+    return -1;
+  }
+
+  if(fstat(fd, &st))
+  {
+    close(fd);
+    return -1;
+  }
+
+  if(st.st_size > 0)
+  {
+    void * m = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    if(m == MAP_FAILED)
+    {
+      close(fd);
+      return -1;
+    }
+
+    madvise(m, (size_t)st.st_size, MADV_SEQUENTIAL);
+
+    file->data = m;
+    file->len = (size_t)st.st_size;
+  }
+
+  close(fd);
+
+  return 0;
+}
+
+void capture_unmap(capture_file_t * file)
+{
+  if(file->data)
+  {
+    munmap((void *)file->data, file->len);
+  }
+
+  file->data = NULL;
+  file->len = 0;
+}
+
+/***************************END OF FUNCTION DEFINITIONS************************/
@@ -0,0 +1,166 @@
+#ifndef CAPTURE_H_    // Header guard.
+#define CAPTURE_H_
+
+/*------------------------------------------------------------------------------
+  capture.h --
+
+  Description:
+    Offline conversion of recorded app streams (see `IMU_SPI_USART/frame.h`)
+    to physical units, for captures too large to go through frame_dump.
+
+      Conversion runs in two passes. `capture_feed` walks the capture
+    frame by frame (the COBS code chain is followed to find each delimiter
+    while the blocks are copied out, slice-by-8 CRC) and appends each
+    payload's raw int16 values to a staging array per record type.
+    `capture_convert` then turns the staged values into float columns with
+    SIMD kernels (`capture_simd.c`): interleaved x, y, z triples are split
+    into three columns and scaled in one go.
+
+      Feeding a memory-mapped file in windows and converting and writing
+    out after each one keeps memory bounded for hours-long captures.
+
+    Units, with the scales the firmware uses:
+      ADC         volts, result * 2.5 / (2048 * 16) (1/16 LSB results)
+      ADC_SWEEP   volts as above, one column per ADC channel
+      ADC_RANGED  volts as above, after dividing each result by the 2^gain
+                  it is tagged with; NaN for channels a frame does not carry
+      ACCEL       g, from the full scale selected by CTRL1_XL
+      ACCEL_TS    g as above, plus time in seconds from the 25 us timestamp
+                  deltas
+      ATTITUDE    degrees, 65536 = 360
+      ATTITUDE_TS degrees as above, plus time in seconds as for ACCEL_TS
+
+    ADC_LOST frames add the sweeps the device dropped to `adc_lost`.
+    Event frames and unknown record types are counted and skipped.
+
+------------------------------------------------------------------------------*/
+
+/********************************DEPENDENCIES**********************************/
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*****************************END OF DEPENDENCIES******************************/
+
+
+/***********************************MACROS*************************************/
+
+/* Record types that are converted, in the order of `capture_t.streams`. */
+#define CAPTURE_STREAMS     7
+
+#define CAPTURE_COLS_MAX    4
+
+/* Power-on CTRL1_XL of the accelerometer app: +/-2 g. */
+#define CAPTURE_CTRL1_XL_DEFAULT    0x80
+
+/********************************END OF MACROS*********************************/
+
+
+/*******************************CUSTOM DATA TYPES******************************/
+
+typedef struct capture_scale
+{
+  float adc_volts;          // per ADC LSB
+  float accel_g;            // per accelerometer LSB
+  float angle_deg;          // per attitude LSB
+  double tick_s;            // per timestamp tick
+}capture_scale_t;
+
+/* One record type: staged raw values, then converted columns. */
+typedef struct capture_stream
+{
+  uint8_t type;
+  const char * name;
+  unsigned stride;          // int16 values per record in the payload
+  unsigned ncols;
+  const char * col_names[CAPTURE_COLS_MAX];
+
+  int16_t * raw;
+  size_t raw_rows, raw_cap;
+
+  float * cols[CAPTURE_COLS_MAX];
+  size_t rows, cols_cap;
+
+  uint64_t ticks;           // running timestamp, *_TS only
+}capture_stream_t;
+
+typedef struct capture
+{
+  capture_scale_t scale;
+  capture_stream_t streams[CAPTURE_STREAMS];
+
+  /* Statistics. */
+  uint64_t bytes;
+  uint64_t frames;
+  uint64_t lost;
+  uint64_t bad_crc;
+  uint64_t bad_cobs;
+  uint64_t bad_len;
+  uint64_t skipped;
+  uint64_t other;
+  uint64_t adc_lost;        // ADC sweeps dropped on the device
+
+  int synced;
+  int have_seq;
+  uint8_t next_seq;
+}capture_t;
+
+/* A read-only mapping of a capture file. */
+typedef struct capture_file
+{
+  const uint8_t * data;
+  size_t len;
+}capture_file_t;
+
+/***************************END OF CUSTOM DATA TYPES***************************/
+
+
+/*****************************FUNCTION PROTOTYPES******************************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Firmware scales; the accelerometer full scale is taken from `ctrl1_xl`. */
+void capture_scale_init(capture_scale_t * scale, uint8_t ctrl1_xl);
+
+void capture_init(capture_t * cap, const capture_scale_t * scale);
+
+void capture_free(capture_t * cap);
+
+/* Decodes the complete frames in `data` and stages their payloads. Returns
+ * the number of bytes used: up to and including the last delimiter, so
+ * the rest is fed again at the start of the next window. Bytes before the
+ * first delimiter of a capture are skipped as a partial frame. */
+size_t capture_feed(capture_t * cap, const uint8_t * data, size_t len);
+
+/* Converts everything staged into columns. */
+void capture_convert(capture_t * cap);
+
+/* Forgets converted rows, once they have been written out. */
+void capture_clear_rows(capture_t * cap);
+
+/* Maps `path` read-only. Returns 0, or -1 with errno set. */
+int capture_map(capture_file_t * file, const char * path);
+
+void capture_unmap(capture_file_t * file);
+
+/* SIMD kernels (capture_simd.c). `n` values, or `n` x, y, z triples. */
+void capture_i16_to_f32(const int16_t * in, size_t n, float scale, float * out);
+
+void capture_i16x3_to_f32(const int16_t * in, size_t n, float scale,
+                          float * x, float * y, float * z);
+
+/* Name of the kernel set in use; `capture_simd_disable` forces the scalar
+ * kernels, for comparison. */
+const char * capture_simd_name(void);
+
+void capture_simd_disable(int disable);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**************************END OF FUNCTION PROTOTYPES**************************/
+
+#endif // End of header guard.
@@ -0,0 +1,238 @@
+/*------------------------------------------------------------------------------
+  capture_conv.c --
+
+  Description:
+    Converts a recorded app stream to physical units (see `capture.h`),
+    one output per record type found:
+
+      bin  (default) one little-endian float32 file per column,
+           <prefix>.<stream>.<column>.f32, e.g. cap.accel.x_g.f32
+      csv  one file per record type, <prefix>.<stream>.csv, with a header
+
+    The capture is memory-mapped and converted in windows of `-w` MiB.
+    Frame statistics and the conversion rate are printed at the end.
+
+    Build (from this directory):
+      cc -O2 -std=c99 -I../frame ../frame/frame_decode.c capture.c capture_simd.c capture_conv.c -o capture_conv
+
+    Usage:
+      capture_conv [-f bin|csv] [-o prefix] [-x ctrl1_xl] [-w MiB] [-s] capture
+
+      -x is the CTRL1_XL value the accelerometer ran with (default 0x80,
+      +/-2 g); -s forces the scalar kernels.
+
+------------------------------------------------------------------------------*/
+
+/********************************DEPENDENCIES**********************************/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "capture.h"
+
+/*****************************END OF DEPENDENCIES******************************/
+
+
+/******************************GLOBAL VARIABLES********************************/
+
+/* Output files, opened when a record type first has rows. */
+static FILE * conv_out[CAPTURE_STREAMS][CAPTURE_COLS_MAX];
+
+/***************************END OF GLOBAL VARIABLES****************************/
+
+
+/*****************************FUNCTION DEFINITIONS*****************************/
+
+static FILE * conv_open(const char * prefix, const char * stream, const char * col,
+                        const char * ext)
+{
+  char path[4096];
+  FILE * f;
+
+  if(col)
+  {
+    snprintf(path, sizeof(path), "%s.%s.%s.%s", prefix, stream, col, ext);
+  }
+  else
+  {
+    snprintf(path, sizeof(path), "%s.%s.%s", prefix, stream, ext);
+  }
+
+  if(!(f = fopen(path, "wb")))
+  {
+    perror(path);
+    exit(1);
+  }
+
+  return f;
+}
+
+/* Writes out and forgets the converted rows. */
+static void conv_flush(capture_t * cap, const char * prefix, int csv)
+{
+  for(int i = 0; i < CAPTURE_STREAMS; i++)
+  {
+    capture_stream_t * s = &cap->streams[i];
+
+    if(!s->rows)
+    {
+      continue;
+    }
+
+    if(csv)
+    {
+      if(!conv_out[i][0])
+      {
+        conv_out[i][0] = conv_open(prefix, s->name, NULL, "csv");
+
+        for(unsigned c = 0; c < s->ncols; c++)
+        {
+          fprintf(conv_out[i][0], c ? ",%s" : "%s", s->col_names[c]);
+        }
+
+        fputc('\n', conv_out[i][0]);
+      }
+
+      for(size_t r = 0; r < s->rows; r++)
+      {
+        for(unsigned c = 0; c < s->ncols; c++)
+        {
+          fprintf(conv_out[i][0], c ? ",%.7g" : "%.7g", s->cols[c][r]);
+        }
+
+        fputc('\n', conv_out[i][0]);
+      }
+    }
+    else
+    {
+      for(unsigned c = 0; c < s->ncols; c++)
+      {
+        if(!conv_out[i][c])
+        {
+          conv_out[i][c] = conv_open(prefix, s->name, s->col_names[c], "f32");
+        }
+
+        fwrite(s->cols[c], sizeof(float), s->rows, conv_out[i][c]);
+      }
+    }
+  }
+
+  capture_clear_rows(cap);
+}
+
+static void usage(void)
+{
+  fprintf(stderr, "usage: capture_conv [-f bin|csv] [-o prefix] [-x ctrl1_xl] [-w MiB] [-s] capture\n");
+  exit(2);
+}
+
+int main(int argc, char ** argv)
+{
+  const char * prefix = NULL;
+  unsigned ctrl1_xl = CAPTURE_CTRL1_XL_DEFAULT;
+  size_t window = (size_t)64 << 20;
+  int csv = 0;
+  int opt;
+
+  while((opt = getopt(argc, argv, "f:o:x:w:s")) != -1)
+  {
+    switch(opt)
+    {
+      case 'f':
+        if(!strcmp(optarg, "csv")) csv = 1;
+        else if(strcmp(optarg, "bin")) usage();
+        break;
+      case 'o': prefix = optarg; break;
+      case 'x': ctrl1_xl = (unsigned)strtoul(optarg, NULL, 0); break;
+      case 'w': window = (size_t)atol(optarg) << 20; break;
+      case 's': capture_simd_disable(1); break;
+      default: usage();
+    }
+  }
+
+  if(optind != argc - 1 || !window)
+  {
+    usage();
+  }
+
+  const char * path = argv[optind];
+  capture_file_t file;
+  capture_scale_t scale;
+  capture_t cap;
+  struct timespec t0, t1;
+
+  if(capture_map(&file, path))
+  {
+    perror(path);
+    return 1;
+  }
+
+  if(!prefix)
+  {
+    prefix = path;
+  }
+
+  capture_scale_init(&scale, (uint8_t)ctrl1_xl);
+  capture_init(&cap, &scale);
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+
+  size_t pos = 0;
+
+  while(pos < file.len)
+  {
+    size_t len = file.len - pos < window ? file.len - pos : window;
+    size_t used = capture_feed(&cap, file.data + pos, len);
+
+    // no delimiter in a whole window: give up on the rest
+    if(!used)
+    {
+      break;
+    }
+
+    pos += used;
+    capture_convert(&cap);
+    conv_flush(&cap, prefix, csv);
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+
+  for(int i = 0; i < CAPTURE_STREAMS; i++)
+  {
+    for(int c = 0; c < CAPTURE_COLS_MAX; c++)
+    {
+      if(conv_out[i][c])
+      {
+        fclose(conv_out[i][c]);
+      }
+    }
+  }
+
+  double secs = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+
+  fprintf(stderr, "%llu bytes, %llu frames, %llu lost, %llu bad crc, %llu bad cobs, "
+          "%llu bad length, %llu skipped, %llu other, %llu ADC sweeps dropped (%s",
+          (unsigned long long)file.len, (unsigned long long)cap.frames,
+          (unsigned long long)cap.lost, (unsigned long long)cap.bad_crc,
+          (unsigned long long)cap.bad_cobs, (unsigned long long)cap.bad_len,
+          (unsigned long long)(cap.skipped + (file.len - pos)),
+          (unsigned long long)cap.other, (unsigned long long)cap.adc_lost, capture_simd_name());
+
+  if(secs > 0)
+  {
+    fprintf(stderr, ", %.2f GB/s", file.len / secs / 1e9);
+  }
+
+  fprintf(stderr, ")\n");
+
+  capture_free(&cap);
+  capture_unmap(&file);
+
+  return 0;
+}
+
+/***************************END OF FUNCTION DEFINITIONS************************/
@@ -0,0 +1,267 @@
+/*------------------------------------------------------------------------------
+  capture_simd.c --
+
+  Description:
+    Conversion kernels for `capture.c`: sign-extend int16 values to float
+    and scale them, and split interleaved x, y, z triples into columns.
+
+      On x86 the widest of AVX2 and SSSE3 that the CPU supports is picked
+    at run time (the file needs no special compiler flags); elsewhere, or
+    with `capture_simd_disable`, the scalar loops run and the compiler is
+    left to vectorize them.
+
+      The triple kernels take 8 triples (three 16-byte loads) at a time and
+    gather each axis into one register with three byte shuffles, then
+    widen and convert 8 values at once.
+
+------------------------------------------------------------------------------*/
+
+/********************************DEPENDENCIES**********************************/
+
+#include "capture.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CAPTURE_X86     1
+#include <immintrin.h>
+#endif
+
+/*****************************END OF DEPENDENCIES******************************/
+
+
+/******************************GLOBAL VARIABLES********************************/
+
+typedef void (*capture_i16_fn)(const int16_t *, size_t, float, float *);
+typedef void (*capture_i16x3_fn)(const int16_t *, size_t, float, float *, float *, float *);
+
+static capture_i16_fn capture_i16_impl = NULL;
+static capture_i16x3_fn capture_i16x3_impl = NULL;
+static const char * capture_impl_name = "scalar";
+static int capture_scalar_only = 0;
+
+#ifdef CAPTURE_X86
+/* pshufb masks: [axis][source register], bytes of that axis's elements
+ * moved to their place in the gathered register, 0x80 elsewhere. */
+static uint8_t capture_xyz_mask[3][3][16] __attribute__((aligned(16)));
+#endif
+
+/***************************END OF GLOBAL VARIABLES****************************/
+
+
+/*****************************FUNCTION DEFINITIONS*****************************/
+
+static void capture_i16_scalar(const int16_t * in, size_t n, float scale, float * out)
+{
+  for(size_t i = 0; i < n; i++)
+  {
+    out[i] = in[i] * scale;
+  }
+}
+
+static void capture_i16x3_scalar(const int16_t * in, size_t n, float scale,
+                                 float * x, float * y, float * z)
+{
+  for(size_t i = 0; i < n; i++)
+  {
+    x[i] = in[3 * i + 0] * scale;
+    y[i] = in[3 * i + 1] * scale;
+    z[i] = in[3 * i + 2] * scale;
+  }
+}
+
+#ifdef CAPTURE_X86
+
+static void capture_xyz_mask_init(void)
+{
+  for(int axis = 0; axis < 3; axis++)
+  {
+    for(int src = 0; src < 3; src++)
+    {
+      for(int b = 0; b < 16; b++)
+      {
+        capture_xyz_mask[axis][src][b] = 0x80;
+      }
+    }
+
+    // element 3j + axis of the 24 lands in slot j
+    for(int j = 0; j < 8; j++)
+    {
+      int e = 3 * j + axis;
+
+      capture_xyz_mask[axis][e / 8][2 * j] = (uint8_t)(2 * (e % 8));
+      capture_xyz_mask[axis][e / 8][2 * j + 1] = (uint8_t)(2 * (e % 8) + 1);
+    }
+  }
+}
+
+/* The 8 values of one axis out of 8 triples held in a, b, c. */
+__attribute__((target("ssse3")))
+static inline __m128i capture_gather(__m128i a, __m128i b, __m128i c, int axis)
+{
+  const __m128i * m = (const __m128i *)capture_xyz_mask[axis];
+
+  return _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a, _mm_load_si128(m + 0)),
+                                   _mm_shuffle_epi8(b, _mm_load_si128(m + 1))),
+                      _mm_shuffle_epi8(c, _mm_load_si128(m + 2)));
+}
+
+/* Sign-extends, converts and scales 8 int16 values (SSE2). */
+__attribute__((target("ssse3")))
+static inline void capture_store8_sse(__m128i v, __m128 k, float * out)
+{
+  __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+  __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(v, v), 16);
+
+  _mm_storeu_ps(out, _mm_mul_ps(_mm_cvtepi32_ps(lo), k));
+  _mm_storeu_ps(out + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), k));
+}
+
+__attribute__((target("ssse3")))
+static void capture_i16_ssse3(const int16_t * in, size_t n, float scale, float * out)
+{
+  __m128 k = _mm_set1_ps(scale);
+  size_t i = 0;
+
+  for(; i + 8 <= n; i += 8)
+  {
+    capture_store8_sse(_mm_loadu_si128((const __m128i *)(in + i)), k, out + i);
+  }
+
+  capture_i16_scalar(in + i, n - i, scale, out + i);
+}
+
+__attribute__((target("ssse3")))
+static void capture_i16x3_ssse3(const int16_t * in, size_t n, float scale,
+                                float * x, float * y, float * z)
+{
+  __m128 k = _mm_set1_ps(scale);
+  size_t i = 0;
+
+  for(; i + 8 <= n; i += 8)
+  {
+    const __m128i * p = (const __m128i *)(in + 3 * i);
+    __m128i a = _mm_loadu_si128(p);
+    __m128i b = _mm_loadu_si128(p + 1);
+    __m128i c = _mm_loadu_si128(p + 2);
+
+    capture_store8_sse(capture_gather(a, b, c, 0), k, x + i);
+    capture_store8_sse(capture_gather(a, b, c, 1), k, y + i);
+    capture_store8_sse(capture_gather(a, b, c, 2), k, z + i);
+  }
+
+  capture_i16x3_scalar(in + 3 * i, n - i, scale, x + i, y + i, z + i);
+}
+
+/* Sign-extends, converts and scales 8 int16 values (AVX2). */
+__attribute__((target("avx2")))
+static inline void capture_store8_avx2(__m128i v, __m256 k, float * out)
+{
+  _mm256_storeu_ps(out, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(v)), k));
+}
+
+__attribute__((target("avx2")))
+static void capture_i16_avx2(const int16_t * in, size_t n, float scale, float * out)
+{
+  __m256 k = _mm256_set1_ps(scale);
+  size_t i = 0;
+
+  for(; i + 16 <= n; i += 16)
+  {
+    capture_store8_avx2(_mm_loadu_si128((const __m128i *)(in + i)), k, out + i);
+    capture_store8_avx2(_mm_loadu_si128((const __m128i *)(in + i + 8)), k, out + i + 8);
+  }
+
+  capture_i16_scalar(in + i, n - i, scale, out + i);
+}
+
+__attribute__((target("avx2")))
+static void capture_i16x3_avx2(const int16_t * in, size_t n, float scale,
+                               float * x, float * y, float * z)
+{
+  __m256 k = _mm256_set1_ps(scale);
+  size_t i = 0;
+
+  for(; i + 8 <= n; i += 8)
+  {
+    const __m128i * p = (const __m128i *)(in + 3 * i);
+    __m128i a = _mm_loadu_si128(p);
+    __m128i b = _mm_loadu_si128(p + 1);
+    __m128i c = _mm_loadu_si128(p + 2);
+
+    capture_store8_avx2(capture_gather(a, b, c, 0), k, x + i);
+    capture_store8_avx2(capture_gather(a, b, c, 1), k, y + i);
+    capture_store8_avx2(capture_gather(a, b, c, 2), k, z + i);
+  }
+
+  capture_i16x3_scalar(in + 3 * i, n - i, scale, x + i, y + i, z + i);
+}
+
+#endif
+
+static void capture_simd_select(void)
+{
+  capture_i16_impl = capture_i16_scalar;
+  capture_i16x3_impl = capture_i16x3_scalar;
+  capture_impl_name = "scalar";
+
+#ifdef CAPTURE_X86
+  if(capture_scalar_only)
+  {
+    return;
+  }
+
+  __builtin_cpu_init();
+  capture_xyz_mask_init();
+
+  if(__builtin_cpu_supports("avx2"))
+  {
+    capture_i16_impl = capture_i16_avx2;
+    capture_i16x3_impl = capture_i16x3_avx2;
+    capture_impl_name = "avx2";
+  }
+  else if(__builtin_cpu_supports("ssse3"))
+  {
+    capture_i16_impl = capture_i16_ssse3;
+    capture_i16x3_impl = capture_i16x3_ssse3;
+    capture_impl_name = "ssse3";
+  }
+#endif
+}
+
+void capture_i16_to_f32(const int16_t * in, size_t n, float scale, float * out)
+{
+  if(!capture_i16_impl)
+  {
+    capture_simd_select();
+  }
+
+  capture_i16_impl(in, n, scale, out);
+}
+
+void capture_i16x3_to_f32(const int16_t * in, size_t n, float scale,
+                          float * x, float * y, float * z)
+{
+  if(!capture_i16x3_impl)
+  {
+    capture_simd_select();
+  }
+
+  capture_i16x3_impl(in, n, scale, x, y, z);
+}
+
+const char * capture_simd_name(void)
+{
+  if(!capture_i16_impl)
+  {
+    capture_simd_select();
+  }
+
+  return capture_impl_name;
+}
+
+void capture_simd_disable(int disable)
+{
+  capture_scalar_only = disable;
+  capture_simd_select();
+}
+
+/***************************END OF FUNCTION DEFINITIONS************************/
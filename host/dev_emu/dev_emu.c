@@ -0,0 +1,651 @@
+/*------------------------------------------------------------------------------
+  dev_emu.c --
+
+  Description:
+    Stands in for a board running one of the apps: opens a pseudo-terminal
+    and writes the byte stream that firmware would send over USARTD0, so
+    host-side ingestion can be load-tested without hardware.
+
+      adc    one frame per block of EMU_ADC_BLOCK sweeps, as the app
+             sends one per DMA block (ADC_BLOCK_SWEEPS): a
+             FRAME_TYPE_ADC_SAMPLE frame of int16 results in 1/16 LSB for
+             the CdS or J3 input, picked with 'C' or 'J' from the host (a
+             slow sine and a ramp here), or with 'A' a FRAME_TYPE_ADC_SWEEP
+             frame of all four channels. Blocks the device drops are
+             reported in a FRAME_TYPE_ADC_LOST frame ahead of the next one,
+             without a sequence number of their own, as the app does.
+      accel  FRAME_TYPE_ACCEL frames of `-B` x, y, z samples, as the
+             accelerometer app sends a FIFO batch.
+      gyro   FRAME_TYPE_ATTITUDE frames of roll, pitch, yaw, one per sample.
+      synth  nothing unprompted; every byte the host writes is echoed back.
+
+    Frames are encoded with `frame_encode` from ../frame, so they are byte
+    for byte what the firmware produces (sequence numbers included) with
+    the apps' default settings: no oversampling or auto-ranging on the ADC.
+
+      Output is paced at the baud rate (10 bits per byte, 8N1). Records
+    that are due while the device is still sending are queued, as the
+    firmware's transmit buffer would hold them, up to `-Q` bytes; past that
+    they are dropped ("dev drop"). Impairments are applied to the bytes on
+    the wire: `-l` starts a burst of `-b` lost bytes with the given
+    probability per frame, `-c` flips one bit of a byte with the given
+    probability per byte. When the consumer stops reading and the pty
+    fills up, bytes are discarded ("host drop"), as a USB serial bridge
+    would.
+
+      Once a second, and at exit, the tool reports the consumer's sustained
+    read rate and latency. Consumed bytes are the bytes written minus those
+    still waiting in the pty (FIONREAD on our own handle of the slave side),
+    so the latency of a frame is the time from its last byte being written
+    until the consumer's reads got past it: "wire" latency. "e2e" adds the
+    time spent queued behind the baud rate, i.e. from when the firmware
+    would have produced the record. Resolution is the 1 ms polling period.
+
+    Build (from this directory):
+      cc -O2 -std=c99 -I../frame ../frame/frame_decode.c dev_emu.c -o dev_emu -lm
+
+    Usage:
+      dev_emu [-m adc|accel|gyro|synth] [-r rate] [-B batch] [-s baud]
+              [-l loss] [-b burst] [-c corrupt] [-Q bytes] [-t seconds]
+              [-L link] [-S seed]
+
+      rate is sweeps (adc), samples (accel) or records per second; baud
+      0 disables pacing; loss and corrupt are probabilities (e.g. 1e-3).
+      The slave path is printed on stdout, and `-L` also symlinks it, e.g.
+      `dev_emu -m accel -s 2000000 -L /tmp/ttyEMU` then
+      `../frame/frame_dump -q /tmp/ttyEMU`.
+
+------------------------------------------------------------------------------*/
+
+/********************************DEPENDENCIES**********************************/
+
+#define _DEFAULT_SOURCE
+#define _XOPEN_SOURCE 600
+
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include "frame_decode.h"
+
+/*****************************END OF DEPENDENCIES******************************/
+
+
+/***********************************MACROS*************************************/
+
+/* Largest record payload any mode produces (accel batches included). */
+#define EMU_PAYLOAD_MAX     1536
+
+/* ADC sweeps per frame, ADC_BLOCK_SWEEPS in the app. */
+#define EMU_ADC_BLOCK       16
+
+/* ADC input selection that sends all four channels, SEND_ALL in the app. */
+#define EMU_ADC_ALL         0xFF
+
+/* Frames written but not yet consumed that are tracked for latency. */
+#define EMU_MARKS           65536
+
+/********************************END OF MACROS*********************************/
+
+
+/*******************************CUSTOM DATA TYPES******************************/
+
+enum emu_mode
+{
+  EMU_ADC,
+  EMU_ACCEL,
+  EMU_GYRO,
+  EMU_SYNTH
+};
+
+/* End of a frame in the written byte count, and when it was produced and
+ * when its last byte was written. */
+typedef struct emu_mark
+{
+  uint64_t end;
+  double t_gen;
+  double t_write;
+}emu_mark_t;
+
+/* Latency samples for one report interval. */
+typedef struct emu_lat
+{
+  double * v;
+  size_t n, cap;
+  double max;
+}emu_lat_t;
+
+typedef struct emu_stats
+{
+  uint64_t records, frames;
+  uint64_t written, consumed;
+  uint64_t dev_drop, host_drop;
+  uint64_t bursts, burst_bytes, corrupt;
+  uint64_t echoed;
+}emu_stats_t;
+
+/***************************END OF CUSTOM DATA TYPES***************************/
+
+
+/******************************GLOBAL VARIABLES********************************/
+
+static volatile sig_atomic_t emu_stop = 0;
+
+static uint64_t emu_rng = 0x9E3779B97F4A7C15ull;
+
+/***************************END OF GLOBAL VARIABLES****************************/
+
+
+/*****************************FUNCTION DEFINITIONS*****************************/
+
+static void on_signal(int sig)
+{
+  (void)sig;
+  emu_stop = 1;
+}
+
+static double now_s(void)
+{
+  struct timespec t;
+
+  clock_gettime(CLOCK_MONOTONIC, &t);
+
+  return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+/* xorshift64*, uniform in [0, 1). */
+static double rnd(void)
+{
+  emu_rng ^= emu_rng >> 12;
+  emu_rng ^= emu_rng << 25;
+  emu_rng ^= emu_rng >> 27;
+
+  return ((emu_rng * 0x2545F4914F6CDD1Dull) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static void put16(uint8_t * p, int v)
+{
+  p[0] = (uint8_t)v;
+  p[1] = (uint8_t)(v >> 8);
+}
+
+static void lat_add(emu_lat_t * l, double v)
+{
+  if(l->n == l->cap)
+  {
+    l->cap = l->cap ? 2 * l->cap : 1024;
+    l->v = realloc(l->v, l->cap * sizeof(*l->v));
+  }
+
+  l->v[l->n++] = v;
+
+  if(v > l->max)
+  {
+    l->max = v;
+  }
+}
+
+static int cmp_double(const void * a, const void * b)
+{
+  double x = *(const double *)a, y = *(const double *)b;
+
+  return (x > y) - (x < y);
+}
+
+/* Formats "p50/p99/max" in ms, and empties `l`. */
+static const char * lat_report(emu_lat_t * l, char * buf, size_t size)
+{
+  if(!l->n)
+  {
+    snprintf(buf, size, "-");
+  }
+  else
+  {
+    qsort(l->v, l->n, sizeof(*l->v), cmp_double);
+    snprintf(buf, size, "%.1f/%.1f/%.1f", 1e3 * l->v[l->n / 2],
+             1e3 * l->v[(l->n * 99) / 100], 1e3 * l->max);
+  }
+
+  l->n = 0;
+  l->max = 0;
+
+  return buf;
+}
+
+/* 12-bit signed result in 1/16 LSB of ADC channel `c` for sweep `n` at
+ * time `t`. */
+static int adc_result(int c, uint64_t n, double t)
+{
+  switch(c)
+  {
+    case 0:
+      // slow light changes on the CdS cell
+      return (int)(16 * (1200 * sin(2 * M_PI * 0.2 * t) + 400));
+
+    case 1:
+      // a sawtooth on J3
+      return ((int)(n % 4096) - 2048) * 16;
+  }
+
+  // the spare inputs, left open: a few LSB of mains hum
+  return (int)(16 * 3 * sin(2 * M_PI * 50 * t + c));
+}
+
+/* Builds the payload of record number `n` (and the following ones, for an
+ * accel batch or an ADC block) at time `t`. Returns the payload length. */
+static size_t make_record(int mode, uint64_t n, int batch, double rate,
+                          int input, uint8_t * p)
+{
+  double t = n / rate;
+
+  switch(mode)
+  {
+    case EMU_ADC:
+      for(int i = 0; i < EMU_ADC_BLOCK; i++)
+      {
+        double ts = (n + i) / rate;
+
+        if(input == EMU_ADC_ALL)
+        {
+          for(int c = 0; c < 4; c++)
+          {
+            put16(p + 8 * i + 2 * c, adc_result(c, n + i, ts));
+          }
+        }
+        else
+        {
+          put16(p + 2 * i, adc_result(input, n + i, ts));
+        }
+      }
+      return (size_t)((input == EMU_ADC_ALL) ? 8 : 2) * EMU_ADC_BLOCK;
+
+    case EMU_ACCEL:
+      // board lying flat (1 g = 16393 LSB at +/-2 g), with a small wobble
+      for(int i = 0; i < batch; i++)
+      {
+        double ts = (n + i) / rate;
+
+        put16(p + 6 * i + 0, (int)(800 * sin(2 * M_PI * 1.3 * ts)));
+        put16(p + 6 * i + 2, (int)(600 * cos(2 * M_PI * 0.7 * ts)));
+        put16(p + 6 * i + 4, (int)(16393 + 300 * sin(2 * M_PI * 3.1 * ts)));
+      }
+      return (size_t)6 * batch;
+
+    case EMU_GYRO:
+      // binary angles: rocking in roll and pitch, turning slowly in yaw
+      put16(p + 0, (int)(4000 * sin(2 * M_PI * 0.25 * t)));
+      put16(p + 2, (int)(2500 * sin(2 * M_PI * 0.4 * t)));
+      put16(p + 4, (int)(65536.0 * fmod(t / 20, 1.0)));
+      return 6;
+  }
+
+  return 0;
+}
+
+static void usage(void)
+{
+  fprintf(stderr,
+          "usage: dev_emu [-m adc|accel|gyro|synth] [-r rate] [-B batch] [-s baud]\n"
+          "               [-l loss] [-b burst] [-c corrupt] [-Q bytes] [-t seconds]\n"
+          "               [-L link] [-S seed]\n");
+  exit(2);
+}
+
+int main(int argc, char ** argv)
+{
+  int mode = EMU_ADC;
+  double rate = -1, baud = 115200, loss = 0, corrupt = 0, seconds = 0;
+  int batch = 32, burst = 16;
+  size_t queue_max = 4096;
+  const char * link = NULL;
+  int opt;
+
+  while((opt = getopt(argc, argv, "m:r:B:s:l:b:c:Q:t:L:S:")) != -1)
+  {
+    switch(opt)
+    {
+      case 'm':
+        if(!strcmp(optarg, "adc")) mode = EMU_ADC;
+        else if(!strcmp(optarg, "accel")) mode = EMU_ACCEL;
+        else if(!strcmp(optarg, "gyro")) mode = EMU_GYRO;
+        else if(!strcmp(optarg, "synth")) mode = EMU_SYNTH;
+        else usage();
+        break;
+      case 'r': rate = atof(optarg); break;
+      case 'B': batch = atoi(optarg); break;
+      case 's': baud = atof(optarg); break;
+      case 'l': loss = atof(optarg); break;
+      case 'b': burst = atoi(optarg); break;
+      case 'c': corrupt = atof(optarg); break;
+      case 'Q': queue_max = (size_t)atol(optarg); break;
+      case 't': seconds = atof(optarg); break;
+      case 'L': link = optarg; break;
+      case 'S': emu_rng = strtoull(optarg, NULL, 0) | 1; break;
+      default: usage();
+    }
+  }
+
+  // the apps' own rates: 1 kHz ADC sweeps, 1.66 kHz IMU output data rate
+  if(rate < 0)
+  {
+    rate = (mode == EMU_ADC) ? 1000 : 1666;
+  }
+
+  if(batch < 1 || 6 * batch > EMU_PAYLOAD_MAX || burst < 1 || rate <= 0)
+  {
+    usage();
+  }
+
+  int master = posix_openpt(O_RDWR | O_NOCTTY);
+
+  if(master < 0 || grantpt(master) || unlockpt(master))
+  {
+    perror("posix_openpt");
+    return 1;
+  }
+
+  const char * slave_path = ptsname(master);
+
+  // hold the slave open: it keeps the pty alive between consumers and is
+  // how the unread byte count is queried
+  int slave = open(slave_path, O_RDWR | O_NOCTTY);
+  struct termios tio;
+
+  if(slave < 0 || tcgetattr(slave, &tio))
+  {
+    perror(slave_path);
+    return 1;
+  }
+
+  cfmakeraw(&tio);
+  tcsetattr(slave, TCSANOW, &tio);
+  fcntl(master, F_SETFL, fcntl(master, F_GETFL) | O_NONBLOCK);
+
+  if(link)
+  {
+    unlink(link);
+
+    if(symlink(slave_path, link))
+    {
+      perror(link);
+      return 1;
+    }
+  }
+
+  printf("%s\n", slave_path);
+  fflush(stdout);
+
+  signal(SIGINT, on_signal);
+  signal(SIGTERM, on_signal);
+
+  // bytes waiting to go out at the baud rate
+  uint8_t * queue = malloc(queue_max + EMU_PAYLOAD_MAX * 2);
+  size_t queued = 0;
+
+  static emu_mark_t marks[EMU_MARKS];
+  size_t mark_head = 0, mark_tail = 0;
+
+  // frames in the queue: where each ends in it, and when it was produced
+  static emu_mark_t pending[EMU_MARKS];
+  size_t pend_n = 0;
+
+  emu_stats_t st, last;
+  emu_lat_t wire = {0}, e2e = {0}, wire_all = {0}, e2e_all = {0};
+  uint8_t payload[EMU_PAYLOAD_MAX], frame[EMU_PAYLOAD_MAX * 2];
+  uint8_t seq = 0;
+  int input = 0, lose = 0;
+  unsigned adc_lost = 0;
+  double sent_budget = 0;
+
+  memset(&st, 0, sizeof(st));
+  last = st;
+
+  double t0 = now_s(), t_last = t0, t_report = t0 + 1;
+
+  while(!emu_stop)
+  {
+    double t = now_s();
+
+    if(seconds > 0 && t - t0 >= seconds)
+    {
+      break;
+    }
+
+    // host to device: commands, or keys to echo
+    uint8_t in[256];
+    ssize_t n_in = read(master, in, sizeof(in));
+
+    for(ssize_t i = 0; i < n_in; i++)
+    {
+      if(mode == EMU_ADC && (in[i] == 'C' || in[i] == 'J' || in[i] == 'A'))
+      {
+        input = (in[i] == 'C') ? 0 : (in[i] == 'J') ? 1 : EMU_ADC_ALL;
+      }
+      else if(mode == EMU_SYNTH && queued < queue_max && pend_n < EMU_MARKS)
+      {
+        queue[queued++] = in[i];
+        pending[pend_n].end = queued;
+        pending[pend_n++].t_gen = t;
+        st.echoed++;
+      }
+    }
+
+    // records the firmware would have produced by now
+    if(mode != EMU_SYNTH)
+    {
+      uint64_t due = (uint64_t)((t - t0) * rate);
+      uint64_t step = (mode == EMU_ACCEL) ? (uint64_t)batch :
+                      (mode == EMU_ADC) ? EMU_ADC_BLOCK : 1;
+
+      while(st.records + step <= due)
+      {
+        size_t len = make_record(mode, st.records, batch, rate, input, payload);
+        uint8_t type = (mode == EMU_ACCEL) ? FRAME_TYPE_ACCEL :
+                       (mode == EMU_GYRO) ? FRAME_TYPE_ATTITUDE :
+                       (input == EMU_ADC_ALL) ? FRAME_TYPE_ADC_SWEEP : FRAME_TYPE_ADC_SAMPLE;
+        size_t flen = 0;
+        int frames = 0;
+
+        // the app reports the blocks it dropped before the next results
+        if(adc_lost)
+        {
+          uint8_t lost[4];
+
+          put16(lost, (int)adc_lost);
+          put16(lost + 2, EMU_ADC_BLOCK);
+          flen = frame_encode(FRAME_TYPE_ADC_LOST, seq, lost, sizeof(lost), frame);
+          frames++;
+        }
+
+        flen += frame_encode(type, (uint8_t)(seq + frames), payload, len, frame + flen);
+        frames++;
+        st.records += step;
+
+        if(queued + flen > queue_max || pend_n == EMU_MARKS)
+        {
+          st.dev_drop += step;
+
+          // the app drops an ADC block before it is framed; other records
+          // are lost from the transmit buffer, sequence number and all
+          if(mode == EMU_ADC)
+          {
+            adc_lost++;
+          }
+          else
+          {
+            seq++;
+            st.frames++;
+          }
+          continue;
+        }
+
+        seq += frames;
+        st.frames += frames;
+        adc_lost = 0;
+
+        // impairments: a burst of lost bytes starting somewhere in this
+        // frame, and single bit flips
+        size_t skip_from = lose ? 0 : flen;   // a burst carried over
+
+        if(!lose && loss > 0 && rnd() < loss)
+        {
+          lose = burst;
+          st.bursts++;
+          skip_from = (size_t)(rnd() * flen);
+        }
+
+        for(size_t i = 0; i < flen; i++)
+        {
+          uint8_t b = frame[i];
+
+          if(i >= skip_from && lose)
+          {
+            lose--;
+            st.burst_bytes++;
+            continue;
+          }
+
+          if(corrupt > 0 && rnd() < corrupt)
+          {
+            b ^= (uint8_t)(1 << (int)(rnd() * 8));
+            st.corrupt++;
+          }
+
+          queue[queued++] = b;
+        }
+
+        pending[pend_n].end = queued;
+        pending[pend_n++].t_gen = t0 + st.records / rate;
+      }
+    }
+
+    // release bytes at the baud rate
+    size_t allow = queued;
+
+    if(baud > 0)
+    {
+      sent_budget += (t - t_last) * baud / 10;
+
+      if(sent_budget > queued)
+      {
+        sent_budget = queued;     // an idle line does not bank time
+      }
+
+      allow = (size_t)sent_budget;
+    }
+
+    t_last = t;
+
+    if(allow)
+    {
+      ssize_t w = write(master, queue, allow);
+
+      if(w < 0)
+      {
+        w = 0;
+      }
+
+      // whatever the pty would not take is lost, as with a real bridge
+      st.host_drop += allow - (size_t)w;
+
+      size_t done = 0;
+
+      while(done < pend_n && pending[done].end <= allow)
+      {
+        // frames cut short by a full pty are not tracked
+        if(pending[done].end <= (size_t)w && (mark_head + 1) % EMU_MARKS != mark_tail)
+        {
+          marks[mark_head].end = st.written + pending[done].end;
+          marks[mark_head].t_gen = pending[done].t_gen;
+          marks[mark_head].t_write = t;
+          mark_head = (mark_head + 1) % EMU_MARKS;
+        }
+
+        done++;
+      }
+
+      st.written += (size_t)w;
+      sent_budget -= allow;
+      queued -= allow;
+      memmove(queue, queue + allow, queued);
+
+      for(size_t i = done; i < pend_n; i++)
+      {
+        pending[i - done] = pending[i];
+        pending[i - done].end -= allow;
+      }
+
+      pend_n -= done;
+    }
+
+    // what the consumer has read so far
+    int unread = 0;
+
+    if(!ioctl(slave, FIONREAD, &unread))
+    {
+      st.consumed = st.written - (uint64_t)unread;
+    }
+
+    while(mark_tail != mark_head && marks[mark_tail].end <= st.consumed)
+    {
+      lat_add(&wire, t - marks[mark_tail].t_write);
+      lat_add(&e2e, t - marks[mark_tail].t_gen);
+      lat_add(&wire_all, t - marks[mark_tail].t_write);
+      lat_add(&e2e_all, t - marks[mark_tail].t_gen);
+      mark_tail = (mark_tail + 1) % EMU_MARKS;
+    }
+
+    if(t >= t_report)
+    {
+      char a[64], b[64];
+
+      fprintf(stderr,
+              "%6.1fs  %7.0f rec/s  wire %8.0f B/s  consumed %8.0f B/s  "
+              "lat ms p50/p99/max wire %s e2e %s  dev drop %llu host drop %llu\n",
+              t - t0, (double)(st.records - last.records),
+              (double)(st.written - last.written), (double)(st.consumed - last.consumed),
+              lat_report(&wire, a, sizeof(a)), lat_report(&e2e, b, sizeof(b)),
+              (unsigned long long)st.dev_drop, (unsigned long long)st.host_drop);
+
+      last = st;
+      t_report += 1;
+    }
+
+    struct pollfd pfd = {master, POLLIN, 0};
+    poll(&pfd, 1, 1);
+  }
+
+  double secs = now_s() - t0;
+  char a[64], b[64];
+
+  fprintf(stderr,
+          "%.1f s: %llu records in %llu frames, %llu bytes written, %llu consumed "
+          "(%.0f B/s sustained)\n"
+          "latency ms p50/p99/max: wire %s, e2e %s\n"
+          "dropped: %llu records in the device, %llu bytes at the pty; "
+          "%llu loss bursts (%llu bytes), %llu corrupt bytes, %llu echoed\n",
+          secs, (unsigned long long)st.records, (unsigned long long)st.frames,
+          (unsigned long long)st.written, (unsigned long long)st.consumed,
+          secs > 0 ? st.consumed / secs : 0.0,
+          lat_report(&wire_all, a, sizeof(a)), lat_report(&e2e_all, b, sizeof(b)),
+          (unsigned long long)st.dev_drop, (unsigned long long)st.host_drop,
+          (unsigned long long)st.bursts, (unsigned long long)st.burst_bytes,
+          (unsigned long long)st.corrupt, (unsigned long long)st.echoed);
+
+  if(link)
+  {
+    unlink(link);
+  }
+
+  return 0;
+}
+
+/***************************END OF FUNCTION DEFINITIONS************************/
@@ -0,0 +1,263 @@
+/*------------------------------------------------------------------------------
+  frame_decode.c --
+
+  Description:
+    Host-side frame decoder. See `frame_decode.h`.
+
+------------------------------------------------------------------------------*/
+
+/********************************DEPENDENCIES**********************************/
+
+#include <string.h>
+#include "frame_decode.h"
+
+/*****************************END OF DEPENDENCIES******************************/
+
+
+/*****************************FUNCTION DEFINITIONS*****************************/
+
+/* Slice-by-8 tables, built on first use: `frame_crc_table[k][b]` is the
+ * CRC of byte `b` followed by `k` zero bytes, so eight bytes are folded
+ * in with eight independent lookups instead of a chain of eight. */
+static uint16_t frame_crc_table[8][256];
+static int frame_crc_ready = 0;
+
+static void frame_crc_init(void)
+{
+  for(int b = 0; b < 256; b++)
+  {
+    uint16_t crc = (uint16_t)(b << 8);
+
+    for(int i = 0; i < 8; i++)
+    {
+      crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+    }
+
+    frame_crc_table[0][b] = crc;
+  }
+
+  for(int k = 1; k < 8; k++)
+  {
+    for(int b = 0; b < 256; b++)
+    {
+      uint16_t crc = frame_crc_table[k - 1][b];
+
+      frame_crc_table[k][b] = (uint16_t)((crc << 8) ^ frame_crc_table[0][crc >> 8]);
+    }
+  }
+
+  frame_crc_ready = 1;
+}
+
+uint16_t frame_crc16_update(uint16_t crc, const uint8_t * data, size_t len)
+{
+  if(!frame_crc_ready)
+  {
+    frame_crc_init();
+  }
+
+  for(; len >= 8; len -= 8, data += 8)
+  {
+    crc = (uint16_t)(frame_crc_table[7][data[0] ^ (crc >> 8)] ^
+                     frame_crc_table[6][data[1] ^ (crc & 0xFF)] ^
+                     frame_crc_table[5][data[2]] ^ frame_crc_table[4][data[3]] ^
+                     frame_crc_table[3][data[4]] ^ frame_crc_table[2][data[5]] ^
+                     frame_crc_table[1][data[6]] ^ frame_crc_table[0][data[7]]);
+  }
+
+  while(len--)
+  {
+    crc = (uint16_t)((crc << 8) ^ frame_crc_table[0][(crc >> 8) ^ *data++]);
+  }
+
+  return crc;
+}
+
+uint16_t frame_crc16(const uint8_t * data, size_t len)
+{
+  return frame_crc16_update(0xFFFF, data, len);
+}
+
+long frame_cobs_decode(const uint8_t * in, size_t len, uint8_t * out)
+{
+  size_t i = 0;
+  long n = 0;
+
+  while(i < len)
+  {
+    uint8_t code = in[i++];
+    size_t run = code - 1u;
+
+    if(code == 0 || i + run > len)
+    {
+      return -1;
+    }
+
+    // most blocks are a few bytes, where a call to memcpy costs more
+    // than the copy
+    if(run < 16)
+    {
+      for(size_t k = 0; k < run; k++)
+      {
+        out[n + k] = in[i + k];
+      }
+    }
+    else
+    {
+      memcpy(out + n, in + i, run);
+    }
+
+    n += run;
+    i += run;
+
+    // every block but the last, and a full one, implies a zero
+    if(code < 0xFF && i < len)
+    {
+      out[n++] = 0;
+    }
+  }
+
+  return n;
+}
+
+/* COBS state while encoding into `out`. */
+typedef struct frame_cobs
+{
+  uint8_t * out;
+  size_t code_at;
+  size_t n;
+}frame_cobs_t;
+
+static void frame_cobs_put(frame_cobs_t * c, uint8_t b)
+{
+  if(b)
+  {
+    c->out[c->n++] = b;
+  }
+
+  // close the block on a zero, or when it is full
+  if(!b || c->n - c->code_at == 0xFF)
+  {
+    c->out[c->code_at] = (uint8_t)(c->n - c->code_at);
+    c->code_at = c->n++;
+  }
+}
+
+size_t frame_encode(uint8_t type, uint8_t seq, const uint8_t * payload, size_t len, uint8_t * out)
+{
+  frame_cobs_t c = {out, 0, 1};
+  uint8_t head[2] = {type, seq};
+  uint16_t crc;
+
+  frame_cobs_put(&c, type);
+  frame_cobs_put(&c, seq);
+
+  for(size_t i = 0; i < len; i++)
+  {
+    frame_cobs_put(&c, payload[i]);
+  }
+
+  // crc over type, seq and payload, as the firmware computes it
+  crc = frame_crc16_update(frame_crc16(head, 2), payload, len);
+
+  frame_cobs_put(&c, (uint8_t)crc);
+  frame_cobs_put(&c, (uint8_t)(crc >> 8));
+
+  out[c.code_at] = (uint8_t)(c.n - c.code_at);
+  out[c.n++] = 0;
+
+  return c.n;
+}
+
+void frame_decoder_init(frame_decoder_t * dec, frame_handler_t handler, void * ctx)
+{
+  memset(dec, 0, sizeof(*dec));
+
+  dec->handler = handler;
+  dec->ctx = ctx;
+}
+
+static void frame_decoder_close(frame_decoder_t * dec)
+{
+  static uint8_t raw[sizeof(((frame_decoder_t *)0)->buf)];
+  long n;
+
+  if(dec->overflow)
+  {
+    dec->bad_cobs++;
+    return;
+  }
+
+  n = frame_cobs_decode(dec->buf, dec->len, raw);
+
+  if(n < 4)
+  {
+    dec->bad_cobs++;
+    return;
+  }
+
+  uint16_t crc = (uint16_t)(raw[n - 2] | (raw[n - 1] << 8));
+
+  if(frame_crc16(raw, (size_t)n - 2) != crc)
+  {
+    dec->bad_crc++;
+    return;
+  }
+
+  uint32_t lost = dec->have_seq ? (uint8_t)(raw[1] - dec->next_seq) : 0;
+
+  dec->have_seq = 1;
+  dec->next_seq = (uint8_t)(raw[1] + 1);
+  dec->lost += lost;
+  dec->frames++;
+
+  if(dec->handler)
+  {
+    dec->handler(dec->ctx, raw[0], raw[1], raw + 2, (size_t)n - 4, lost);
+  }
+}
+
+void frame_decoder_feed(frame_decoder_t * dec, const uint8_t * data, size_t len)
+{
+  dec->bytes += len;
+
+  while(len)
+  {
+    const uint8_t * end = (const uint8_t *)memchr(data, 0, len);
+    size_t run = end ? (size_t)(end - data) : len;
+
+    if(!dec->synced)
+    {
+      // everything before the first delimiter is a partial frame
+      dec->skipped += run;
+    }
+    else if(!dec->overflow && dec->len + run <= sizeof(dec->buf))
+    {
+      memcpy(dec->buf + dec->len, data, run);
+      dec->len += run;
+    }
+    else
+    {
+      dec->overflow = 1;
+    }
+
+    if(!end)
+    {
+      return;
+    }
+
+    if(dec->synced && (dec->len || dec->overflow))
+    {
+      frame_decoder_close(dec);
+    }
+
+    dec->synced = 1;
+    dec->len = 0;
+    dec->overflow = 0;
+
+    data += run + 1;
+    len -= run + 1;
+  }
+}
+
+/***************************END OF FUNCTION DEFINITIONS************************/
@@ -0,0 +1,109 @@
+#ifndef FRAME_DECODE_H_    // Header guard.
+#define FRAME_DECODE_H_
+
+/*------------------------------------------------------------------------------
+  frame_decode.h --
+
+  Description:
+    Host-side decoder for the frames written by `IMU_SPI_USART/frame.c`.
+
+      Bytes are fed in as they arrive, in chunks of any size. Each 0x00
+    delimiter closes a frame, which is COBS decoded and CRC checked; a good
+    frame is handed to the callback together with the number of frames lost
+    since the previous good one, going by the sequence numbers. Bytes before
+    the first delimiter, and frames that fail to decode, are counted and
+    skipped, so the decoder is back in step after at most one frame.
+
+------------------------------------------------------------------------------*/
+
+/********************************DEPENDENCIES**********************************/
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*****************************END OF DEPENDENCIES******************************/
+
+
+/***********************************MACROS*************************************/
+
+/* Largest decoded frame (type, seq, payload, crc) that is accepted. */
+#define FRAME_DECODE_MAX    4096
+
+/* Record types, as in `IMU_SPI_USART/frame.h`. */
+#define FRAME_TYPE_ADC_SAMPLE       0x01
+#define FRAME_TYPE_ADC_SWEEP        0x02
+#define FRAME_TYPE_ADC_STATS        0x03
+#define FRAME_TYPE_ADC_SCOPE        0x04
+#define FRAME_TYPE_ADC_RANGED       0x05
+#define FRAME_TYPE_ADC_LOST         0x06
+#define FRAME_TYPE_ACCEL            0x10
+#define FRAME_TYPE_ACCEL_TS         0x11
+#define FRAME_TYPE_EVENT            0x12
+#define FRAME_TYPE_ATTITUDE         0x20
+#define FRAME_TYPE_ATTITUDE_TS      0x21
+
+/********************************END OF MACROS*********************************/
+
+
+/*******************************CUSTOM DATA TYPES******************************/
+
+typedef void (*frame_handler_t)(void * ctx, uint8_t type, uint8_t seq,
+                                const uint8_t * payload, size_t len, uint32_t lost);
+
+typedef struct frame_decoder
+{
+  frame_handler_t handler;
+  void * ctx;
+
+  /* Encoded bytes of the frame in progress. */
+  uint8_t buf[FRAME_DECODE_MAX + FRAME_DECODE_MAX / 254 + 2];
+  size_t len;
+  int synced;
+  int overflow;
+
+  int have_seq;
+  uint8_t next_seq;
+
+  /* Statistics. */
+  uint64_t bytes;
+  uint64_t frames;
+  uint64_t lost;
+  uint64_t bad_crc;
+  uint64_t bad_cobs;
+  uint64_t skipped;
+}frame_decoder_t;
+
+/***************************END OF CUSTOM DATA TYPES***************************/
+
+
+/*****************************FUNCTION PROTOTYPES******************************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void frame_decoder_init(frame_decoder_t * dec, frame_handler_t handler, void * ctx);
+
+void frame_decoder_feed(frame_decoder_t * dec, const uint8_t * data, size_t len);
+
+/* CRC-16/CCITT-FALSE, as computed by the XMEGA CRC module. `update`
+ * continues from a previous result. */
+uint16_t frame_crc16(const uint8_t * data, size_t len);
+
+uint16_t frame_crc16_update(uint16_t crc, const uint8_t * data, size_t len);
+
+/* Decodes COBS `in` (without the delimiter) into `out`. Returns the decoded
+ * length, or -1 if `in` is not valid COBS. */
+long frame_cobs_decode(const uint8_t * in, size_t len, uint8_t * out);
+
+/* Encodes a complete frame into `out`, which needs room for
+ * len + len / 254 + 7 bytes, and returns its length. */
+size_t frame_encode(uint8_t type, uint8_t seq, const uint8_t * payload, size_t len, uint8_t * out);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**************************END OF FUNCTION PROTOTYPES**************************/
+
+#endif // End of header guard.
@@ -0,0 +1,209 @@
+/*------------------------------------------------------------------------------
+  frame_dump.c --
+
+  Description:
+    Reads a framed stream from one of the apps (a serial port, a capture
+    file or stdin), prints every record and keeps count of lost and corrupt
+    frames. With -q only the totals and the decode rate are printed, which
+    makes it usable as a line-rate check.
+
+    Build (from this directory):
+      cc -O2 -std=c99 frame_decode.c frame_dump.c -o frame_dump -lm
+
+    Usage:
+      frame_dump [-q] [file]
+
+      Set the port up first, e.g. `stty -F /dev/ttyUSB0 115200 raw -echo`.
+
+------------------------------------------------------------------------------*/
+
+/********************************DEPENDENCIES**********************************/
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "frame_decode.h"
+
+/*****************************END OF DEPENDENCIES******************************/
+
+
+/*****************************FUNCTION DEFINITIONS*****************************/
+
+static int16_t le16(const uint8_t * p)
+{
+  return (int16_t)(p[0] | (p[1] << 8));
+}
+
+static uint64_t le(const uint8_t * p, int bytes)
+{
+  uint64_t v = 0;
+
+  while(bytes--)
+  {
+    v = (v << 8) | p[bytes];
+  }
+
+  return v;
+}
+
+static void print_frame(void * ctx, uint8_t type, uint8_t seq,
+                        const uint8_t * payload, size_t len, uint32_t lost)
+{
+  size_t i;
+
+  if(*(int *)ctx)
+  {
+    return;
+  }
+
+  if(lost)
+  {
+    printf("# %u frame(s) lost\n", lost);
+  }
+
+  printf("%3u %02x", seq, type);
+
+  switch(type)
+  {
+    case FRAME_TYPE_ADC_SAMPLE:
+    case FRAME_TYPE_ADC_SWEEP:
+    case FRAME_TYPE_ACCEL:
+    case FRAME_TYPE_ATTITUDE:
+      for(i = 0; i + 1 < len; i += 2)
+      {
+        printf(" %d", le16(payload + i));
+      }
+      break;
+
+    case FRAME_TYPE_ADC_STATS:
+      // n=count, then per channel: ch, min, max, mean, rms
+      if(len >= 4)
+      {
+        unsigned n = (unsigned)le(payload + 2, 2);
+
+        printf(" n=%u", n);
+
+        for(i = 0; i < payload[1] && 4 + 16 * i + 16 <= len; i++)
+        {
+          const uint8_t * s = payload + 4 + 16 * i;
+          double sum = (int32_t)le(s + 4, 4);
+          double sum_sq = (double)le(s + 8, 8);
+
+          printf(" | ch%u %d %d %.2f %.2f", (unsigned)(payload[0] + i), le16(s),
+                 le16(s + 2), n ? sum / n : 0.0, n ? sqrt(sum_sq / n) : 0.0);
+        }
+      }
+      break;
+
+    case FRAME_TYPE_ADC_SCOPE:
+      // pre-trigger count and sample rate, then the results
+      if(len >= 8)
+      {
+        printf(" pre=%u %luHz", (unsigned)le(payload, 2), (unsigned long)le(payload + 4, 4));
+
+        for(i = 8; i + 1 < len; i += 2)
+        {
+          printf(" %d", le16(payload + i));
+        }
+      }
+      break;
+
+    case FRAME_TYPE_ADC_RANGED:
+      // the gain of each channel, then the results
+      if(len >= 2 && len >= 2u + payload[1])
+      {
+        size_t head = (2 + payload[1] + 1) & ~(size_t)1;
+
+        for(i = 0; i < payload[1]; i++)
+        {
+          printf(" ch%u=%ux", (unsigned)(payload[0] + i), 1u << (payload[2 + i] & 7));
+        }
+
+        for(i = head; i + 1 < len; i += 2)
+        {
+          printf(" %d", le16(payload + i));
+        }
+      }
+      break;
+
+    case FRAME_TYPE_ADC_LOST:
+      if(len >= 4)
+      {
+        printf(" dropped %u block(s) of %u sweeps", (unsigned)le(payload, 2),
+               (unsigned)le(payload + 2, 2));
+      }
+      break;
+
+    case FRAME_TYPE_ACCEL_TS:
+    case FRAME_TYPE_ATTITUDE_TS:
+      for(i = 0; i + 7 < len; i += 8)
+      {
+        printf(" %d %d %d +%u", le16(payload + i), le16(payload + i + 2),
+               le16(payload + i + 4), (uint16_t)le16(payload + i + 6));
+      }
+      break;
+
+    default:
+      for(i = 0; i < len; i++)
+      {
+        printf(" %02x", payload[i]);
+      }
+      break;
+  }
+
+  putchar('\n');
+}
+
+int main(int argc, char ** argv)
+{
+  static uint8_t chunk[65536];
+  frame_decoder_t dec;
+  FILE * in = stdin;
+  int quiet = 0;
+  struct timespec t0, t1;
+  size_t n;
+
+  for(int i = 1; i < argc; i++)
+  {
+    if(!strcmp(argv[i], "-q"))
+    {
+      quiet = 1;
+    }
+    else if(!(in = fopen(argv[i], "rb")))
+    {
+      perror(argv[i]);
+      return 2;
+    }
+  }
+
+  frame_decoder_init(&dec, print_frame, &quiet);
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+
+  while((n = fread(chunk, 1, sizeof(chunk), in)) > 0)
+  {
+    frame_decoder_feed(&dec, chunk, n);
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+
+  double secs = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+
+  fprintf(stderr, "%llu bytes, %llu frames, %llu lost, %llu bad crc, %llu bad cobs, %llu skipped",
+          (unsigned long long)dec.bytes, (unsigned long long)dec.frames,
+          (unsigned long long)dec.lost, (unsigned long long)dec.bad_crc,
+          (unsigned long long)dec.bad_cobs, (unsigned long long)dec.skipped);
+
+  if(secs > 0)
+  {
+    fprintf(stderr, ", %.1f MB/s", dec.bytes / secs / 1e6);
+  }
+
+  fputc('\n', stderr);
+
+  return 0;
+}
+
+/***************************END OF FUNCTION DEFINITIONS************************/
@@ -0,0 +1,20 @@
+#ifndef SIM_AVR_INTERRUPT_H_    // Header guard.
+#define SIM_AVR_INTERRUPT_H_
+
+/*------------------------------------------------------------------------------
+  avr/interrupt.h (host simulator) --
+
+  Description:
+    Interrupt vectors become ordinary functions that the simulator calls,
+    and sei()/cli() toggle the I bit of the simulated status register.
+
+------------------------------------------------------------------------------*/
+
+#include <avr/io.h>
+
+#define ISR(vector)     void vector(void)
+
+#define sei()           (CPU_SREG = (uint8_t)(CPU_SREG.value | CPU_I_bm))
+#define cli()           (CPU_SREG = (uint8_t)(CPU_SREG.value & ~CPU_I_bm))
+
+#endif // End of header guard.
@@ -0,0 +1,125 @@
+#ifndef SIM_AVR_IO_H_   // Header guard.
+#define SIM_AVR_IO_H_
+
+/*------------------------------------------------------------------------------
+  avr/io.h (host simulator) --
+
+  Description:
+    Stands in for the avr-libc device header when the IMU driver sources are
+    built for Linux by the IMU simulator. Only the ATxmega128A1U registers
+    that `spi.c` and `lsm6ds3.c` touch are provided.
+
+      Each register is a `sim_reg`, which behaves like a `register8_t` but
+    can forward reads and writes to the simulator (see `sim_avr.cpp`). The
+    driver sources are therefore compiled as C++.
+
+------------------------------------------------------------------------------*/
+
+/********************************DEPENDENCIES**********************************/
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*****************************END OF DEPENDENCIES******************************/
+
+
+/*******************************CUSTOM DATA TYPES******************************/
+
+/* An 8-bit I/O register. Without hooks it is plain storage. */
+struct sim_reg
+{
+  uint8_t value;
+
+  /* Called instead of storing `data`, or NULL. */
+  void (*on_write)(sim_reg * reg, uint8_t data);
+
+  /* Called after `value` has been read, or NULL. */
+  void (*on_read)(sim_reg * reg);
+
+  sim_reg & operator=(uint8_t data)
+  {
+    if(on_write) on_write(this, data);
+    else value = data;
+    return *this;
+  }
+
+  sim_reg & operator=(const sim_reg & other)
+  {
+    return *this = (uint8_t)other.value;
+  }
+
+  sim_reg & operator|=(uint8_t data) { return *this = (uint8_t)(value | data); }
+  sim_reg & operator&=(uint8_t data) { return *this = (uint8_t)(value & data); }
+
+  operator uint8_t()
+  {
+    uint8_t data = value;
+    if(on_read) on_read(this);
+    return data;
+  }
+};
+
+typedef struct PORT_struct
+{
+  sim_reg DIR, DIRSET, DIRCLR, DIRTGL;
+  sim_reg OUT, OUTSET, OUTCLR, OUTTGL;
+  sim_reg IN, INTCTRL, INT0MASK, INT1MASK, INTFLAGS, REMAP;
+  sim_reg PIN0CTRL, PIN1CTRL, PIN2CTRL, PIN3CTRL;
+  sim_reg PIN4CTRL, PIN5CTRL, PIN6CTRL, PIN7CTRL;
+}PORT_t;
+
+typedef struct SPI_struct
+{
+  sim_reg CTRL, INTCTRL, STATUS, DATA;
+}SPI_t;
+
+typedef struct PMIC_struct
+{
+  sim_reg STATUS, INTPRI, CTRL;
+}PMIC_t;
+
+/***************************END OF CUSTOM DATA TYPES***************************/
+
+
+/***********************************MACROS*************************************/
+
+extern PORT_t sim_portc;
+extern PORT_t sim_portf;
+extern SPI_t sim_spif;
+extern PMIC_t sim_pmic;
+extern sim_reg sim_sreg;
+
+#define PORTC       sim_portc
+#define PORTF       sim_portf
+#define SPIF        sim_spif
+#define PMIC        sim_pmic
+#define CPU_SREG    sim_sreg
+
+#define CPU_I_bm                0x80
+
+#define PMIC_LOLVLEX_bm         0x01
+#define PMIC_MEDLVLEX_bm        0x02
+#define PMIC_HILVLEX_bm         0x04
+#define PMIC_LOLVLEN_bm         0x01
+
+#define SPI_IF_bm               0x80
+#define SPI_ENABLE_bm           0x40
+#define SPI_MASTER_bm           0x10
+#define SPI_MODE_0_gc           (0x00<<2)
+#define SPI_MODE_3_gc           (0x03<<2)
+#define SPI_PRESCALER_DIV4_gc   (0x00<<0)
+#define SPI_INTLVL_OFF_gc       (0x00<<0)
+#define SPI_INTLVL_LO_gc        (0x01<<0)
+
+#define PIN0_bm                 0x01
+#define PIN1_bm                 0x02
+#define PIN2_bm                 0x04
+#define PIN3_bm                 0x08
+#define PIN4_bm                 0x10
+#define PIN5_bm                 0x20
+#define PIN6_bm                 0x40
+#define PIN7_bm                 0x80
+
+/********************************END OF MACROS*********************************/
+
+#endif // End of header guard.
@@ -0,0 +1,473 @@
+/*------------------------------------------------------------------------------
+  imu_sim.cpp --
+
+  Description:
+    Runs the IMU driver stack (`spi.c`, `lsm6ds3.c`) on a Linux host against
+    the simulated SPIF peripheral in `sim_avr.cpp` and the behavioral LSM6DS3
+    model in `lsm6ds3_model.cpp`.
+
+      Each driver mode reads a number of samples from the model at 1.66 kHz.
+    Every sample that reaches the driver's buffers is checked against the
+    motion trace it came from, and the bus bytes, chip select cycles, SPIF
+    interrupts and CPU time spent per sample are reported, together with
+    the sample rate the mode could sustain if the CPU did nothing else.
+
+      The register modes also count the bus bytes and chip select cycles
+    of every sample's read against what the mode has to cost: `legacy`,
+    the six single-register reads per sensor the apps used to make, 24
+    bytes and 12 chip selects; `burst`, one burst per sensor, 14 and 2;
+    `read_all` and `async`, the whole output block in one burst, 13 and 1.
+
+      The exit status is non-zero if any sample was corrupted or missed,
+    or a register read cost more or less than that, so the simulator can
+    gate throughput changes in CI.
+
+      The USART MSPI/DMA transport (`usart_spi.c`) is not simulated.
+
+    Build (from this directory):
+      g++ -std=c++11 -O2 -I. -I../../IMU_SPI_USART \
+          -x c++ ../../IMU_SPI_USART/spi.c ../../IMU_SPI_USART/lsm6ds3.c \
+          -x none sim_avr.cpp lsm6ds3_model.cpp imu_sim.cpp -o imu_sim
+
+    Usage:
+      imu_sim [-n samples] [-t trace.csv] [mode...]
+
+      Modes are `legacy`, `burst`, `read_all`, `async`, `fifo[=words]` and
+    `fifo_ts[=words]`; all of them run by default. A trace file holds one
+    sample per line as gyro x, y, z, accel x, y, z in raw LSBs, separated
+    by commas or spaces; lines starting with `#` are skipped. Without one,
+    a synthetic trace is used.
+
+------------------------------------------------------------------------------*/
+
+/********************************DEPENDENCIES**********************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <string>
+#include <vector>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "spi.h"
+#include "lsm6ds3.h"
+#include "lsm6ds3_registers.h"
+#include "sim_avr.h"
+#include "lsm6ds3_model.h"
+
+/*****************************END OF DEPENDENCIES******************************/
+
+
+/***********************************MACROS*************************************/
+
+#define SIM_DEFAULT_SAMPLES     2000
+#define SIM_DEFAULT_WATERMARK   96
+
+/* Largest FIFO batch drained at once, in words. */
+#define SIM_FIFO_BUF_WORDS      1536
+
+/********************************END OF MACROS*********************************/
+
+
+/*******************************CUSTOM DATA TYPES******************************/
+
+struct sim_result
+{
+  uint32_t delivered;
+  uint32_t missed;
+  uint32_t corrupt;
+  uint32_t bus_off;       // register reads off the mode's bus cost
+};
+
+/* SPI bytes and chip select cycles one sample's read costs in a register
+ * mode: address byte plus data for each transaction. */
+struct sim_bus_cost
+{
+  const char * mode;
+  uint8_t bytes;
+  uint8_t cs_cycles;
+};
+
+/***************************END OF CUSTOM DATA TYPES***************************/
+
+
+/******************************GLOBAL VARIABLES********************************/
+
+static const sim_bus_cost sim_bus_costs[] =
+{
+  {"legacy",   12 * 2, 12},
+  {"burst",    2 * (1 + 6), 2},
+  {"read_all", 1 + 12, 1},
+  {"async",    1 + 12, 1}
+};
+
+/***************************END OF GLOBAL VARIABLES****************************/
+
+
+/*****************************FUNCTION DEFINITIONS*****************************/
+
+static std::vector<lsm6ds3_sample> synthetic_trace(void)
+{
+  std::vector<lsm6ds3_sample> trace(4096);
+
+  for(size_t i = 0; i < trace.size(); i++)
+  {
+    double t = 2.0 * M_PI * (double)i / (double)trace.size();
+
+    trace[i].g[0] = (int16_t)lrint(9000.0 * sin(3.0 * t));
+    trace[i].g[1] = (int16_t)lrint(-7000.0 * cos(5.0 * t));
+    trace[i].g[2] = (int16_t)(i * 37 - 20000);
+    trace[i].xl[0] = (int16_t)lrint(4000.0 * sin(t));
+    trace[i].xl[1] = (int16_t)lrint(-3000.0 * sin(2.0 * t));
+    trace[i].xl[2] = (int16_t)(16384 + lrint(2000.0 * cos(7.0 * t)));
+  }
+
+  return trace;
+}
+
+static bool load_trace(const char * path, std::vector<lsm6ds3_sample> & trace)
+{
+  FILE * f = fopen(path, "r");
+  char line[256];
+
+  if(!f)
+  {
+    perror(path);
+    return false;
+  }
+
+  while(fgets(line, sizeof(line), f))
+  {
+    int v[6];
+    lsm6ds3_sample s;
+
+    if(line[0] == '#')
+    {
+      continue;
+    }
+
+    for(char * c = line; *c; c++)
+    {
+      if(*c == ',') *c = ' ';
+    }
+
+    if(sscanf(line, "%d %d %d %d %d %d", &v[0], &v[1], &v[2], &v[3], &v[4], &v[5]) != 6)
+    {
+      continue;
+    }
+
+    for(int i = 0; i < 3; i++)
+    {
+      s.g[i] = (int16_t)v[i];
+      s.xl[i] = (int16_t)v[i + 3];
+    }
+
+    trace.push_back(s);
+  }
+
+  fclose(f);
+
+  if(trace.empty())
+  {
+    fprintf(stderr, "%s: no samples\n", path);
+    return false;
+  }
+
+  return true;
+}
+
+// what the apps do at start-up: reset, then both sensors at 1.66 kHz.
+static void device_init(uint8_t int1_ctrl)
+{
+  spi_init();
+
+  lsm6ds3_write(CTRL3_C, 0b00000101);             // SW_RESET + IF_INC
+  lsm6ds3_write(CTRL1_XL, 0b10000000);            // 1.66 kHz, +/-2 g
+  lsm6ds3_write(CTRL2_G, 0b10000010);             // 1.66 kHz, 125 dps
+  lsm6ds3_write(INT1_CTRL, int1_ctrl);
+}
+
+// lets the model run until INT1 goes high.
+static void wait_int1(lsm6ds3_model & model)
+{
+  while(!model.int1())
+  {
+    sim_idle_until(model.next_event_ns());
+  }
+}
+
+static bool same(const int16_t * a, const int16_t * b)
+{
+  return memcmp(a, b, 3 * sizeof(int16_t)) == 0;
+}
+
+// counts a delivered sample with trace index `index`, and the ones skipped
+// since `*last`.
+static void account(sim_result & r, int64_t * last, uint32_t index)
+{
+  if(*last >= 0 && index > *last + 1)
+  {
+    r.missed += (uint32_t)(index - *last - 1);
+  }
+
+  *last = index;
+  r.delivered++;
+}
+
+// returns the bus cost of register mode `mode`.
+static const sim_bus_cost * bus_cost(const std::string & mode)
+{
+  for(size_t i = 0; i < sizeof(sim_bus_costs) / sizeof(sim_bus_costs[0]); i++)
+  {
+    if(mode == sim_bus_costs[i].mode)
+    {
+      return &sim_bus_costs[i];
+    }
+  }
+
+  return NULL;
+}
+
+static sim_result run_registers(lsm6ds3_model & model, const std::string & mode, uint32_t samples)
+{
+  sim_result r = {0, 0, 0, 0};
+  int64_t last = -1;
+  spi_xfer_t xfer;
+  const sim_bus_cost * cost = bus_cost(mode);
+
+  device_init(0x02);                                // INT1: gyro data ready
+
+  if(mode == "async")
+  {
+    PMIC.CTRL = PMIC_LOLVLEN_bm;
+    sei();
+  }
+
+  while(r.delivered < samples)
+  {
+    lsm6ds3_data_t data;
+    uint8_t raw[12];
+    uint32_t index;
+
+    wait_int1(model);
+    index = model.g_count - 1;
+
+    uint64_t bytes = model.bytes;
+    uint64_t cs_cycles = model.cs_cycles;
+
+    if(mode == "legacy")
+    {
+      uint8_t * b = &data.byte.accel_x_low;
+
+      for(uint8_t i = 0; i < 6; i++)
+      {
+        b[i] = lsm6ds3_read(OUTX_L_XL + i);
+      }
+
+      for(uint8_t i = 0; i < 6; i++)
+      {
+        b[i + 6] = lsm6ds3_read(OUTX_L_G + i);
+      }
+    }
+    else if(mode == "burst")
+    {
+      lsm6ds3_read_burst(OUTX_L_XL, &data.byte.accel_x_low, 6);
+      lsm6ds3_read_burst(OUTX_L_G, &data.byte.gyro_x_low, 6);
+    }
+    else if(mode == "read_all")
+    {
+      lsm6ds3_read_all(&data);
+    }
+    else
+    {
+      lsm6ds3_read_burst_async(&xfer, OUTX_L_G, raw, 12);
+      spi_wait(&xfer);
+
+      memcpy(&data.byte.gyro_x_low, raw, 6);
+      memcpy(&data.byte.accel_x_low, raw + 6, 6);
+    }
+
+    if(model.bytes - bytes != cost->bytes || model.cs_cycles - cs_cycles != cost->cs_cycles)
+    {
+      r.bus_off++;
+    }
+
+    const lsm6ds3_sample & s = model.trace_at(index);
+
+    if(!same(&data.word.gyro_x, s.g) || !same(&data.word.accel_x, s.xl))
+    {
+      r.corrupt++;
+    }
+
+    account(r, &last, index);
+  }
+
+  cli();
+
+  return r;
+}
+
+static sim_result run_fifo(lsm6ds3_model & model, bool timestamps, uint16_t watermark, uint32_t samples)
+{
+  static int16_t buf[SIM_FIFO_BUF_WORDS];
+  sim_result r = {0, 0, 0, 0};
+  int64_t last = -1;
+  uint16_t datasets = LSM6DS3_FIFO_DEC_G_NONE_gc | LSM6DS3_FIFO_DEC_XL_NONE_gc;
+  uint8_t set_words = 6;
+
+  device_init(LSM6DS3_INT_FTH_bm);
+
+  if(timestamps)
+  {
+    lsm6ds3_timestamp_init(1);
+    datasets |= LSM6DS3_FIFO_DEC_DS4_NONE_gc;
+    set_words = 9;
+  }
+
+  lsm6ds3_fifo_init(watermark, datasets, LSM6DS3_FIFO_ODR_1660HZ_gc);
+  model.popped.clear();
+
+  while(r.delivered < samples)
+  {
+    wait_int1(model);
+
+    uint16_t words = lsm6ds3_fifo_drain(buf, SIM_FIFO_BUF_WORDS, set_words);
+
+    for(uint16_t w = 0; w < words; w += set_words)
+    {
+      const int16_t * set = &buf[w];
+      lsm6ds3_model_pop g = model.popped[0];
+      lsm6ds3_model_pop xl = model.popped[1];
+
+      if(g.set != LSM6DS3_MODEL_SET_G || xl.set != LSM6DS3_MODEL_SET_XL ||
+         !same(set, model.trace_at(g.index).g) || !same(set + 3, model.trace_at(xl.index).xl))
+      {
+        r.corrupt++;
+      }
+
+      model.popped.erase(model.popped.begin(), model.popped.begin() + 2);
+
+      if(timestamps)
+      {
+        lsm6ds3_model_pop ts = model.popped[0];
+
+        if(ts.set != LSM6DS3_MODEL_SET_DS4 || lsm6ds3_fifo_timestamp(set + 6) != ts.index)
+        {
+          r.corrupt++;
+        }
+
+        model.popped.pop_front();
+      }
+
+      account(r, &last, g.index);
+    }
+  }
+
+  // sets dropped by a FIFO overrun never reached the buffer
+  r.missed += model.fifo_lost / set_words;
+
+  return r;
+}
+
+static bool run(const std::vector<lsm6ds3_sample> & trace, const std::string & arg, uint32_t samples)
+{
+  std::string mode = arg;
+  uint16_t watermark = SIM_DEFAULT_WATERMARK;
+  size_t eq = arg.find('=');
+  sim_result r;
+
+  if(eq != std::string::npos)
+  {
+    mode = arg.substr(0, eq);
+    watermark = (uint16_t)strtoul(arg.c_str() + eq + 1, NULL, 0);
+  }
+
+  lsm6ds3_model model(trace);
+  sim_attach(&model);
+
+  if(mode == "legacy" || mode == "burst" || mode == "read_all" || mode == "async")
+  {
+    r = run_registers(model, mode, samples);
+  }
+  else if((mode == "fifo" || mode == "fifo_ts") && watermark > 0 && watermark <= 0x0FFF &&
+          watermark <= SIM_FIFO_BUF_WORDS)
+  {
+    r = run_fifo(model, mode == "fifo_ts", watermark, samples);
+  }
+  else
+  {
+    fprintf(stderr, "unknown mode: %s\n", arg.c_str());
+    return false;
+  }
+
+  double rate = sim_busy_ns ? 1e9 * r.delivered / (double)sim_busy_ns : 0.0;
+
+  printf("%-14s %9u %6u %7u %10.2f %8.3f %8.2f %9.2f %11.0f\n",
+         arg.c_str(), r.delivered, r.missed, r.corrupt,
+         (double)model.bytes / r.delivered, (double)model.cs_cycles / r.delivered,
+         (double)sim_isr_count / r.delivered, (double)sim_busy_ns / r.delivered / 1000.0, rate);
+
+  if(r.bus_off)
+  {
+    printf("# %s: %u read(s) not %u bytes and %u chip select(s)\n", arg.c_str(), r.bus_off,
+           bus_cost(mode)->bytes, bus_cost(mode)->cs_cycles);
+  }
+
+  return r.missed == 0 && r.corrupt == 0 && r.bus_off == 0;
+}
+
+int main(int argc, char ** argv)
+{
+  std::vector<lsm6ds3_sample> trace;
+  std::vector<std::string> modes;
+  uint32_t samples = SIM_DEFAULT_SAMPLES;
+  bool ok = true;
+
+  for(int i = 1; i < argc; i++)
+  {
+    if(!strcmp(argv[i], "-n") && i + 1 < argc)
+    {
+      samples = (uint32_t)strtoul(argv[++i], NULL, 0);
+    }
+    else if(!strcmp(argv[i], "-t") && i + 1 < argc)
+    {
+      if(!load_trace(argv[++i], trace))
+      {
+        return 2;
+      }
+    }
+    else if(argv[i][0] == '-')
+    {
+      fprintf(stderr, "usage: %s [-n samples] [-t trace.csv] [mode...]\n", argv[0]);
+      return 2;
+    }
+    else
+    {
+      modes.push_back(argv[i]);
+    }
+  }
+
+  if(trace.empty())
+  {
+    trace = synthetic_trace();
+  }
+
+  if(modes.empty())
+  {
+    const char * all[] = {"legacy", "burst", "read_all", "async", "fifo", "fifo_ts"};
+    modes.assign(all, all + sizeof(all) / sizeof(all[0]));
+  }
+
+  printf("%-14s %9s %6s %7s %10s %8s %8s %9s %11s\n",
+         "mode", "samples", "missed", "corrupt", "bytes/smp", "cs/smp", "isr/smp", "us/smp", "max smp/s");
+
+  for(size_t i = 0; i < modes.size(); i++)
+  {
+    ok = run(trace, modes[i], samples) && ok;
+  }
+
+  return ok ? 0 : 1;
+}
+
+/***************************END OF FUNCTION DEFINITIONS************************/
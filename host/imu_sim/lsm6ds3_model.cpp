@@ -0,0 +1,521 @@
+/*------------------------------------------------------------------------------
+  lsm6ds3_model.cpp --
+
+  Description:
+    Behavioral LSM6DS3 model for the host IMU simulator. See
+    `lsm6ds3_model.h`.
+
+      FIFO decimation factors other than "no decimation" are treated as no
+    decimation, and only the gyro, accel and fourth (timestamp/step) data
+    sets are modelled; the third data set is always empty.
+
+------------------------------------------------------------------------------*/
+
+/********************************DEPENDENCIES**********************************/
+
+#include <string.h>
+#include "lsm6ds3_model.h"
+#include "lsm6ds3_registers.h"
+
+/*****************************END OF DEPENDENCIES******************************/
+
+
+/***********************************MACROS*************************************/
+
+#define WHO_AM_I_VALUE          0x69
+
+#define CTRL3_C_SW_RESET_bm     0x01
+#define CTRL3_C_IF_INC_bm       0x04
+
+#define CTRL5_C_ROUNDING_gm     0xE0
+#define CTRL5_C_ROUNDING_XL_G   0x60
+
+#define STATUS_XLDA_bm          0x01
+#define STATUS_GDA_bm           0x02
+
+#define INT_DRDY_XL_bm          0x01
+#define INT_DRDY_G_bm           0x02
+#define INT_FTH_bm              0x08
+
+#define FIFO_CTRL2_TIMER_EN_bm  0x80
+#define FIFO_MODE_gm            0x07
+#define FIFO_MODE_BYPASS        0x00
+#define FIFO_MODE_FIFO          0x01
+
+#define FIFO_STATUS2_WTM_bm     0x80
+#define FIFO_STATUS2_OVER_bm    0x40
+#define FIFO_STATUS2_FULL_bm    0x20
+#define FIFO_STATUS2_EMPTY_bm   0x10
+
+#define TAP_CFG_TIMER_EN_bm     0x80
+#define WAKE_UP_DUR_TIMER_HR_bm 0x10
+#define CTRL10_C_FUNC_EN_bm     0x04
+#define TIMESTAMP_RESET         0xAA
+
+/* FIFO depth in 16-bit words. */
+#define FIFO_WORDS              4096
+
+#define NEVER                   UINT64_MAX
+
+/********************************END OF MACROS*********************************/
+
+
+/******************************GLOBAL VARIABLES********************************/
+
+/* Sample period in ns for each ODR_XL / ODR_G / ODR_FIFO code. */
+static const uint64_t odr_period_ns[16] =
+{
+  NEVER, 80000000, 38461538, 19230769, 9615385, 4807692, 2403846, 1200480,
+  600240, 300120, 150060, NEVER, NEVER, NEVER, NEVER, NEVER
+};
+
+/***************************END OF GLOBAL VARIABLES****************************/
+
+
+/*****************************FUNCTION DEFINITIONS*****************************/
+
+lsm6ds3_model::lsm6ds3_model(const std::vector<lsm6ds3_sample> & trace)
+  : bytes(0), cs_cycles(0), trace_(trace), selected_(false), now_ns_(0)
+{
+  reset();
+}
+
+// power-on state. bus statistics survive a software reset.
+void lsm6ds3_model::reset(void)
+{
+  memset(regs_, 0, sizeof(regs_));
+
+  regs_[WHO_AM_I] = WHO_AM_I_VALUE;
+  regs_[CTRL3_C] = CTRL3_C_IF_INC_bm;
+
+  xl_count = 0;
+  g_count = 0;
+  fifo_sets = 0;
+  fifo_lost = 0;
+
+  fifo_.clear();
+  popped.clear();
+  pattern_pos_ = 0;
+  overrun_ = false;
+
+  ts_origin_ns_ = now_ns_;
+
+  xl_period_ = g_period_ = fifo_period_ = NEVER;
+  xl_next_ = g_next_ = fifo_next_ = NEVER;
+}
+
+const lsm6ds3_sample & lsm6ds3_model::trace_at(uint32_t n) const
+{
+  return trace_[n % trace_.size()];
+}
+
+// re-reads the ODR fields. a sensor that was off starts one period from now.
+void lsm6ds3_model::retime(void)
+{
+  uint64_t xl = odr_period_ns[regs_[CTRL1_XL] >> 4];
+  uint64_t g = odr_period_ns[regs_[CTRL2_G] >> 4];
+  uint64_t fifo = odr_period_ns[(regs_[FIFO_CTRL5] >> 3) & 0x0F];
+
+  if((regs_[FIFO_CTRL5] & FIFO_MODE_gm) == FIFO_MODE_BYPASS)
+  {
+    fifo = NEVER;
+  }
+
+  if(xl != xl_period_)
+  {
+    xl_next_ = (xl == NEVER) ? NEVER : now_ns_ + xl;
+    xl_period_ = xl;
+  }
+
+  if(g != g_period_)
+  {
+    g_next_ = (g == NEVER) ? NEVER : now_ns_ + g;
+    g_period_ = g;
+  }
+
+  if(fifo != fifo_period_)
+  {
+    fifo_next_ = (fifo == NEVER) ? NEVER : now_ns_ + fifo;
+    fifo_period_ = fifo;
+  }
+}
+
+uint64_t lsm6ds3_model::next_event_ns(void) const
+{
+  uint64_t next = xl_next_;
+
+  if(g_next_ < next) next = g_next_;
+  if(fifo_next_ < next) next = fifo_next_;
+
+  return next;
+}
+
+// sensors update their output registers before the FIFO samples them, so a
+// FIFO running at the sensor ODR picks up every sample exactly once.
+void lsm6ds3_model::advance(uint64_t now_ns)
+{
+  for(;;)
+  {
+    uint64_t next = next_event_ns();
+
+    if(next > now_ns)
+    {
+      break;
+    }
+
+    now_ns_ = next;
+
+    if(xl_next_ == next)
+    {
+      produce_xl();
+      xl_next_ += xl_period_;
+    }
+
+    if(g_next_ == next)
+    {
+      produce_g();
+      g_next_ += g_period_;
+    }
+
+    if(fifo_next_ == next)
+    {
+      produce_fifo();
+      fifo_next_ += fifo_period_;
+    }
+  }
+
+  now_ns_ = now_ns;
+}
+
+static void put_words(uint8_t * regs, const int16_t * v)
+{
+  for(int i = 0; i < 3; i++)
+  {
+    regs[2 * i] = (uint8_t)v[i];
+    regs[2 * i + 1] = (uint8_t)((uint16_t)v[i] >> 8);
+  }
+}
+
+void lsm6ds3_model::produce_xl(void)
+{
+  put_words(&regs_[OUTX_L_XL], trace_at(xl_count).xl);
+  regs_[STATUS_REG] |= STATUS_XLDA_bm;
+  xl_count++;
+}
+
+void lsm6ds3_model::produce_g(void)
+{
+  put_words(&regs_[OUTX_L_G], trace_at(g_count).g);
+  regs_[STATUS_REG] |= STATUS_GDA_bm;
+  g_count++;
+}
+
+uint32_t lsm6ds3_model::timestamp(void) const
+{
+  if(!(regs_[TAP_CFG] & TAP_CFG_TIMER_EN_bm) || !(regs_[CTRL10_C] & CTRL10_C_FUNC_EN_bm))
+  {
+    return 0;
+  }
+
+  uint64_t lsb_ns = (regs_[WAKE_UP_DUR] & WAKE_UP_DUR_TIMER_HR_bm) ? 25000 : 6400000;
+
+  return (uint32_t)((now_ns_ - ts_origin_ns_) / lsb_ns) & 0xFFFFFF;
+}
+
+bool lsm6ds3_model::ds_enabled(int set) const
+{
+  switch(set)
+  {
+    case LSM6DS3_MODEL_SET_G:   return (regs_[FIFO_CTRL3] >> 3) & 0x07;
+    case LSM6DS3_MODEL_SET_XL:  return regs_[FIFO_CTRL3] & 0x07;
+    case LSM6DS3_MODEL_SET_DS4: return ((regs_[FIFO_CTRL4] >> 3) & 0x07) &&
+                                       (regs_[FIFO_CTRL2] & FIFO_CTRL2_TIMER_EN_bm);
+  }
+
+  return false;
+}
+
+uint16_t lsm6ds3_model::fifo_pattern_len(void) const
+{
+  uint16_t len = 0;
+
+  for(int set = 0; set < LSM6DS3_MODEL_SETS; set++)
+  {
+    if(ds_enabled(set)) len += 3;
+  }
+
+  return len;
+}
+
+void lsm6ds3_model::push_set(int set, uint32_t index, const uint16_t * words)
+{
+  uint16_t len = fifo_pattern_len();
+
+  if(fifo_.size() + 3 > FIFO_WORDS)
+  {
+    if((regs_[FIFO_CTRL5] & FIFO_MODE_gm) == FIFO_MODE_FIFO)
+    {
+      overrun_ = true;
+      fifo_lost += 3;
+      return;
+    }
+
+    // continuous mode: the oldest set makes room
+    for(int i = 0; i < 3; i++)
+    {
+      fifo_.pop_front();
+    }
+
+    pattern_pos_ = (uint16_t)((pattern_pos_ + 3) % len);
+    overrun_ = true;
+    fifo_lost += 3;
+  }
+
+  for(int i = 0; i < 3; i++)
+  {
+    fifo_word w = {words[i], (uint8_t)(i ? LSM6DS3_MODEL_SETS : set), index};
+    fifo_.push_back(w);
+  }
+}
+
+// stores one data set of each enabled kind, in gyro, accel, fourth order.
+void lsm6ds3_model::produce_fifo(void)
+{
+  uint16_t words[3];
+
+  if(ds_enabled(LSM6DS3_MODEL_SET_G))
+  {
+    memcpy(words, &regs_[OUTX_L_G], 6);
+    push_set(LSM6DS3_MODEL_SET_G, g_count - 1, words);
+  }
+
+  if(ds_enabled(LSM6DS3_MODEL_SET_XL))
+  {
+    memcpy(words, &regs_[OUTX_L_XL], 6);
+    push_set(LSM6DS3_MODEL_SET_XL, xl_count - 1, words);
+  }
+
+  if(ds_enabled(LSM6DS3_MODEL_SET_DS4))
+  {
+    uint32_t ts = timestamp();
+    uint8_t b[6] = {(uint8_t)(ts >> 8), (uint8_t)(ts >> 16), 0, (uint8_t)ts,
+                    regs_[STEP_COUNTER_L], regs_[STEP_COUNTER_H]};
+
+    memcpy(words, b, 6);
+    push_set(LSM6DS3_MODEL_SET_DS4, ts, words);
+  }
+
+  fifo_sets++;
+}
+
+bool lsm6ds3_model::fifo_wtm(void) const
+{
+  uint16_t fth = (uint16_t)(((regs_[FIFO_CTRL2] & 0x0F) << 8) | regs_[FIFO_CTRL1]);
+
+  return fth && fifo_.size() >= fth;
+}
+
+static bool int_level(uint8_t ctrl, uint8_t status, bool wtm)
+{
+  return ((ctrl & INT_DRDY_XL_bm) && (status & STATUS_XLDA_bm)) ||
+         ((ctrl & INT_DRDY_G_bm) && (status & STATUS_GDA_bm)) ||
+         ((ctrl & INT_FTH_bm) && wtm);
+}
+
+bool lsm6ds3_model::int1(void) const
+{
+  return int_level(regs_[INT1_CTRL], regs_[STATUS_REG], fifo_wtm());
+}
+
+bool lsm6ds3_model::int2(void) const
+{
+  return int_level(regs_[INT2_CTRL], regs_[STATUS_REG], fifo_wtm());
+}
+
+uint8_t lsm6ds3_model::read(uint8_t addr)
+{
+  uint16_t words = (uint16_t)fifo_.size();
+  uint32_t ts;
+
+  switch(addr)
+  {
+    // the data-ready flags clear once the high half of any axis is read
+    case OUTX_H_XL: case OUTY_H_XL: case OUTZ_H_XL:
+      regs_[STATUS_REG] &= ~STATUS_XLDA_bm;
+      return regs_[addr];
+
+    case OUTX_H_G: case OUTY_H_G: case OUTZ_H_G:
+      regs_[STATUS_REG] &= ~STATUS_GDA_bm;
+      return regs_[addr];
+
+    case FIFO_STATUS1:
+      return (uint8_t)words;
+
+    case FIFO_STATUS2:
+      return (uint8_t)((fifo_wtm() ? FIFO_STATUS2_WTM_bm : 0) |
+                       (overrun_ ? FIFO_STATUS2_OVER_bm : 0) |
+                       (words >= FIFO_WORDS ? FIFO_STATUS2_FULL_bm : 0) |
+                       (words == 0 ? FIFO_STATUS2_EMPTY_bm : 0) |
+                       ((words >> 8) & 0x0F));
+
+    case FIFO_STATUS3:
+      return (uint8_t)pattern_pos_;
+
+    case FIFO_STATUS4:
+      return (uint8_t)((pattern_pos_ >> 8) & 0x03);
+
+    case FIFO_DATA_OUT_L:
+      return fifo_.empty() ? 0 : (uint8_t)fifo_.front().word;
+
+    // reading the high byte pops the word
+    case FIFO_DATA_OUT_H:
+    {
+      if(fifo_.empty())
+      {
+        return 0;
+      }
+
+      fifo_word w = fifo_.front();
+      fifo_.pop_front();
+
+      if(w.set < LSM6DS3_MODEL_SETS)
+      {
+        lsm6ds3_model_pop pop = {(uint8_t)w.set, w.index};
+        popped.push_back(pop);
+      }
+
+      if(fifo_pattern_len())
+      {
+        pattern_pos_ = (uint16_t)((pattern_pos_ + 1) % fifo_pattern_len());
+      }
+
+      return (uint8_t)(w.word >> 8);
+    }
+
+    case TIMESTAMP0_REG: case TIMESTAMP1_REG: case TIMESTAMP2_REG:
+      ts = timestamp();
+      return (uint8_t)(ts >> (8 * (addr - TIMESTAMP0_REG)));
+  }
+
+  return regs_[addr];
+}
+
+void lsm6ds3_model::write(uint8_t addr, uint8_t data)
+{
+  switch(addr)
+  {
+    // read-only
+    case WHO_AM_I: case STATUS_REG:
+    case FIFO_STATUS1: case FIFO_STATUS2: case FIFO_STATUS3: case FIFO_STATUS4:
+    case FIFO_DATA_OUT_L: case FIFO_DATA_OUT_H:
+    case TIMESTAMP0_REG: case TIMESTAMP1_REG:
+      return;
+
+    case TIMESTAMP2_REG:
+      if(data == TIMESTAMP_RESET)
+      {
+        ts_origin_ns_ = now_ns_;
+      }
+      return;
+
+    case CTRL3_C:
+      if(data & CTRL3_C_SW_RESET_bm)
+      {
+        reset();
+        return;
+      }
+      break;
+
+    case FIFO_CTRL5:
+      if((data & FIFO_MODE_gm) == FIFO_MODE_BYPASS)
+      {
+        fifo_.clear();
+        pattern_pos_ = 0;
+        overrun_ = false;
+      }
+      break;
+  }
+
+  if(addr >= OUTX_L_G && addr <= OUTZ_H_XL)
+  {
+    return;
+  }
+
+  regs_[addr] = data;
+
+  if(addr == CTRL1_XL || addr == CTRL2_G || addr == FIFO_CTRL5)
+  {
+    retime();
+  }
+}
+
+// address of the next register in a burst. with rounding the output
+// registers wrap from OUTZ_H_XL to OUTX_L_G, and FIFO_DATA_OUT always wraps
+// from the high byte back to the low byte.
+uint8_t lsm6ds3_model::next_addr(uint8_t addr) const
+{
+  if(!(regs_[CTRL3_C] & CTRL3_C_IF_INC_bm))
+  {
+    return addr;
+  }
+
+  if(addr == OUTZ_H_XL && (regs_[CTRL5_C] & CTRL5_C_ROUNDING_gm) == CTRL5_C_ROUNDING_XL_G)
+  {
+    return OUTX_L_G;
+  }
+
+  if(addr == FIFO_DATA_OUT_H)
+  {
+    return FIFO_DATA_OUT_L;
+  }
+
+  return (uint8_t)((addr + 1) & 0x7F);
+}
+
+void lsm6ds3_model::cs(bool asserted)
+{
+  if(asserted && !selected_)
+  {
+    cs_cycles++;
+    first_ = true;
+  }
+
+  selected_ = asserted;
+}
+
+// the first byte of each transaction is the command: read strobe in bit 7,
+// register address below it. MISO idles high during the command byte.
+uint8_t lsm6ds3_model::transfer(uint8_t mosi)
+{
+  uint8_t miso = 0xFF;
+
+  if(!selected_)
+  {
+    return miso;
+  }
+
+  bytes++;
+
+  if(first_)
+  {
+    first_ = false;
+    reading_ = (mosi & 0x80) != 0;
+    addr_ = mosi & 0x7F;
+    return miso;
+  }
+
+  if(reading_)
+  {
+    miso = read(addr_);
+  }
+  else
+  {
+    write(addr_, mosi);
+  }
+
+  addr_ = next_addr(addr_);
+
+  return miso;
+}
+
+/***************************END OF FUNCTION DEFINITIONS************************/
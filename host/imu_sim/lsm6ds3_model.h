@@ -0,0 +1,144 @@
+#ifndef LSM6DS3_MODEL_H_    // Header guard.
+#define LSM6DS3_MODEL_H_
+
+/*------------------------------------------------------------------------------
+  lsm6ds3_model.h --
+
+  Description:
+    Behavioral model of the LSM6DS3 as seen over SPI, for the host IMU
+    simulator. Covers what the drivers in IMU_SPI_USART rely on:
+
+      - the register map of `lsm6ds3_registers.h`, SW_RESET and WHO_AM_I
+      - IF_INC auto-increment and CTRL5_C rounding of burst reads
+      - gyro/accel output data rates from CTRL1_XL/CTRL2_G, STATUS_REG
+        data-ready flags and the DRDY/FTH routing of INT1_CTRL/INT2_CTRL
+      - the FIFO: data sets from FIFO_CTRL3/4, continuous/FIFO/bypass modes,
+        watermark, overrun, FIFO_STATUS1..4 and FIFO_DATA_OUT pops
+      - the timestamp counter, including the fourth FIFO data set
+
+    Samples come from a motion trace (gyro x, y, z, accel x, y, z in LSBs)
+    that is replayed in a loop. Time is driven by the simulator in ns.
+
+------------------------------------------------------------------------------*/
+
+/********************************DEPENDENCIES**********************************/
+
+#include <stdint.h>
+#include <vector>
+#include <deque>
+
+/*****************************END OF DEPENDENCIES******************************/
+
+
+/*******************************CUSTOM DATA TYPES******************************/
+
+/* One trace entry: gyro x, y, z then accel x, y, z. */
+struct lsm6ds3_sample
+{
+  int16_t g[3];
+  int16_t xl[3];
+};
+
+/* FIFO data sets, in the order they are stored. */
+enum
+{
+  LSM6DS3_MODEL_SET_G,
+  LSM6DS3_MODEL_SET_XL,
+  LSM6DS3_MODEL_SET_DS4,
+  LSM6DS3_MODEL_SETS
+};
+
+/* A data set that left the FIFO: its kind, and the trace index of the
+ * sample it carried (or the timestamp, for the fourth data set). */
+struct lsm6ds3_model_pop
+{
+  uint8_t set;
+  uint32_t index;
+};
+
+class lsm6ds3_model
+{
+public:
+  explicit lsm6ds3_model(const std::vector<lsm6ds3_sample> & trace);
+
+  /* Power-on / SW_RESET state. */
+  void reset(void);
+
+  /* Produces every sample due up to `now_ns`. */
+  void advance(uint64_t now_ns);
+
+  /* Time of the next sample, or UINT64_MAX if nothing is running. */
+  uint64_t next_event_ns(void) const;
+
+  /* SPI slave side: chip select level and one full-duplex byte. */
+  void cs(bool asserted);
+  uint8_t transfer(uint8_t mosi);
+
+  /* Interrupt pin levels. */
+  bool int1(void) const;
+  bool int2(void) const;
+
+  /* Trace entry `n` (wrapping), for checking what the driver read. */
+  const lsm6ds3_sample & trace_at(uint32_t n) const;
+
+  /* Samples produced so far by each sensor, and FIFO sets pushed. */
+  uint32_t xl_count, g_count, fifo_sets;
+
+  /* Words lost to FIFO overrun. */
+  uint32_t fifo_lost;
+
+  /* Bus statistics. */
+  uint64_t bytes, cs_cycles;
+
+  /* Data sets read out of the FIFO, oldest first. Consumers pop them. */
+  std::deque<lsm6ds3_model_pop> popped;
+
+private:
+  uint8_t read(uint8_t addr);
+  void write(uint8_t addr, uint8_t data);
+  uint8_t next_addr(uint8_t addr) const;
+
+  void retime(void);
+  void produce_xl(void);
+  void produce_g(void);
+  void produce_fifo(void);
+  void push_set(int set, uint32_t index, const uint16_t * words);
+  bool ds_enabled(int set) const;
+  bool fifo_wtm(void) const;
+  uint32_t timestamp(void) const;
+  uint16_t fifo_pattern_len(void) const;
+
+  /* A FIFO word, tagged on the first word of each data set. */
+  struct fifo_word
+  {
+    uint16_t word;
+    uint8_t set;        // LSM6DS3_MODEL_SETS on the other words
+    uint32_t index;
+  };
+
+  const std::vector<lsm6ds3_sample> & trace_;
+
+  uint8_t regs_[0x80];
+
+  /* SPI transaction state. */
+  bool selected_;
+  bool first_;
+  bool reading_;
+  uint8_t addr_;
+
+  /* Sample clocks. */
+  uint64_t now_ns_;
+  uint64_t xl_period_, g_period_, fifo_period_;
+  uint64_t xl_next_, g_next_, fifo_next_;
+
+  /* FIFO contents and read position within the data-set pattern. */
+  std::deque<fifo_word> fifo_;
+  uint16_t pattern_pos_;
+  bool overrun_;
+
+  uint64_t ts_origin_ns_;
+};
+
+/***************************END OF CUSTOM DATA TYPES***************************/
+
+#endif // End of header guard.
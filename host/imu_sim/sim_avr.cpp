@@ -0,0 +1,164 @@
+/*------------------------------------------------------------------------------
+  sim_avr.cpp --
+
+  Description:
+    Simulated ATxmega128A1U peripherals. See `sim_avr.h`.
+
+------------------------------------------------------------------------------*/
+
+/********************************DEPENDENCIES**********************************/
+
+#include <stddef.h>
+#include <avr/io.h>
+#include "sim_avr.h"
+#include "spi.h"
+
+/*****************************END OF DEPENDENCIES******************************/
+
+
+/******************************GLOBAL VARIABLES********************************/
+
+PORT_t sim_portc;
+PORT_t sim_portf;
+SPI_t sim_spif;
+PMIC_t sim_pmic;
+sim_reg sim_sreg;
+
+uint64_t sim_now_ns = 0;
+uint64_t sim_busy_ns = 0;
+uint64_t sim_isr_count = 0;
+
+static lsm6ds3_model * sim_model = NULL;
+
+/***************************END OF GLOBAL VARIABLES****************************/
+
+
+/*****************************FUNCTION DEFINITIONS*****************************/
+
+void SPIF_INT_vect(void);
+
+static void sim_spend(uint64_t ns)
+{
+  sim_now_ns += ns;
+  sim_busy_ns += ns;
+
+  sim_model->advance(sim_now_ns);
+}
+
+void sim_idle_until(uint64_t t_ns)
+{
+  if(t_ns > sim_now_ns)
+  {
+    sim_now_ns = t_ns;
+    sim_model->advance(sim_now_ns);
+  }
+}
+
+// takes the SPIF interrupt for as long as it is pending and can be taken.
+// the handler runs with PMIC.STATUS showing a low-level interrupt in
+// progress, which also keeps this from nesting.
+static void sim_dispatch(void)
+{
+  while((sim_spif.STATUS.value & SPI_IF_bm) &&
+        (sim_spif.INTCTRL.value & 0x03) &&
+        (sim_pmic.CTRL.value & PMIC_LOLVLEN_bm) &&
+        (sim_sreg.value & CPU_I_bm) &&
+        !sim_pmic.STATUS.value)
+  {
+    sim_spif.STATUS.value &= ~SPI_IF_bm;
+    sim_pmic.STATUS.value = PMIC_LOLVLEX_bm;
+    sim_isr_count++;
+    sim_spend(SIM_ISR_NS);
+
+    SPIF_INT_vect();
+
+    sim_pmic.STATUS.value = 0;
+  }
+}
+
+// a write to DATA shifts a byte out to the LSM6DS3 and its reply in.
+static void sim_spif_data_write(sim_reg * reg, uint8_t data)
+{
+  sim_spend(SIM_SPI_BYTE_NS + SIM_BYTE_CPU_NS);
+
+  reg->value = sim_model->transfer(data);
+  sim_spif.STATUS.value |= SPI_IF_bm;
+
+  sim_dispatch();
+}
+
+// reading DATA after STATUS clears the flag.
+static void sim_spif_data_read(sim_reg * reg)
+{
+  (void)reg;
+  sim_spif.STATUS.value &= ~SPI_IF_bm;
+}
+
+static void sim_dispatching_write(sim_reg * reg, uint8_t data)
+{
+  reg->value = data;
+  sim_dispatch();
+}
+
+static void sim_portf_outset(sim_reg * reg, uint8_t data)
+{
+  (void)reg;
+
+  if((data & SS_bm) && !(sim_portf.OUT.value & SS_bm))
+  {
+    sim_spend(SIM_CS_NS);
+    sim_model->cs(false);
+  }
+
+  sim_portf.OUT.value |= data;
+}
+
+static void sim_portf_outclr(sim_reg * reg, uint8_t data)
+{
+  (void)reg;
+
+  if((data & SS_bm) && (sim_portf.OUT.value & SS_bm))
+  {
+    sim_spend(SIM_CS_NS);
+    sim_model->cs(true);
+  }
+
+  sim_portf.OUT.value &= ~data;
+}
+
+// clears `count` registers starting at `reg`, hooks included.
+static void sim_clear(sim_reg * reg, size_t count)
+{
+  for(size_t i = 0; i < count; i++)
+  {
+    reg[i].value = 0;
+    reg[i].on_write = NULL;
+    reg[i].on_read = NULL;
+  }
+}
+
+void sim_attach(lsm6ds3_model * model)
+{
+  sim_clear(&sim_portc.DIR, sizeof(sim_portc) / sizeof(sim_reg));
+  sim_clear(&sim_portf.DIR, sizeof(sim_portf) / sizeof(sim_reg));
+  sim_clear(&sim_spif.CTRL, sizeof(sim_spif) / sizeof(sim_reg));
+  sim_clear(&sim_pmic.STATUS, sizeof(sim_pmic) / sizeof(sim_reg));
+  sim_clear(&sim_sreg, 1);
+
+  sim_model = model;
+  sim_now_ns = 0;
+  sim_busy_ns = 0;
+  sim_isr_count = 0;
+
+  sim_spif.DATA.on_write = sim_spif_data_write;
+  sim_spif.DATA.on_read = sim_spif_data_read;
+  sim_spif.INTCTRL.on_write = sim_dispatching_write;
+  sim_pmic.CTRL.on_write = sim_dispatching_write;
+  sim_sreg.on_write = sim_dispatching_write;
+
+  sim_portf.OUT.value = SS_bm;
+  sim_portf.OUTSET.on_write = sim_portf_outset;
+  sim_portf.OUTCLR.on_write = sim_portf_outclr;
+}
+
+/***************************END OF FUNCTION DEFINITIONS************************/
@@ -0,0 +1,58 @@
+#ifndef SIM_AVR_H_    // Header guard.
+#define SIM_AVR_H_
+
+/*------------------------------------------------------------------------------
+  sim_avr.h --
+
+  Description:
+    Simulated ATxmega128A1U peripherals for the host IMU simulator: PORTF
+    chip select, SPIF and the low-level interrupt path into `SPIF_INT_vect`.
+
+      Time only moves while the CPU is talking to the LSM6DS3. Each SPI byte
+    costs SIM_SPI_BYTE_NS on the bus plus SIM_BYTE_CPU_NS of driver code,
+    each SPIF interrupt SIM_ISR_NS of entry/exit and each chip select edge
+    SIM_CS_NS. All of it is counted in `sim_busy_ns`, so samples delivered
+    per busy second is the ceiling for a driver mode. The CPU figures are
+    estimates for the 32 MHz clock, not measurements.
+
+------------------------------------------------------------------------------*/
+
+/********************************DEPENDENCIES**********************************/
+
+#include <stdint.h>
+#include "lsm6ds3_model.h"
+
+/*****************************END OF DEPENDENCIES******************************/
+
+
+/***********************************MACROS*************************************/
+
+/* SPIF at F_CPU / 4 = 8 MHz. */
+#define SIM_SPI_BYTE_NS     1000
+#define SIM_BYTE_CPU_NS     250
+#define SIM_ISR_NS          1250
+#define SIM_CS_NS           125
+
+/********************************END OF MACROS*********************************/
+
+
+/******************************GLOBAL VARIABLES********************************/
+
+extern uint64_t sim_now_ns;
+extern uint64_t sim_busy_ns;
+extern uint64_t sim_isr_count;
+
+/***************************END OF GLOBAL VARIABLES****************************/
+
+
+/*****************************FUNCTION PROTOTYPES******************************/
+
+/* Resets the peripherals and connects `model` to PORTF/SPIF. */
+void sim_attach(lsm6ds3_model * model);
+
+/* Lets time pass with the CPU idle, up to `t_ns`. */
+void sim_idle_until(uint64_t t_ns);
+
+/**************************END OF FUNCTION PROTOTYPES**************************/
+
+#endif // End of header guard.
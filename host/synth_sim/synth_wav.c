@@ -0,0 +1,631 @@
+/*------------------------------------------------------------------------------
+  synth_wav.c --
+
+  Description:
+    Runs the synthesizer app's DDS engine (`synth.c`) on a Linux host:
+    renders a short piece (single notes, chords, every shape of the
+    wavetable bank, all SYNTH_VOICES voices at once, and a song played by
+    the sequencer, `seq.c`, with keys struck over it) to a 16-bit mono
+    WAV file at SYNTH_RATE, then times
+    the renderer with 0 to SYNTH_VOICES voices sounding and reports the
+    cost per sample and per voice, in ns and in host cycles where the
+    cycle counter can be read.
+
+      Host timings say nothing about the AVR, which has F_CPU / SYNTH_RATE
+    (2000) cycles per sample for everything. So the work of every block
+    rendered (voices sounding, ramping and crossfading, read from the
+    engine's state before the block) is also counted and weighed with
+    AVR cycle costs estimated by hand from the instruction sequences of
+    the renderer's loops, AVR_CYC_* below; the worst block of the piece,
+    and every voice ramping and crossfading at once, are reported against
+    that budget. An estimate, not a measurement, so it is only printed;
+    it can gate the exit status once an AVR simulator gives the exact
+    figure.
+
+      The DAC codes are written as they would be converted, (code - 0x800)
+    * 16, so the file shows clipping and level exactly as the DAC would
+    play them. The exit status is non-zero unless a held sine A4 rendered
+    alone measures 440 Hz to within 0.1 Hz (zero crossings over 10 s) with
+    a signal to noise ratio of at least WAV_MIN_SNR against an ideal sine
+    (DC offset aside),
+    which the table interpolation and the DAC's 12 bits allow, and unless
+    switching a held C4 back and forth between sine and triangle, at many
+    phases, keeps the largest step between samples within WAV_MAX_STEP of
+    the largest either shape makes by itself, i.e. switches without a
+    click, and unless the song takes exactly as many ticks as its events
+    add up to and, as it ends each note, leaves a key held on the same
+    note sounding, and unless a note struck while every voice releases
+    takes the quietest of them.
+
+    Build (from this directory):
+      cc -O2 -std=c99 -I../../IMU_SPI_USART ../../IMU_SPI_USART/synth.c ../../IMU_SPI_USART/synth_waves.c ../../IMU_SPI_USART/seq.c synth_wav.c -o synth_wav -lm
+
+    Usage:
+      synth_wav [out.wav]       (default synth.wav)
+
+------------------------------------------------------------------------------*/
+
+/********************************DEPENDENCIES**********************************/
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "seq.h"
+#include "synth.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SYNTH_TSC       1
+#include <x86intrin.h>
+#endif
+
+/*****************************END OF DEPENDENCIES******************************/
+
+
+/***********************************MACROS*************************************/
+
+/* Samples per render call, as the app's DMA blocks. */
+#define WAV_BLOCK       64
+
+/* Blocks per timing pass. */
+#define BENCH_BLOCKS    20000
+
+/* Least signal to noise ratio of the A4, dB. */
+#define WAV_MIN_SNR     60.0
+
+/* Largest step while switching shapes, relative to steady playing. */
+#define WAV_MAX_STEP    1.25
+
+/* The app's CPU clock (clock.h), and the AVR cycles there are per sample. */
+#ifndef F_CPU
+#define F_CPU           32000000UL
+#endif
+
+#define AVR_BUDGET      (F_CPU / SYNTH_RATE)
+
+/* Estimated AVR cycles of `synth_render`, avr-gcc -O2, from the timings
+ * of the instructions its loops compile to: LPM 3, LD/ST 2, MUL 2, and
+ * about 20 for each 16 x 8 bit widening multiply, done by a library call
+ * (CALL 3, RET 5 on the XMEGA's 3-byte PC).
+ *   SAMPLE        clearing one mix sample, then shifting, offsetting,
+ *                 clamping and storing it
+ *   VOICE         one sample of a held voice: 4 LPM and their addressing
+ *                 (24), interpolation and level multiplies (48), adding
+ *                 into the mix (8), phase and loop (8), spills (12)
+ *   RAMP          more per sample while the level ramps (the general loop)
+ *   FADE          more per sample while crossfading: the other table's 2
+ *                 LPM and addressing, a multiply, the blend
+ *   VOICE_BLOCK   per voice and block: its state in and out, the gate
+ *   BLOCK         per block: the DMA interrupt's prologue and epilogue,
+ *                 the refill and the render call */
+#define AVR_CYC_SAMPLE          24
+#define AVR_CYC_VOICE           100
+#define AVR_CYC_RAMP            12
+#define AVR_CYC_FADE            60
+#define AVR_CYC_VOICE_BLOCK     60
+#define AVR_CYC_BLOCK           200
+
+/********************************END OF MACROS*********************************/
+
+
+/******************************GLOBAL VARIABLES********************************/
+
+/* The first phrase of the app's song, a beat's rest, and the last note. */
+static const seq_event_t wav_song[] =
+{
+  {88, 160, 8, 2}, {86, 160, 8, 2}, {84, 160, 8, 2}, {86, 160, 8, 2},
+  {88, 160, 8, 2}, {88, 160, 8, 2}, {88, 160, 16, 4}, {0, 0, 8, 0},
+  {84, 160, 16, 2}
+};
+
+/* Ticks the last song took. */
+static unsigned long wav_song_ticks;
+
+/* Estimated AVR cycles per sample of the costliest full block rendered. */
+static double wav_avr_worst;
+
+/***************************END OF GLOBAL VARIABLES****************************/
+
+
+/*****************************FUNCTION DEFINITIONS*****************************/
+
+static double now_s(void)
+{
+  struct timespec t;
+
+  clock_gettime(CLOCK_MONOTONIC, &t);
+
+  return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+static uint64_t now_cycles(void)
+{
+#ifdef SYNTH_TSC
+  return __rdtsc();
+#else
+  return 0;
+#endif
+}
+
+static void put16(FILE * f, unsigned v)
+{
+  fputc((int)(v & 0xFF), f);
+  fputc((int)((v >> 8) & 0xFF), f);
+}
+
+static void put32(FILE * f, unsigned long v)
+{
+  put16(f, (unsigned)(v & 0xFFFF));
+  put16(f, (unsigned)(v >> 16));
+}
+
+static void wav_header(FILE * f, unsigned long samples)
+{
+  fwrite("RIFF", 1, 4, f);
+  put32(f, 36 + samples * 2);
+  fwrite("WAVEfmt ", 1, 8, f);
+  put32(f, 16);
+  put16(f, 1);                      // PCM
+  put16(f, 1);                      // mono
+  put32(f, SYNTH_RATE);
+  put32(f, SYNTH_RATE * 2);
+  put16(f, 2);
+  put16(f, 16);
+  fwrite("data", 1, 4, f);
+  put32(f, samples * 2);
+}
+
+/* Estimated AVR cycles `synth_render` will take for the next `n`
+ * samples, from the work the engine's state calls for. */
+static unsigned long avr_cycles(const synth_t * syn, uint16_t n)
+{
+  unsigned long cyc = AVR_CYC_BLOCK + (unsigned long)AVR_CYC_SAMPLE * n;
+
+  for(int v = 0; v < SYNTH_VOICES; v++)
+  {
+    const synth_voice_t * voice = &syn->voice[v];
+    unsigned fade = (syn->shape_next != syn->shape) ? SYNTH_FADE : voice->fade;
+
+    if(!voice->level && !voice->target)
+    {
+      continue;
+    }
+
+    cyc += AVR_CYC_VOICE_BLOCK + (unsigned long)AVR_CYC_VOICE * n;
+
+    if(voice->level != voice->target || fade)
+    {
+      cyc += (unsigned long)AVR_CYC_RAMP * n + (unsigned long)AVR_CYC_FADE * (fade < n ? fade : n);
+    }
+  }
+
+  return cyc;
+}
+
+/* Renders `n` samples, to `f` if not NULL; returns `n`. */
+static unsigned long render_samples(synth_t * syn, FILE * f, unsigned long n)
+{
+  uint16_t block[WAV_BLOCK];
+
+  for(unsigned long i = 0; i < n; i += WAV_BLOCK)
+  {
+    uint16_t len = (uint16_t)(n - i < WAV_BLOCK ? n - i : WAV_BLOCK);
+
+    // the app only renders whole blocks
+    if(len == WAV_BLOCK && avr_cycles(syn, len) / (double)len > wav_avr_worst)
+    {
+      wav_avr_worst = avr_cycles(syn, len) / (double)len;
+    }
+
+    synth_render(syn, block, len);
+
+    for(int k = 0; f && k < len; k++)
+    {
+      put16(f, (unsigned)(((int)block[k] - SYNTH_DAC_MID) * 16));
+    }
+  }
+
+  return n;
+}
+
+/* Renders `ms` milliseconds in whole blocks, to `f` if not NULL; returns
+ * samples. */
+static unsigned long render(synth_t * syn, FILE * f, unsigned ms)
+{
+  return render_samples(syn, f, SYNTH_RATE * ms / 1000 / WAV_BLOCK * WAV_BLOCK);
+}
+
+/* Plays `song` through the sequencer at `bpm`, ticked every tick's worth
+ * of samples as the app's timer would, striking a key every 12 ticks;
+ * returns samples and leaves the ticks played in `wav_song_ticks`. */
+static unsigned long play_song(synth_t * syn, FILE * f, const seq_event_t * song,
+                               uint16_t len, unsigned bpm)
+{
+  double per_tick = SYNTH_RATE * 60.0 / SEQ_TICKS_PER_MINUTE(bpm);
+  double due = 0;
+  unsigned long n = 0;
+  seq_t seq;
+
+  seq_init(&seq);
+  seq_play(&seq, syn, song, len);
+  wav_song_ticks = 0;
+
+  while(seq_tick(&seq, syn))
+  {
+    if(wav_song_ticks++ % 12 == 6)
+    {
+      synth_note_on(syn, 96, 80, SYNTH_RATE / 10);
+    }
+
+    due += per_tick;
+    n += render_samples(syn, f, (unsigned long)due - n);
+  }
+
+  return n;
+}
+
+/* The piece: the app's octave of keys, a C major chord, a melody over
+ * it, a scale in every shape, every voice at once, then the song. */
+static unsigned long piece(synth_t * syn, FILE * f)
+{
+  static const uint8_t melody[] = {88, 86, 84, 86, 88, 88, 88};
+  unsigned long n = 0;
+
+  synth_init(syn);
+
+  for(uint8_t i = 0; i < 12; i++)
+  {
+    synth_note_on(syn, (uint8_t)(84 + i), 160, SYNTH_RATE / 4);
+    n += render(syn, f, 300);
+  }
+
+  synth_set_shape(syn, SYNTH_TRIANGLE);
+  synth_note_on(syn, 60, 100, 0);
+  synth_note_on(syn, 64, 100, 0);
+  synth_note_on(syn, 67, 100, 0);
+  n += render(syn, f, 500);
+
+  // the chord changes timbre as it holds
+  synth_set_shape(syn, SYNTH_SAW);
+  n += render(syn, f, 500);
+  synth_set_shape(syn, SYNTH_SINE);
+
+  for(unsigned i = 0; i < sizeof(melody); i++)
+  {
+    synth_note_on(syn, melody[i], 160, SYNTH_RATE / 2);
+    n += render(syn, f, 625);
+  }
+
+  synth_note_off(syn, 60);
+  synth_note_off(syn, 64);
+  synth_note_off(syn, 67);
+  n += render(syn, f, 250);
+
+  // two octaves of C major every 4 semitones or so, through the bands
+  for(uint8_t shape = 0; shape < SYNTH_SHAPES; shape++)
+  {
+    synth_set_shape(syn, shape);
+
+    for(uint8_t note = 36; note <= 108; note += 12)
+    {
+      synth_note_on(syn, note, 160, SYNTH_RATE / 5);
+      n += render(syn, f, 250);
+    }
+  }
+
+  for(uint8_t v = 0; v < SYNTH_VOICES; v++)
+  {
+    synth_note_on(syn, (uint8_t)(48 + 7 * v), 60, SYNTH_RATE);
+  }
+
+  n += render(syn, f, 1500);
+
+  synth_set_shape(syn, SYNTH_TRIANGLE);
+  n += play_song(syn, f, wav_song, sizeof(wav_song) / sizeof(wav_song[0]), 120);
+  n += render(syn, f, 250);
+
+  return n;
+}
+
+/* Whether a key held on the song's first note still sounds once the
+ * sequencer has played that note over it and released it. */
+static int key_kept(synth_t * syn)
+{
+  seq_t seq;
+  uint16_t key;
+
+  synth_init(syn);
+  key = synth_note_on(syn, wav_song[0].note, 160, 0);
+
+  seq_init(&seq);
+  seq_play(&seq, syn, wav_song, 1);
+
+  while(seq_tick(&seq, syn));
+
+  return syn->voice[(uint8_t)key].target == 160;
+}
+
+/* Whether a note struck with every voice releasing takes the quietest
+ * one. The voices are released last first, a little apart, so the
+ * quietest is not the first one releasing. */
+static int quietest_stolen(synth_t * syn)
+{
+  static uint16_t block[WAV_BLOCK];
+  uint16_t voice[SYNTH_VOICES];
+
+  synth_init(syn);
+
+  for(int v = 0; v < SYNTH_VOICES; v++)
+  {
+    voice[v] = synth_note_on(syn, (uint8_t)(57 + 5 * v), 255, 0);
+  }
+
+  // up to full level
+  for(int b = 0; b < 8; b++)
+  {
+    synth_render(syn, block, WAV_BLOCK);
+  }
+
+  // each ramps down one step per sample, so 16 samples apart none is
+  // silent (free) yet when the last is released
+  for(int v = SYNTH_VOICES - 1; v >= 0; v--)
+  {
+    synth_voice_off(syn, voice[v]);
+    synth_render(syn, block, 16);
+  }
+
+  return (uint8_t)synth_note_on(syn, 100, 255, 0) == SYNTH_VOICES - 1;
+}
+
+/* Frequency of a held A4, from its rising zero crossings, and its signal
+ * to noise ratio in dB. */
+static double measure_a4(synth_t * syn, double * snr)
+{
+  uint16_t block[WAV_BLOCK];
+  unsigned long crossings = 0;
+  double first = -1, last = 0;
+  unsigned long t = 0;
+  int prev = 0;
+  double err = 0, err_sq = 0;
+
+  // one voice at full level, through the mix
+  const double amp = SYNTH_WAVE_PEAK * 255.0 / 256.0 / (1 << SYNTH_MIX_SHIFT);
+
+  synth_init(syn);
+  synth_note_on(syn, 69, 255, 0);
+
+  // let the level settle first
+  for(int b = 0; b < 16; b++)
+  {
+    synth_render(syn, block, WAV_BLOCK);
+  }
+
+  for(unsigned long i = 0; i < SYNTH_RATE * 10; i += WAV_BLOCK)
+  {
+    uint32_t phase = syn->voice[0].phase;
+
+    synth_render(syn, block, WAV_BLOCK);
+
+    for(int k = 0; k < WAV_BLOCK; k++, t++)
+    {
+      int y = (int)block[k] - SYNTH_DAC_MID;
+      double e = y - amp * sin(2.0 * 3.14159265358979323846 * phase / 4294967296.0);
+
+      err += e;
+      err_sq += e * e;
+      phase += syn->voice[0].inc;
+
+      if(prev < 0 && y >= 0)
+      {
+        // interpolated crossing time
+        double at = t - 1 + (double)-prev / (y - prev);
+
+        if(first < 0)
+        {
+          first = at;
+        }
+        else
+        {
+          crossings++;
+        }
+
+        last = at;
+      }
+
+      prev = y;
+    }
+  }
+
+  // the mix truncates, which only offsets the output: DC is not noise
+  *snr = 20.0 * log10(amp / sqrt(2.0) / sqrt(err_sq / t - (err / t) * (err / t)));
+
+  return crossings * (double)SYNTH_RATE / (last - first);
+}
+
+/* Largest step between samples of a held C4 over `blocks` blocks, from
+ * `shape`, switching to the other of sine and triangle every 5 blocks if
+ * `toggle`. */
+static int max_step(synth_t * syn, uint8_t shape, int toggle, int blocks)
+{
+  uint16_t block[WAV_BLOCK];
+  int prev = -1, step = 0;
+
+  synth_init(syn);
+  synth_set_shape(syn, shape);
+  synth_note_on(syn, 60, 255, 0);
+
+  // let the level settle first
+  for(int b = 0; b < 16; b++)
+  {
+    synth_render(syn, block, WAV_BLOCK);
+  }
+
+  for(int b = 0; b < blocks; b++)
+  {
+    if(toggle && b % 5 == 4)
+    {
+      shape = (shape == SYNTH_SINE) ? SYNTH_TRIANGLE : SYNTH_SINE;
+      synth_set_shape(syn, shape);
+    }
+
+    synth_render(syn, block, WAV_BLOCK);
+
+    for(int k = 0; k < WAV_BLOCK; k++)
+    {
+      if(prev >= 0 && abs(block[k] - prev) > step)
+      {
+        step = abs(block[k] - prev);
+      }
+
+      prev = block[k];
+    }
+  }
+
+  return step;
+}
+
+/* Times rendering with `voices` voices sounding, per sample. */
+static void bench(synth_t * syn, int voices, double * ns, double * cycles)
+{
+  static uint16_t block[WAV_BLOCK];
+  double best_ns = 1e30, best_cyc = 1e30;
+
+  for(int pass = 0; pass < 3; pass++)
+  {
+    synth_init(syn);
+
+    for(int v = 0; v < voices; v++)
+    {
+      synth_note_on(syn, (uint8_t)(57 + 5 * v), 255, 0);
+    }
+
+    // past the attack, so the timed blocks are all held notes
+    for(int b = 0; b < 8; b++)
+    {
+      synth_render(syn, block, WAV_BLOCK);
+    }
+
+    double t = now_s();
+    uint64_t c = now_cycles();
+
+    for(int b = 0; b < BENCH_BLOCKS; b++)
+    {
+      synth_render(syn, block, WAV_BLOCK);
+    }
+
+    c = now_cycles() - c;
+    t = now_s() - t;
+
+    if(t < best_ns)
+    {
+      best_ns = t;
+      best_cyc = (double)c;
+    }
+  }
+
+  *ns = best_ns * 1e9 / ((double)BENCH_BLOCKS * WAV_BLOCK);
+  *cycles = best_cyc / ((double)BENCH_BLOCKS * WAV_BLOCK);
+}
+
+int main(int argc, char ** argv)
+{
+  const char * path = argc > 1 ? argv[1] : "synth.wav";
+  static synth_t syn;
+  FILE * f = fopen(path, "wb");
+
+  if(!f)
+  {
+    perror(path);
+    return 1;
+  }
+
+  // count the samples first, for the header
+  unsigned long n = piece(&syn, NULL);
+
+  wav_header(f, n);
+  piece(&syn, f);
+  fclose(f);
+
+  printf("%s: %lu samples, %.1f s at %lu Hz, %d voices\n", path, n,
+         (double)n / SYNTH_RATE, (unsigned long)SYNTH_RATE, SYNTH_VOICES);
+
+  unsigned long ticks = 0;
+
+  for(unsigned i = 0; i < sizeof(wav_song) / sizeof(wav_song[0]); i++)
+  {
+    ticks += wav_song[i].length + wav_song[i].rest;
+  }
+
+  int timed = wav_song_ticks == ticks;
+
+  printf("song took %lu ticks of %lu (%s)\n", wav_song_ticks, ticks, timed ? "ok" : "WRONG");
+
+  int kept = key_kept(&syn);
+
+  printf("key held on the song's note %s\n", kept ? "kept sounding (ok)" : "CUT SHORT");
+  timed &= kept;
+
+  int quietest = quietest_stolen(&syn);
+
+  printf("note struck over %d releasing voices %s\n", SYNTH_VOICES,
+         quietest ? "took the quietest (ok)" : "TOOK A LOUDER ONE");
+  timed &= quietest;
+
+  double snr;
+  double hz = measure_a4(&syn, &snr);
+  int ok = timed && hz > 439.9 && hz < 440.1 && snr >= WAV_MIN_SNR;
+
+  printf("A4 measures %.4f Hz, SNR %.1f dB (%s)\n", hz, snr, ok ? "ok" : "WRONG");
+
+  int steady = max_step(&syn, SYNTH_SINE, 0, 200);
+  int tri = max_step(&syn, SYNTH_TRIANGLE, 0, 200);
+  int switching = max_step(&syn, SYNTH_SINE, 1, 200);
+  int clean = switching <= WAV_MAX_STEP * (steady > tri ? steady : tri);
+
+  printf("C4 largest step %d sine, %d triangle, %d switching (%s)\n",
+         steady, tri, switching, clean ? "ok" : "CLICKS");
+  ok &= clean;
+
+  // every voice ramping and crossfading through a whole block
+  synth_init(&syn);
+
+  for(int v = 0; v < SYNTH_VOICES; v++)
+  {
+    synth_note_on(&syn, (uint8_t)(57 + 5 * v), 255, 0);
+  }
+
+  synth_set_shape(&syn, SYNTH_SQUARE);
+
+  double avr_max = avr_cycles(&syn, WAV_BLOCK) / (double)WAV_BLOCK;
+
+  // hand estimates, for information only
+  printf("AVR estimate, of %lu cycles/sample: piece %.0f (%.0f%%), all voices crossfading %.0f (%.0f%%)%s\n",
+         (unsigned long)AVR_BUDGET, wav_avr_worst, 100.0 * wav_avr_worst / AVR_BUDGET,
+         avr_max, 100.0 * avr_max / AVR_BUDGET, avr_max > AVR_BUDGET ? ", over budget" : "");
+
+  double ns0, cyc0;
+
+  bench(&syn, 0, &ns0, &cyc0);
+  printf("voices  ns/sample  cycles/sample  cycles/sample/voice  AVR cycles/sample (est.)\n");
+
+  for(int v = 0; v <= SYNTH_VOICES; v++)
+  {
+    double ns, cyc;
+    double avr = AVR_CYC_SAMPLE + (AVR_CYC_BLOCK + v * (AVR_CYC_VOICE_BLOCK + AVR_CYC_VOICE * WAV_BLOCK)) /
+                 (double)WAV_BLOCK;
+
+    bench(&syn, v, &ns, &cyc);
+
+#ifdef SYNTH_TSC
+    printf("%6d  %9.2f  %13.1f  %19.1f  %24.0f\n", v, ns, cyc, v ? (cyc - cyc0) / v : 0.0, avr);
+#else
+    printf("%6d  %9.2f  %13s  %19s  %24.0f\n", v, ns, "-", "-", avr);
+#endif
+  }
+
+  return ok ? 0 : 1;
+}
+
+/***************************END OF FUNCTION DEFINITIONS************************/
@@ -0,0 +1,183 @@
+/*------------------------------------------------------------------------------
+  wavegen.c --
+
+  Description:
+    Generates the synthesizer's wavetable bank, `synth_waves` (see
+    `synth.h`), as C source on stdout; the output is kept in the tree as
+    IMU_SPI_USART/synth_waves.c and must be made again whenever SYNTH_RATE
+    or the bank layout in `synth.h` changes (the file checks the rate).
+
+      Every table but the sine is summed from sine harmonics, each shape
+    with its Fourier series:
+
+      triangle  odd k, alternating, 1 / k^2
+      saw       every k, 1 / k (falling ramp)
+      square    odd k, 1 / k
+
+    up to the highest harmonic the top note of the table's octave has
+    below SYNTH_RATE / 2, and at most SYNTH_WAVE_LEN / 2 - 1 of them. All
+    bands of a shape are scaled by one factor, so that the largest peak
+    (the Gibbs overshoot of the fullest band) is SYNTH_WAVE_PEAK and a
+    shape's loudness does not step between octaves.
+
+    Build and run (from this directory):
+      cc -O2 -std=c99 -I../../IMU_SPI_USART wavegen.c -o wavegen -lm
+      ./wavegen > ../../IMU_SPI_USART/synth_waves.c
+
+------------------------------------------------------------------------------*/
+
+/********************************DEPENDENCIES**********************************/
+
+#include <math.h>
+#include <stdio.h>
+#include "synth.h"
+
+/*****************************END OF DEPENDENCIES******************************/
+
+
+/***********************************MACROS*************************************/
+
+#define WAVEGEN_PI      3.14159265358979323846
+
+/********************************END OF MACROS*********************************/
+
+
+/*****************************FUNCTION DEFINITIONS*****************************/
+
+/* Frequency of a (MIDI) note. */
+static double note_hz(int note)
+{
+  return 440.0 * pow(2.0, (note - 69) / 12.0);
+}
+
+/* Harmonics a table for notes up to `top` can hold. */
+static int harmonics(int top)
+{
+  int k = (int)(SYNTH_RATE / 2 / note_hz(top));
+
+  return k < SYNTH_WAVE_LEN / 2 - 1 ? k : SYNTH_WAVE_LEN / 2 - 1;
+}
+
+/* Amplitude of harmonic `k` of `shape`. */
+static double amplitude(int shape, int k)
+{
+  switch(shape)
+  {
+    case SYNTH_TRIANGLE:
+      return (k & 1) ? (((k - 1) / 2) & 1 ? -1.0 : 1.0) / ((double)k * k) : 0.0;
+
+    case SYNTH_SAW:
+      return 1.0 / k;
+
+    case SYNTH_SQUARE:
+      return (k & 1) ? 1.0 / k : 0.0;
+  }
+
+  return k == 1 ? 1.0 : 0.0;
+}
+
+static void table(int shape, int nh, double * w)
+{
+  for(int i = 0; i < SYNTH_WAVE_LEN; i++)
+  {
+    double x = 2.0 * WAVEGEN_PI * i / SYNTH_WAVE_LEN;
+
+    w[i] = 0;
+
+    for(int k = 1; k <= nh; k++)
+    {
+      w[i] += amplitude(shape, k) * sin(k * x);
+    }
+  }
+}
+
+static void print_table(const double * w, double scale, const char * what)
+{
+  printf("    // %s\n    {\n", what);
+
+  for(int i = 0; i < SYNTH_WAVE_LEN; i++)
+  {
+    long v = lround(w[i] * scale);
+
+    printf("%s%ld%s", i % 16 ? " " : "        ", v,
+           i == SYNTH_WAVE_LEN - 1 ? "\n" : (i % 16 == 15 ? ",\n" : ","));
+  }
+
+  printf("    }");
+}
+
+int main(void)
+{
+  static const char * names[SYNTH_SHAPES] = {"sine", "triangle", "saw", "square"};
+  static double w[SYNTH_BANDS][SYNTH_WAVE_LEN];
+
+  printf("/*------------------------------------------------------------------------------\n"
+         "  synth_waves.c --\n"
+         "\n"
+         "  Description:\n"
+         "    Wavetable bank of the DDS engine, see `synth.h`. Generated by\n"
+         "    host/synth_sim/wavegen.c for a SYNTH_RATE of %lu Hz; do not edit.\n"
+         "\n"
+         "------------------------------------------------------------------------------*/\n"
+         "\n"
+         "/********************************DEPENDENCIES**********************************/\n"
+         "\n"
+         "#include <stdint.h>\n"
+         "#include \"synth.h\"\n"
+         "\n"
+         "/*****************************END OF DEPENDENCIES******************************/\n"
+         "\n"
+         "\n"
+         "/***********************************MACROS*************************************/\n"
+         "\n"
+         "#if SYNTH_RATE != %luUL || SYNTH_WAVE_LEN != %d || SYNTH_WAVES != %d\n"
+         "#error \"synth_waves.c is for another SYNTH_RATE or bank, run wavegen again\"\n"
+         "#endif\n"
+         "\n"
+         "/********************************END OF MACROS*********************************/\n"
+         "\n"
+         "\n"
+         "/******************************GLOBAL VARIABLES********************************/\n"
+         "\n"
+         "const int16_t synth_waves[SYNTH_WAVES][SYNTH_WAVE_LEN] SYNTH_FLASH =\n"
+         "{\n",
+         (unsigned long)SYNTH_RATE, (unsigned long)SYNTH_RATE, SYNTH_WAVE_LEN, SYNTH_WAVES);
+
+  table(SYNTH_SINE, 1, w[0]);
+  print_table(w[0], SYNTH_WAVE_PEAK, "sine");
+
+  for(int shape = 1; shape < SYNTH_SHAPES; shape++)
+  {
+    double peak = 0;
+
+    for(int b = 0; b < SYNTH_BANDS; b++)
+    {
+      table(shape, harmonics(12 * (b + SYNTH_BAND_FIRST) + 11), w[b]);
+
+      for(int i = 0; i < SYNTH_WAVE_LEN; i++)
+      {
+        peak = fabs(w[b][i]) > peak ? fabs(w[b][i]) : peak;
+      }
+    }
+
+    for(int b = 0; b < SYNTH_BANDS; b++)
+    {
+      int first = b ? 12 * (b + SYNTH_BAND_FIRST) : 0;
+      int last = 12 * (b + SYNTH_BAND_FIRST) + 11;
+      char what[80];
+
+      snprintf(what, sizeof(what), "%s, notes %d to %d, %d harmonics",
+               names[shape], first, last, harmonics(last));
+      printf(",\n");
+      print_table(w[b], SYNTH_WAVE_PEAK / peak, what);
+    }
+  }
+
+  printf("\n};\n"
+         "\n"
+         "/***************************END OF GLOBAL VARIABLES****************************/\n");
+
+  return 0;
+}
+
+/***************************END OF FUNCTION DEFINITIONS************************/